@@ -8,6 +8,5 @@ class Axis : public GameObject
 public:
 	Axis(float);
 	Axis(float,glm::vec3&);
-	void virtual draw(const glm::mat4&, const glm::mat4&) override;
 private:
 };
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "Shader.h"
 #include "Texture2D.h"
+#include "ObjectPool.h"
 
 #include <string>
 #include <map>
@@ -10,14 +11,21 @@ class Material {
 public:
     // Takes a pointer to a Shader from ResourceManager
     Material(Shader* shader); 
+
+    // allocated from an ObjectPool (see GameObject)
+    static void* operator new(size_t size) { return getPool().allocate(size); };
+    static void operator delete(void* object, size_t size) { getPool().deallocate(object, size); };
+    static ObjectPool& getPool();
     // For different texture types (diffuse, specular)
     void addTexture(const std::string& name, Texture2D* texture); 
+    const std::map<std::string, Texture2D*>& getTextures() const { return m_textures; };
     // For uniform colors/vectors
     void setVec3(const std::string& name, const glm::vec3& value); 
     // ... more uniform setters (glUniform)
 
     // Activates the shader and binds textures/sets uniforms
     Shader& use() const;
+    Shader* getShader() const { return m_shader; };
 
 private:
     Shader* m_shader;
@@ -8,6 +8,8 @@
 #include <vector>
 
 #include "Logger.h"
+#include "GpuBufferArena.h"
+#include "ObjectPool.h"
 
 struct Vertex {
     Vertex(){};
@@ -24,30 +26,56 @@ struct Vertex {
     // can have more attributes as needed (e.g., Tangent, Bitangent, BoneIDs, Weights)
 };
 
+// owns a range of the GpuBufferArenas' buffers, so a Mesh can be moved but not copied
 class Mesh {
 public:
     Mesh();
     Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices = {});
-    ~Mesh();
 
-    // Unbinds/Binds the VAO
+    // allocated from an ObjectPool (see GameObject)
+    static void* operator new(size_t size) { return getPool().allocate(size); };
+    static void operator delete(void* object, size_t size) { getPool().deallocate(object, size); };
+    static ObjectPool& getPool();
+
+    // Unbinds/Binds the VAO (the arena's, shared with the other meshes in it)
     void bind() const; 
     void unbind() const;
 
-    // clears the VAO , VBO and EBO (if any) from GPU memory
+    // gives the mesh's vertices and indices back to their arena
     void freeResources();
 
-    // Calls glDrawElements or glDrawArrays
+    // Calls glDrawElementsBaseVertex or glDrawArrays
     void draw(bool drawTriangles = true) const; 
+    // the same without a Mesh and with the VAO already bound, for Scene::drawMeshes and the render thread
+    // which only gets the offsets (see RenderThread), they bind a VAO once for all draws from the same arena
+    // unlike draw it doesn't report to the RenderStats, whoever records the draw does that
+    static void drawRange(unsigned int count, bool indexed, unsigned int firstIndex, int baseVertex, bool drawTriangles);
+
+    unsigned int getVertexArray() const { return m_allocation.range().vertexArray; };
+    // where the mesh starts in its arena, changes when the arena is compacted so read it for every draw
+    unsigned int getFirstIndex() const { return m_allocation.range().firstIndex; };
+    int getBaseVertex() const { return (int)m_allocation.range().firstVertex; };
+    bool isIndexed() const { return m_isIndexed; };
+    // indices when indexed, vertices otherwise
+    size_t getDrawCount() const { return m_isIndexed ? m_indexCount : m_vertexCount; };
 
     // For dynamic data (e.g., particles, or deforming meshes)
     void updateVertices(const std::vector<Vertex>& newVertices);
 
+    // axis aligned box around all vertex positions (in the mesh's own space)
+    const glm::vec3& getBoundsMin() const { return m_boundsMin; };
+    const glm::vec3& getBoundsMax() const { return m_boundsMax; };
+
 private:
-    unsigned int m_VAO_ID, m_VBO_ID, m_EBO_ID; // OpenGL IDs
-    size_t m_indexCount;
-    bool m_isIndexed;
-    size_t m_vertexCount;
+    // the arena tracks its buffers' size (MemoryTracker), not every mesh
+    GpuMeshAllocation m_allocation;
+    size_t m_indexCount = 0;
+    bool m_isIndexed = false;
+    size_t m_vertexCount = 0;
+    glm::vec3 m_boundsMin = glm::vec3(0.0f);
+    glm::vec3 m_boundsMax = glm::vec3(0.0f);
 
+    void computeBounds(const std::vector<Vertex>& vertices);
+    // copies the data into the mesh's range (on the thread that owns the context)
     void setupMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
 };
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <map>
+#include <unordered_map>
 #include <string>
 
 #include "glad/glad.h"
@@ -8,31 +9,46 @@
 #include "Texture2D.h"
 #include "Shader.h"
 #include "Logger.h"
+#include "HandlePool.h"
 
 
 #include <iostream>
 #include <sstream>
 #include <fstream>
 
+using ShaderHandle = Handle<Shader>;
+using TextureHandle = Handle<Texture2D>;
+
 // A static singleton ResourceManager class that hosts several
 // functions to load Textures and Shaders. Each loaded texture
-// and/or shader is also stored for future reference by string
-// handles. All functions and resources are static and no 
-// public constructor is defined.
+// and/or shader is stored in a HandlePool and referenced by a
+// generational handle, the string names are only used to find
+// a handle while loading. All functions and resources are static
+// and no public constructor is defined.
 class ResourceManager
 {
 public:
     // resource storage
-    static std::map<std::string, Shader>    Shaders;
-    static std::map<std::string, Texture2D> Textures;
+    static HandlePool<Shader>    Shaders;
+    static HandlePool<Texture2D> Textures;
+    // id -> handle, see FindShader/FindTexture
+    static std::unordered_map<StringID, ShaderHandle>  ShaderIds;
+    static std::unordered_map<StringID, TextureHandle> TextureIds;
+    // name -> handle, only for the UI lists (ordered by name)
+    static std::map<std::string, ShaderHandle>  ShaderNames;
+    static std::map<std::string, TextureHandle> TextureNames;
     // loads (and generates) a shader program from file loading vertex, fragment (and geometry) shader's source code. If gShaderFile is not nullptr, it also loads a geometry shader
-    static Shader LoadShader(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile, std::string name);
-    // retrieves a stored sader
-    static Shader* GetShader(std::string name);
+    // loading a name that already exists replaces that shader in place, its handle (and any Shader*) stays valid
+    static ShaderHandle LoadShader(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile, std::string name);
+    // retrieves a stored shader, nullptr for a stale handle
+    static Shader* GetShader(ShaderHandle handle) { return Shaders.get(handle); };
+    // the handle of a loaded shader (an invalid handle when there is none), meant for load time not per frame
+    static ShaderHandle FindShader(StringID name);
     // loads (and generates) a texture from file
-    static Texture2D LoadTexture(const char* file, bool alpha, std::string name);
-    // retrieves a stored texture
-    static Texture2D* GetTexture(std::string name);
+    static TextureHandle LoadTexture(const char* file, bool alpha, std::string name);
+    // retrieves a stored texture, nullptr for a stale handle
+    static Texture2D* GetTexture(TextureHandle handle) { return Textures.get(handle); };
+    static TextureHandle FindTexture(StringID name);
     // return a array of strings
     static std::vector<std::string> showResources();
     // properly de-allocates all loaded resources
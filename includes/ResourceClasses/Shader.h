@@ -2,22 +2,31 @@
 
 
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "glad/glad.h"
 #include "glm/glm.hpp"
 #include "glm/gtc/type_ptr.hpp"
 
 #include "Logger.h"
+#include "StringID.h"
+#include "GLObject.h"
+#include "MemoryTracker.h"
 
 
 // General purpose shader object. Compiles from file, generates
 // compile/link-time error messages and hosts several utility 
 // functions for easy management.
+// It owns its program, so it can be moved but not copied.
 class Shader
 {
 public:
     // state
-    unsigned int ID;
+    GLProgram m_program;
+    GLuint getID() const { return m_program.get(); };
+    // the size of the linked program (MemoryTracker), labeled with its name by the ResourceManager
+    TrackedMemory m_memory;
     std::string m_vShaderFile;
     std::string m_fShaderFile;
     std::string m_gShaderFile;
@@ -27,16 +36,16 @@ public:
     Shader& Use();
     // compiles the shader from given source code
     void    Compile(const char* vertexSource, const char* fragmentSource, const char* geometrySource = nullptr); // note: geometry source code is optional 
-    // utility functions
-    void    SetFloat(const char* name, float value, bool useShader = false);
-    void    SetInteger(const char* name, int value, bool useShader = false);
-    void    SetVector2f(const char* name, float x, float y, bool useShader = false);
-    void    SetVector2f(const char* name, const glm::vec2& value, bool useShader = false);
-    void    SetVector3f(const char* name, float x, float y, float z, bool useShader = false);
-    void    SetVector3f(const char* name, const glm::vec3& value, bool useShader = false);
-    void    SetVector4f(const char* name, float x, float y, float z, float w, bool useShader = false);
-    void    SetVector4f(const char* name, const glm::vec4& value, bool useShader = false);
-    void    SetMatrix4(const char* name, const glm::mat4& matrix, bool useShader = false);
+    // utility functions, the uniform is found by its id ("model"_sid) in the locations cached at link time
+    void    SetFloat(StringID name, float value, bool useShader = false);
+    void    SetInteger(StringID name, int value, bool useShader = false);
+    void    SetVector2f(StringID name, float x, float y, bool useShader = false);
+    void    SetVector2f(StringID name, const glm::vec2& value, bool useShader = false);
+    void    SetVector3f(StringID name, float x, float y, float z, bool useShader = false);
+    void    SetVector3f(StringID name, const glm::vec3& value, bool useShader = false);
+    void    SetVector4f(StringID name, float x, float y, float z, float w, bool useShader = false);
+    void    SetVector4f(StringID name, const glm::vec4& value, bool useShader = false);
+    void    SetMatrix4(StringID name, const glm::mat4& matrix, bool useShader = false);
 
     const char* getFragmentSource();
     const char* getVertexSource();
@@ -45,7 +54,14 @@ public:
     void setVertexSource(const char*);
     void setGeometrySource(const char*);
     void setSources(const char*, const char*, const char*);
+
+    // -1 when the program has no active uniform with that name (like glGetUniformLocation)
+    GLint getUniformLocation(StringID name) const;
 private:
+    // (id, location) of every active uniform sorted by id, arrays are there as "name", "name[0]", "name[1]", ...
+    // so setting a uniform is a binary search over a few integers instead of a glGetUniformLocation string lookup
+    std::vector<std::pair<StringID, GLint>> m_uniformLocations;
+    void    cacheUniformLocations();
     // checks if compilation or linking failed and if so, print the error logs
     void    checkCompileErrors(unsigned int object, std::string type);
 };
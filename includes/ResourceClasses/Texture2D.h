@@ -2,13 +2,23 @@
 
 #include "glad/glad.h"
 
+#include <vector>
+
+#include "GLObject.h"
+#include "MemoryTracker.h"
+
 // Texture2D is able to store and configure a texture in OpenGL.
 // It also hosts utility functions for easy management.
+// It owns its texture object, so it can be moved but not copied.
 class Texture2D
 {
 public:
-    // holds the ID of the texture object, used for all texture operations to reference to this particular texture
-    unsigned int ID;
+    // the texture object, used for all texture operations to reference to this particular texture
+    // (made by Generate, 0 before that)
+    GLTexture m_texture;
+    GLuint getID() const { return m_texture.get(); };
+    // the size of the texture's storage (MemoryTracker), labeled with its name by the ResourceManager
+    TrackedMemory m_memory;
     // texture image dimensions
     unsigned int Width, Height; // width and height of loaded image in pixels
     // texture Format
@@ -19,10 +29,25 @@ public:
     unsigned int Wrap_T; // wrapping mode on T axis
     unsigned int Filter_Min; // filtering mode if texture pixels < screen pixels
     unsigned int Filter_Max; // filtering mode if texture pixels > screen pixels
-    // constructor (sets default texture modes)
+    // mip levels of the full chain, and the most detailed one in GPU memory (see TextureResidency)
+    unsigned int Levels;
+    unsigned int BaseLevel;
+    // its entry in the TextureResidency, -1 for a texture that isn't streamed
+    int ResidencyId;
+    // constructor (sets default texture modes, the texture object itself is only made by Generate)
     Texture2D();
     // generates texture from image data
     void Generate(unsigned int width, unsigned int height, unsigned char* data);
+    // generates a mipmapped texture that only has the levels from "firstLevel" on, levels[0] is "firstLevel"
+    void GenerateLevels(unsigned int width, unsigned int height, unsigned int firstLevel, const std::vector<std::vector<unsigned char>>& levels);
+    // adds the more detailed levels [firstLevel, BaseLevel) and samples from "firstLevel" from now on
+    void UploadLevels(unsigned int firstLevel, const std::vector<std::vector<unsigned char>>& levels);
+    // frees the levels more detailed than "baseLevel"
+    void DropLevels(unsigned int baseLevel);
+    // bytes of one level, and of the levels from BaseLevel on
+    size_t LevelBytes(unsigned int level) const;
+    size_t ResidentBytes() const;
+    static unsigned int LevelCount(unsigned int width, unsigned int height);
     // binds the texture as the current active GL_TEXTURE_2D texture object
     void Bind() const;
 };
\ No newline at end of file
@@ -18,7 +18,12 @@
 
 class BaseUIElement {
 public:
-	virtual ~BaseUIElement() = default;
+	BaseUIElement();
+	virtual ~BaseUIElement();
+	// the id is what events refer to, a copy would share it
+	BaseUIElement(const BaseUIElement&) = delete;
+	BaseUIElement& operator=(const BaseUIElement&) = delete;
+
 	// This method will be overridden by derived classes to draw the specific ImGui widget.
 	// It should return true if the widget's value changed or it was interacted with
 	// (e.g., button clicked, slider moved).
@@ -41,6 +46,14 @@ public:
 		m_handler->execute();
 	};
 
+	// queues a UI_CHANGED event for this element (when it has a handler), the handler runs when the
+	// frame handles its events (see Game::latchInput) instead of in the middle of drawing the UI
+	void notifyChanged();
+
+	uint32_t getId() const { return m_id; };
+	// the element with that id, nullptr when it was destroyed in the meantime
+	static BaseUIElement* find(uint32_t id);
+
 	std::unique_ptr<BaseHandler>& getHandler()
 	{
 		return m_handler;
@@ -48,5 +61,6 @@ public:
 
 private:
 	std::unique_ptr<BaseHandler> m_handler = nullptr;
+	uint32_t m_id;
 	//...
 };
\ No newline at end of file
@@ -13,6 +13,7 @@
 
 #include "UIEvent.h"
 #include "UIEventQueue.h"
+#include "Logger.h"
 
 // while the BaseHandler might redundant someone might come along and expand a new UIHandler for other purposes
 class BaseHandler {
@@ -36,7 +37,7 @@ public:
 
     virtual void execute() override
     {
-        std::cout << "\nexecute Handler\n";
+        LOG_TRACE("UI: execute handler");
         std::apply(m_func, m_args);
     };
 
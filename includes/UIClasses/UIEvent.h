@@ -1,40 +1,97 @@
 #pragma once
 
-// !!! depricated !!!
-#include <string>
-#include <queue>
-#include <mutex> // For thread safety if multi-threading
-#include <functional>
+#include <cstdint>
+#include <cstring>
 
-#include <glm/glm.hpp>
-#include "UIBaseElement.h"
+enum class UIEventType : uint8_t {
+    NONE = 0,
+    // input (GLFW callbacks), x/y are mouse offsets, the scroll offset or the new framebuffer size
+    CAMERA_ORBIT,
+    CAMERA_PAN,
+    CAMERA_ZOOM,
+    WINDOW_RESIZED,
+    KEY,
+    // a UI element changed (button clicked, slider moved, ...), its handler runs when the event is handled
+    UI_CHANGED,
+    // a resource should be loaded again from its files
+    SHADER_RELOAD,
+};
 
-//enum UIEventType {
-//    None = 0, // Indicates no event occurred
-//    // UI-generated events
-//    UIButtonClicked,
-//    UISliderFloatChanged,
-//    UISliderVec2Changed,
-//    UISliderVec3Changed,
-//    UISliderVec4Changed,
-//    UICheckboxChanged,
-//    UISelectChanged,
-//    // Engine-level events triggered by UI interactions (more specific)
-//    ShaderRecompileRequested,
-//    ShaderSelected,
-//    ShaderUniformFloatChanged, // Specific for float uniform updates
-//    ShaderUniformVec3Changed,  // Specific for vec3 uniform updates
-//    GameObjectSelected,
-//    GameObjectPositionChanged,
-//    GameObjectScaleChanged,
-//    GameObjectRotationChanged,
-//    ViewModeChanged,
-//    // ... more game-specific events (e.g., PlayerMoved, EnemyDied)
-//
-//};
-//
-//struct UIEvent {
-//    UIEventType type = UIEventType::None;
-//    BaseUIElement* source;
-//    // data;
-//};
+// a single event, a fixed size value so the queue never allocates
+// only the fields of the event's type mean something
+struct UIEvent {
+    UIEventType type = UIEventType::NONE;
+    // FramePacer::now() when it happened
+    double time = 0.0;
+    union {
+        struct { float x, y; } motion;
+        struct { int key, action; } key;
+        // see BaseUIElement::find, the element may be gone by the time the event is handled
+        uint32_t element;
+        // names longer than this are cut off
+        char name[48];
+    };
+
+    UIEvent() : motion{ 0.0f, 0.0f } {};
+
+    static UIEvent motionEvent(UIEventType type, float x, float y, double time)
+    {
+        UIEvent event;
+        event.type = type;
+        event.time = time;
+        event.motion = { x, y };
+        return event;
+    };
+    static UIEvent keyEvent(int key, int action, double time)
+    {
+        UIEvent event;
+        event.type = UIEventType::KEY;
+        event.time = time;
+        event.key = { key, action };
+        return event;
+    };
+    static UIEvent uiChanged(uint32_t element, double time)
+    {
+        UIEvent event;
+        event.type = UIEventType::UI_CHANGED;
+        event.time = time;
+        event.element = element;
+        return event;
+    };
+    static UIEvent shaderReload(const char* shaderName, double time)
+    {
+        UIEvent event;
+        event.type = UIEventType::SHADER_RELOAD;
+        event.time = time;
+        std::strncpy(event.name, shaderName, sizeof(event.name) - 1);
+        event.name[sizeof(event.name) - 1] = '\0';
+        return event;
+    };
+
+    // merges "next" into this event when handling both would do the same work twice
+    // (mouse moves and scrolls add up, a resize only needs the last size, a slider only needs its last value)
+    // the time stays the one of the oldest event
+    bool coalesce(const UIEvent& next)
+    {
+        if (next.type != type)
+            return false;
+        switch (type)
+        {
+        case UIEventType::CAMERA_ORBIT:
+        case UIEventType::CAMERA_PAN:
+        case UIEventType::CAMERA_ZOOM:
+            motion.x += next.motion.x;
+            motion.y += next.motion.y;
+            return true;
+        case UIEventType::WINDOW_RESIZED:
+            motion = next.motion;
+            return true;
+        case UIEventType::UI_CHANGED:
+            return element == next.element;
+        case UIEventType::SHADER_RELOAD:
+            return std::strcmp(name, next.name) == 0;
+        default:
+            return false;
+        }
+    };
+};
@@ -1,23 +1,74 @@
 #pragma once
 
-// !!! depricated !!!
-
-
-#include <queue>
-#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 
 #include "UIEvent.h"
 
-//class UIEventQueue {
-//public:
-//    static UIEventQueue& GetInstance();
-//    void Push(const UIEvent& event);
-//    bool Pop(UIEvent& event);
-//    bool IsEmpty();
-//    void Clear();
+// a bounded lock-free queue of UIEvents, any thread may push, one thread (the main thread) drains it
+// -----------------------------------------------------------------------------------------------
+// every slot has a sequence number that says whose turn it is: a producer claims a position with a
+// compare-and-swap on the tail and publishes the slot by bumping its sequence, the consumer only reads
+// slots whose sequence says they were published (Dmitry Vyukov's bounded queue with a single consumer)
+// https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
 //
-//private:
-//    UIEventQueue() = default;
-//    std::queue<UIEvent> m_queue;
-//    std::mutex m_mutex; 
-//};
\ No newline at end of file
+// the slots are a fixed array, a full queue drops the event (and counts it) instead of growing
+// drain() hands out the events once per frame and merges runs of the same event (see UIEvent::coalesce)
+class UIEventQueue {
+public:
+    static UIEventQueue& getInstance();
+
+    static constexpr size_t CAPACITY = 1024;
+
+    // false when the queue was full, the event is lost then
+    bool push(const UIEvent& event);
+    // calls handle(const UIEvent&) for every queued event in order, neighbouring events that
+    // coalesce are handed out as one, returns how many events were taken out of the queue
+    template<typename Handler>
+    size_t drain(Handler&& handle)
+    {
+        UIEvent pending;
+        UIEvent event;
+        bool hasPending = false;
+        size_t count = 0;
+        while (pop(event))
+        {
+            count++;
+            if (hasPending && pending.coalesce(event))
+            {
+                m_coalesced.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            if (hasPending)
+                handle(pending);
+            pending = event;
+            hasPending = true;
+        }
+        if (hasPending)
+            handle(pending);
+        return count;
+    };
+
+    uint64_t getDropped() const { return m_dropped.load(std::memory_order_relaxed); };
+    uint64_t getCoalesced() const { return m_coalesced.load(std::memory_order_relaxed); };
+
+private:
+    UIEventQueue();
+    UIEventQueue(const UIEventQueue&) = delete;
+    UIEventQueue& operator=(const UIEventQueue&) = delete;
+    // consumer only
+    bool pop(UIEvent& event);
+
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "the capacity has to be a power of 2");
+    struct Slot {
+        std::atomic<uint32_t> sequence;
+        UIEvent event;
+    };
+    Slot m_slots[CAPACITY];
+    // producers and the consumer on their own cache lines
+    alignas(64) std::atomic<uint32_t> m_tail{ 0 };
+    alignas(64) uint32_t m_head = 0;
+    alignas(64) std::atomic<uint64_t> m_dropped{ 0 };
+    std::atomic<uint64_t> m_coalesced{ 0 };
+};
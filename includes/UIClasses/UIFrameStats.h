@@ -0,0 +1,14 @@
+#pragma once
+
+#include "UIBaseElement.h"
+#include "FramePacer.h"
+
+// shows what a FramePacer measured: frame time, fps, jitter, how long it waited and the stutters
+// plus a graph of the last frames
+class UIFrameStats : public BaseUIElement {
+public:
+    UIFrameStats(const FramePacer*);
+    virtual void render() override;
+private:
+    const FramePacer* m_pacer;
+};
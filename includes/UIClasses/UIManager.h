@@ -1,6 +1,7 @@
 #pragma once
 
 #include <map>
+#include <unordered_map>
 #include <string>
 
 #include "imgui.h"
@@ -14,6 +15,13 @@
 #include "UISliderVec3.h"
 #include "UISelect.h"
 #include "UIPanel.h"
+#include "UIFrameStats.h"
+#include "UIMemoryStats.h"
+#include "UIRenderStats.h"
+#include "HandlePool.h"
+#include "StringID.h"
+
+using SceneHandle = Handle<Scene*>;
 
 enum class UIElementType {
     BUTTON,
@@ -31,10 +39,11 @@ enum class UIElementType {
 
 class UIManager {
 public:
-	// Scene storage
-	static std::map<std::string, Scene*> Scenes;
+	// Scene storage, the scenes themselves are owned by whoever added them
+	static HandlePool<Scene*> Scenes;
+	static std::unordered_map<StringID, SceneHandle> SceneIds;
     // UI storage
-    static std::map<std::string, UIPanel*> Panels;
+    static std::map<StringID, UIPanel*> Panels;
 
     static UIManager& getInstance();
 
@@ -48,7 +57,12 @@ public:
     ~UIManager();
 
 	// renders the current active Scene and UI interface
-	void addScene(Scene*,std::string);
+	// adding a name that already exists replaces that scene and keeps its handle
+	SceneHandle addScene(Scene*,std::string);
+	// nullptr for a stale handle
+	static Scene* getScene(SceneHandle handle) { Scene** scene = Scenes.get(handle); return scene ? *scene : nullptr; };
+	// meant for load time, keep the handle instead of looking a scene up by name every frame
+	static SceneHandle findScene(StringID name);
 	void RenderActiveScenes();
 	
     void StartFrame();
@@ -61,9 +75,15 @@ public:
     void populateShaderInfoPanel(Shader* shader, std::string shaderName);
     void populateGameObjectInfoPanel(GameObject* gameObject, std::string gameObjectName);
     void populateFeaturesPanel(); 
+    // a cap for the frame rate and the pacer's stats (the pacer belongs to the Game)
+    void populateFramePacingPanel(FramePacer* pacer);
+    // what the meshes, textures, programs and pools use against their budgets (see MemoryTracker)
+    void populateMemoryPanel();
+    // the per frame counters of RenderStats and the GPU's pipeline statistics
+    void populateRenderStatsPanel();
 
     void addUIPanel(UIPanel*,std::string);
-    UIPanel* getUIPanel(std::string&);
+    UIPanel* getUIPanel(StringID);
 
     void update(float);
 
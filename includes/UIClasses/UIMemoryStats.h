@@ -0,0 +1,15 @@
+#pragma once
+
+#include "UIBaseElement.h"
+#include "MemoryTracker.h"
+
+// shows what the MemoryTracker counts: every category against its budget, the GPU/CPU totals,
+// the GL objects that are still alive and (when opened) the largest resources
+class UIMemoryStats : public BaseUIElement {
+public:
+    UIMemoryStats();
+    virtual void render() override;
+private:
+    static constexpr int LARGEST = 10;
+    void renderLargest();
+};
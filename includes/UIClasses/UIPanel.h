@@ -3,6 +3,8 @@
 #include <string>
 #include <map>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
@@ -15,6 +17,7 @@
 #include "UISliderVec3.h"
 #include "UISelect.h"
 #include "UILabel.h"
+#include "StringID.h"
 
 class UIPanel : public BaseUIElement {
 public:
@@ -22,17 +25,20 @@ public:
 
     virtual void render() override;
 
+    // adding a name that is already there replaces that element
     BaseUIElement* addUIElement(std::string, std::unique_ptr<BaseUIElement>);
     void clearUIElements();
 
-    UIButton* getButton(std::string&);
-    UISliderFloat* getSliderFloat(std::string&);
-    UISliderVec3* getSliderVec3(std::string&);
-    UISelect* getSelect(std::string&);
-    UILabel* getLabel(std::string&);
+    BaseUIElement* getUIElement(StringID);
+    UIButton* getButton(StringID);
+    UISliderFloat* getSliderFloat(StringID);
+    UISliderVec3* getSliderVec3(StringID);
+    UISelect* getSelect(StringID);
+    UILabel* getLabel(StringID);
 
 private:
-    std::map<std::string, std::unique_ptr<BaseUIElement>> m_UIElements;
+    // in the order they were added, which is also the order they are drawn in
+    std::vector<std::pair<StringID, std::unique_ptr<BaseUIElement>>> m_UIElements;
     std::string m_label;
     bool m_anyChildChanged = false;
 };
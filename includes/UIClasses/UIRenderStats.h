@@ -0,0 +1,12 @@
+#pragma once
+
+#include "UIBaseElement.h"
+#include "RenderStats.h"
+
+// shows the RenderStats counters of the last frame: draws, binds, uniforms, uploads and culled objects,
+// and what the GPU counted itself when the driver has pipeline statistics queries
+class UIRenderStats : public BaseUIElement {
+public:
+    UIRenderStats();
+    virtual void render() override;
+};
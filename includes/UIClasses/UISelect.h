@@ -13,7 +13,7 @@ public:
     
     bool isChanged();
     
-    std::string getSelectedOption();
+    const std::string& getSelectedOption();
     int getSelectedIndex();
     void setSelectedIndex(int);
 
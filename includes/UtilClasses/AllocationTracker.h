@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "FlightRecorder.h"
+
+// heap traffic of one frame (all threads together)
+struct AllocationFrameStats {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    uint64_t frees = 0;
+};
+
+struct AllocationZoneStats {
+    const char* name = nullptr;
+    // during the last finished frame
+    uint64_t frameAllocations = 0;
+    // since tracking was enabled (or the last reset())
+    uint64_t totalAllocations = 0;
+    uint64_t totalBytes = 0;
+};
+
+// one distinct stack that allocated, with the zone it was in
+struct AllocationCallSite {
+    static constexpr int MAX_FRAMES = 16;
+    void* frames[MAX_FRAMES];
+    int depth = 0;
+    const char* zone = nullptr;
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+};
+
+// counts every global operator new/delete, per frame and per zone
+// ---------------------------------------------------------------
+// AllocationTracker.cpp replaces the global operator new and delete, while tracking is off they only
+// check a flag and call malloc/free, so the hooks are always compiled in and enabled with --alloc-check=1
+// a zone is a named scope (PROFILE_ZONE, every TaskGraph task is one), an allocation counts for the zone
+// its thread is in, outside of any zone it counts as "untracked"
+// with setCaptureCallSites(true) every allocation also records its stack, logCallSites() prints them
+// (a steady-state frame should not allocate at all, the stress run checks that with --alloc-check=1)
+class AllocationTracker {
+public:
+    static constexpr uint16_t NO_ZONE = 0;
+    static constexpr size_t MAX_ZONES = 64;
+    static constexpr size_t MAX_CALL_SITES = 512;
+
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+    static void setCaptureCallSites(bool capture);
+
+    // the same name returns the same id, names are copied (up to 31 characters)
+    static uint16_t registerZone(const char* name);
+    // makes "zone" the calling thread's zone and returns the one it replaced
+    static uint16_t enterZone(uint16_t zone);
+    static void leaveZone(uint16_t previous);
+    // the zone the calling thread is in, "untracked" outside of any
+    static const char* currentZoneName();
+
+    // at the start and the end of Game::Frame
+    static void beginFrame();
+    static AllocationFrameStats endFrame();
+    static const AllocationFrameStats& lastFrame();
+
+    static void forEachZone(const std::function<void(const AllocationZoneStats&)>& function);
+    static void forEachCallSite(const std::function<void(const AllocationCallSite&)>& function);
+    // the "maxSites" stacks that allocated the most, with symbols where the platform has them
+    static void logCallSites(size_t maxSites);
+    // forgets the call sites and the zone totals
+    static void reset();
+
+    // called by the global operator new/delete only
+    static void recordAllocation(size_t bytes);
+    static void recordFree();
+
+private:
+    AllocationTracker() {};
+};
+
+// the allocations of the enclosing scope count for "zone", how long it took goes into the FlightRecorder
+class ProfileZone {
+public:
+    explicit ProfileZone(uint16_t zone) : m_previous(AllocationTracker::enterZone(zone)), m_start(FlightRecorder::now()) {};
+    ~ProfileZone()
+    {
+        FlightRecorder::recordZone(AllocationTracker::currentZoneName(), m_start);
+        AllocationTracker::leaveZone(m_previous);
+    };
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    uint16_t m_previous;
+    uint64_t m_start;
+};
+
+#define PROFILE_ZONE_CONCAT_INNER(a, b) a##b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT_INNER(a, b)
+// PROFILE_ZONE("present"); the name is registered once, entering the zone is a thread_local write
+#define PROFILE_ZONE(name) \
+    static const uint16_t PROFILE_ZONE_CONCAT(profileZoneId_, __LINE__) = AllocationTracker::registerZone(name); \
+    ProfileZone PROFILE_ZONE_CONCAT(profileZone_, __LINE__)(PROFILE_ZONE_CONCAT(profileZoneId_, __LINE__))
@@ -23,8 +23,12 @@ public:
 	void processPan(float, float);
 	void processOrbit(float, float);
 	void processZoom(float);
+	// places the camera at a position looking at a target (used by scripted camera paths)
+	void lookAt(const glm::vec3&, const glm::vec3&);
 
 	void updateProjection(float, float);
+	// the distances of the near and far plane, anything beyond the far plane is clipped
+	void setClipPlanes(float nearPlane, float farPlane);
 	void updateCamera(float, bool*);
 
 private:
@@ -58,4 +62,7 @@ private:
 	float m_orbitSensitivity = 0.8f;
 	float m_zoomSensitivity = 1.5f;
 	float m_distance = 10.0f;
+	float m_aspect = 1.0f;
+	float m_nearPlane = 0.1f;
+	float m_farPlane = 100.0f;
 };
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+
+#include "TransformStorage.h"
+
+class Mesh;
+class Material;
+
+// the components a Scene gives every GameObject (see EntityWorld)
+// they only hold data, the systems in Scene decide what to do with it
+
+// the name the object was added to the scene with
+struct NameComponent {
+    std::string value;
+};
+
+// where the transform lives in the TransformStorage (its matrices are already stored as arrays there)
+struct TransformComponent {
+    TransformId id = INVALID_TRANSFORM;
+};
+
+// what to draw and how, replaces subclasses that only existed to change the draw call
+struct MeshRenderer {
+    Mesh* mesh = nullptr;
+    Material* material = nullptr;
+    // false draws the mesh as lines (e.g. the Axis)
+    bool drawTriangles = true;
+    // the positions of mesh and material in the Scene's tables, the draw list sort keys are made of these
+    uint32_t meshIndex = 0;
+    uint32_t materialIndex = 0;
+};
+
+// world space bounding box, copied from the TransformStorage once per frame
+// so the systems after culling don't have to look up every transform again
+struct BoundsComponent {
+    TransformBounds world;
+    // written by the culling system, false when the box is outside the camera's frustum
+    bool visible = true;
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class Mesh;
+
+// everything the GL thread needs for one draw, packed by a worker while it walks the scene
+// the model matrix is a copy, so replaying never has to look anything up in the TransformStorage
+struct DrawCommand {
+    glm::mat4 model;
+    Mesh* mesh;
+    // index into the Scene's material table (see Scene::updateRenderer)
+    uint32_t materialIndex;
+    bool drawTriangles;
+};
+
+// which command of which list, the order the GL thread replays them in
+struct DrawCommandRef {
+    uint32_t list;
+    uint32_t index;
+};
+
+// the draw commands one thread recorded during a frame
+// ------------------------------------------------------
+// every JobSystem thread fills its own list (no locks while recording), each list is sorted on its own
+// and merge() combines the sorted lists into a single order for the GL thread
+// only the 64 bit keys get sorted, the commands themselves never move
+//
+// sort key (most significant bits first, so sorting the keys groups by state changes):
+//   [63]     primitive    triangles before lines
+//   [47..62] material     one program switch (+ view/projection upload) per material
+//   [31..46] mesh         the same mesh back to back
+//   [7..30]  depth        front to back inside a group, lets the depth test reject hidden fragments early
+class DrawCommandList {
+public:
+    static uint64_t makeSortKey(bool drawTriangles, uint32_t materialIndex, uint32_t meshIndex, float depth);
+
+    void clear();
+    void add(uint64_t sortKey, const DrawCommand& command);
+    // sorts the recorded commands by their key
+    void sort();
+
+    size_t size() const { return m_commands.size(); };
+    const DrawCommand& command(uint32_t index) const { return m_commands[index]; };
+
+    // k-way merge of lists that were sorted with sort(), "order" is overwritten
+    static void merge(const std::vector<DrawCommandList>& lists, std::vector<DrawCommandRef>& order);
+
+private:
+    struct SortEntry {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    std::vector<DrawCommand> m_commands;
+    std::vector<SortEntry> m_sorted;
+};
@@ -0,0 +1,249 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "JobSystem.h"
+
+// an archetype based entity component system (ECS)
+// -------------------------------------------------
+// an entity is only a number, its data lives in components (plain structs)
+// all entities with exactly the same set of components share an "archetype", and an archetype
+// stores its entities in fixed size chunks where every component type has its own array:
+//
+//   archetype {Transform, MeshRenderer}
+//     chunk 0: [ Entity  e0 e1 e2 ... ][ Transform t0 t1 t2 ... ][ MeshRenderer m0 m1 m2 ... ]
+//     chunk 1: ...
+//
+// a system that needs Transform and MeshRenderer walks those arrays from front to back,
+// no pointer chasing and no virtual calls, so the CPU can prefetch everything it needs
+// https://github.com/SanderMertens/ecs-faq#what-is-an-archetype
+
+// a handle to an entity, the generation tells a destroyed entity apart from a new one reusing its index
+struct Entity {
+    uint32_t index = 0xFFFFFFFF;
+    uint32_t generation = 0;
+
+    bool valid() const { return index != 0xFFFFFFFF; };
+    bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; };
+    bool operator!=(const Entity& other) const { return !(*this == other); };
+};
+
+// one bit per component type, so at most 64 different component types
+using ComponentMask = uint64_t;
+
+// what the archetypes need to know to store a component type without knowing the type itself
+struct ComponentInfo {
+    size_t size;
+    size_t alignment;
+    void (*construct)(void* destination);
+    void (*destruct)(void* component);
+    void (*moveConstruct)(void* destination, void* source);
+};
+
+class ComponentRegistry {
+public:
+    // every component type gets a number the first time it is used
+    template<typename T>
+    static uint32_t id()
+    {
+        static const uint32_t typeId = add(ComponentInfo{
+            sizeof(T),
+            alignof(T),
+            [](void* destination) { new (destination) T(); },
+            [](void* component) { static_cast<T*>(component)->~T(); },
+            [](void* destination, void* source) { new (destination) T(std::move(*static_cast<T*>(source))); },
+        });
+        return typeId;
+    };
+
+    template<typename T>
+    static ComponentMask mask() { return ComponentMask(1) << id<T>(); };
+
+    static const ComponentInfo& info(uint32_t typeId);
+
+private:
+    static uint32_t add(const ComponentInfo&);
+};
+
+class Archetype {
+public:
+    // 16KB per chunk fits comfortably in the L1/L2 cache while walking it
+    static constexpr size_t CHUNK_BYTES = 16 * 1024;
+
+    struct Chunk {
+        std::byte* data = nullptr;
+        uint32_t count = 0;
+    };
+
+    explicit Archetype(ComponentMask);
+    ~Archetype();
+    Archetype(const Archetype&) = delete;
+    Archetype& operator=(const Archetype&) = delete;
+
+    ComponentMask mask() const { return m_mask; };
+    bool has(uint32_t typeId) const { return (m_mask >> typeId) & 1; };
+    uint32_t chunkCapacity() const { return m_chunkCapacity; };
+    std::vector<Chunk>& chunks() { return m_chunks; };
+
+    Entity* entities(const Chunk& chunk) const { return reinterpret_cast<Entity*>(chunk.data); };
+    void* component(const Chunk& chunk, uint32_t typeId, uint32_t row) const;
+    template<typename T>
+    T* components(const Chunk& chunk) const { return reinterpret_cast<T*>(chunk.data + m_offsets[ComponentRegistry::id<T>()]); };
+
+    // appends an entity with default constructed components, returns its chunk and row
+    std::pair<uint32_t, uint32_t> allocate(Entity);
+    // removes a row by moving the very last entity of the archetype into it (so only the last chunk is ever partly empty)
+    // destructComponents is false when the components were already moved somewhere else
+    // returns the entity that was moved into the row (invalid if none)
+    Entity remove(uint32_t chunk, uint32_t row, bool destructComponents);
+
+private:
+    ComponentMask m_mask;
+    std::vector<uint32_t> m_types;
+    // byte offset of every component array inside a chunk, indexed by component id
+    size_t m_offsets[64] = {};
+    uint32_t m_chunkCapacity = 0;
+    size_t m_chunkBytes = CHUNK_BYTES;
+    std::vector<Chunk> m_chunks;
+};
+
+class EntityWorld {
+public:
+    EntityWorld() {};
+    EntityWorld(const EntityWorld&) = delete;
+    EntityWorld& operator=(const EntityWorld&) = delete;
+
+    // an entity with the given components (placed directly in the right archetype)
+    template<typename... Components>
+    Entity create(Components&&... components)
+    {
+        ComponentMask mask = (ComponentMask(0) | ... | ComponentRegistry::mask<std::decay_t<Components>>());
+        Entity entity = allocateEntity(archetypeFor(mask));
+        ((*get<std::decay_t<Components>>(entity) = std::forward<Components>(components)), ...);
+        return entity;
+    };
+    void destroy(Entity);
+    bool alive(Entity) const;
+
+    template<typename T>
+    T* get(Entity entity)
+    {
+        if (!alive(entity))
+            return nullptr;
+        const Record& record = m_records[entity.index];
+        uint32_t typeId = ComponentRegistry::id<T>();
+        if (!record.archetype->has(typeId))
+            return nullptr;
+        return static_cast<T*>(record.archetype->component(record.archetype->chunks()[record.chunk], typeId, record.row));
+    };
+
+    template<typename T>
+    bool has(Entity entity) const { return alive(entity) && m_records[entity.index].archetype->has(ComponentRegistry::id<T>()); };
+
+    // moves the entity to the archetype that also has T
+    template<typename T>
+    T& add(Entity entity, T value = T())
+    {
+        if (!has<T>(entity))
+        {
+            changeArchetype(entity, m_records[entity.index].archetype->mask() | ComponentRegistry::mask<T>());
+        }
+        T* component = get<T>(entity);
+        *component = std::move(value);
+        return *component;
+    };
+
+    template<typename T>
+    void remove(Entity entity)
+    {
+        if (has<T>(entity))
+        {
+            changeArchetype(entity, m_records[entity.index].archetype->mask() & ~ComponentRegistry::mask<T>());
+        }
+    };
+
+    // calls function(count, Components*...) for every chunk that has all of the components
+    // this is what systems use: plain arrays they can walk from front to back
+    template<typename... Components, typename Function>
+    void eachChunk(Function&& function)
+    {
+        ComponentMask mask = (ComponentMask(0) | ... | ComponentRegistry::mask<Components>());
+        for (auto& archetype : m_archetypes)
+        {
+            if ((archetype->mask() & mask) != mask)
+                continue;
+            for (Archetype::Chunk& chunk : archetype->chunks())
+            {
+                if (chunk.count)
+                    function((size_t)chunk.count, archetype->components<Components>(chunk)...);
+            }
+        }
+    };
+
+    // eachChunk with the chunks spread over the JobSystem threads, returns when all of them are done
+    // "function" runs on several threads at once, it may only write to the components of its own chunk
+    template<typename... Components, typename Function>
+    void eachChunkParallel(Function&& function)
+    {
+        ComponentMask mask = (ComponentMask(0) | ... | ComponentRegistry::mask<Components>());
+        std::vector<std::pair<Archetype*, Archetype::Chunk*>> chunks;
+        for (auto& archetype : m_archetypes)
+        {
+            if ((archetype->mask() & mask) != mask)
+                continue;
+            for (Archetype::Chunk& chunk : archetype->chunks())
+            {
+                if (chunk.count)
+                    chunks.push_back({ archetype.get(), &chunk });
+            }
+        }
+        JobSystem::getInstance().parallelFor(chunks.size(), 1, [&chunks, &function](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; c++)
+            {
+                Archetype* archetype = chunks[c].first;
+                Archetype::Chunk& chunk = *chunks[c].second;
+                function((size_t)chunk.count, archetype->components<Components>(chunk)...);
+            }
+        });
+    };
+
+    // calls function(Components&...) for every entity that has all of the components
+    template<typename... Components, typename Function>
+    void each(Function&& function)
+    {
+        eachChunk<Components...>([&function](size_t count, Components*... arrays) {
+            for (size_t i = 0; i < count; i++)
+            {
+                function(arrays[i]...);
+            }
+        });
+    };
+
+    size_t size() const { return m_records.size() - m_freeIndices.size(); };
+    size_t archetypeCount() const { return m_archetypes.size(); };
+
+private:
+    struct Record {
+        Archetype* archetype = nullptr;
+        uint32_t chunk = 0;
+        uint32_t row = 0;
+        uint32_t generation = 0;
+    };
+
+    Archetype* archetypeFor(ComponentMask);
+    Entity allocateEntity(Archetype*);
+    void changeArchetype(Entity, ComponentMask);
+    // updates the record of the entity that Archetype::remove moved into a free row
+    void relocated(Entity moved, uint32_t chunk, uint32_t row);
+
+    std::vector<Record> m_records;
+    std::vector<uint32_t> m_freeIndices;
+    std::vector<std::unique_ptr<Archetype>> m_archetypes;
+    std::unordered_map<ComponentMask, Archetype*> m_archetypeByMask;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct LogSite;
+
+enum class FlightEventType : uint8_t {
+    FRAME_BEGIN,
+    // value: how long the frame took on the main thread (ms)
+    FRAME_END,
+    // a PROFILE_ZONE or TaskGraph task that ended, value: its duration (ms)
+    ZONE,
+    // a shader or texture loaded, or mip levels streamed in (value: levels)
+    RESOURCE_LOAD,
+    SHADER_RELOAD,
+    // LOG_WARNING and LOG_ERROR (formatted by dump()) and Logger::warning/error
+    WARNING_MESSAGE,
+    ERROR_MESSAGE,
+    // anything else worth a line, see FlightRecorder::mark
+    MARKER,
+};
+
+// the last few seconds of what the engine did, always on
+// -------------------------------------------------------
+// a fixed ring of small events (frame boundaries, zone timings, resource loads, shader reloads, warnings and errors)
+// that any thread appends to with one atomic add and a copy, nothing is formatted and nothing allocates
+// CAPACITY events are about 10 seconds at 60 fps, the older ones are overwritten
+// dump() writes them as text (newest last, times relative to the dump), on demand (F9 or the API)
+// and from the SIGSEGV/SIGABRT/SIGFPE/SIGILL handlers installCrashHandlers() sets, that's why the dump only uses
+// write() on a fixed buffer and a ring slot is never locked: an event that was being written while the dump
+// read it is left out instead of printed half
+// when a verbose log is too expensive to keep on, this is what tells how the last frames before a hitch or a crash went
+class FlightRecorder {
+public:
+    static constexpr size_t CAPACITY = 16384;
+    // longer texts (and log arguments) are cut
+    static constexpr size_t TEXT_SIZE = 72;
+
+    // at the start and the end of Game::Frame
+    static void beginFrame();
+    static void endFrame();
+    static uint64_t frame();
+
+    static void record(FlightEventType type, const char* text, double value = 0.0);
+    static void record(FlightEventType type, const std::string& text, double value = 0.0) { record(type, text.c_str(), value); };
+    static void recordZone(const char* name, uint64_t startNs) { record(FlightEventType::ZONE, name, (now() - startNs) / 1000000.0); };
+    static void mark(const char* text) { record(FlightEventType::MARKER, text); };
+    // LOG_WARNING and LOG_ERROR: the call site and the first TEXT_SIZE bytes of the encoded arguments,
+    // only dump() formats them (a cut argument shows up as its "{}"), "payload" is nullptr when the log ring was full
+    static void recordLog(const LogSite& site, const char* payload, uint32_t size);
+
+    // where dump() writes to (flight_recorder.txt by default)
+    static void setDumpPath(const std::string& path);
+    // false when the file couldn't be written
+    static bool dump();
+    // the engine's crash handler: when the process crashes it flushes the log lines that weren't written yet
+    // (LogBackend::flushFromSignal), dumps into the dump path and then lets the signal do what it would have done
+    static void installCrashHandlers();
+
+    static const char* typeName(FlightEventType type);
+    static uint64_t now() { return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); };
+
+private:
+    FlightRecorder() {};
+    // "signal" is the one that crashed the process, 0 on demand
+    static bool dump(const char* path, int signal);
+    static void onCrash(int signal);
+};
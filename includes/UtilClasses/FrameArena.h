@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "MemoryTracker.h"
+
+// a bump allocator: allocating moves an offset forward, freeing does nothing, reset() drops everything at once
+// ------------------------------------------------------------------------------------------------------------
+// when a block is full a new one is added, and the next reset() replaces all blocks by a single one
+// big enough for everything, so a frame that needed more memory than before only pays for that once
+class LinearArena {
+public:
+    explicit LinearArena(size_t blockSize);
+    ~LinearArena();
+    LinearArena(const LinearArena&) = delete;
+    LinearArena& operator=(const LinearArena&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+    void reset();
+
+    // since the last reset
+    size_t used() const { return m_used; };
+    size_t capacity() const { return m_capacity; };
+    // most used between two resets
+    size_t peak() const { return m_peak; };
+    // how often a block ran out
+    uint64_t overflows() const { return m_overflows; };
+
+private:
+    struct Block {
+        std::byte* data;
+        size_t size;
+    };
+    void addBlock(size_t size);
+
+    std::vector<Block> m_blocks;
+    size_t m_blockSize;
+    // into the last block
+    size_t m_offset = 0;
+    size_t m_used = 0;
+    size_t m_capacity = 0;
+    size_t m_peak = 0;
+    uint64_t m_overflows = 0;
+};
+
+// lets std::pmr containers allocate from a LinearArena, deallocating is a no-op
+class ArenaResource : public std::pmr::memory_resource {
+public:
+    explicit ArenaResource(LinearArena& arena) : m_arena(arena) {};
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override { return m_arena.allocate(bytes, alignment); };
+    void do_deallocate(void*, size_t, size_t) override {};
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; };
+
+    LinearArena& m_arena;
+};
+
+// all threads together, over the last frame
+struct FrameArenaStats {
+    size_t usedBytes = 0;
+    size_t capacityBytes = 0;
+    // the most a single thread used in one frame
+    size_t peakBytes = 0;
+    // blocks that ran out (each one grows that arena for the following frames)
+    uint64_t overflows = 0;
+};
+
+// memory for data that only lives during a frame (draw list scratch, culling results, UI text)
+// ------------------------------------------------------------------------------------------
+// every JobSystem thread (workers + main) has its own pair of arenas, so allocating never takes a lock
+// the pairs are double buffered: endFrame() switches to the other arena of every pair and resets it,
+// so what was allocated during a frame stays valid until the end of the next one
+// (the frame a render thread replays is copied into its FrameCommands, it never points in here)
+// threads outside the pool (simulation, render thread, ...) get the regular heap from resource()
+//
+//   FrameVector<DrawCommandRef> order(FrameArena::getInstance().resource());
+class FrameArena {
+public:
+    static FrameArena& getInstance();
+
+    static constexpr size_t FRAMES = 2;
+    static constexpr size_t DEFAULT_BYTES_PER_THREAD = 256 * 1024;
+
+    // one pair of arenas per JobSystem thread (Game::Init, after the JobSystem started)
+    void init(size_t threadCount, size_t bytesPerThread = DEFAULT_BYTES_PER_THREAD);
+    // the calling thread's arena of the current frame
+    std::pmr::memory_resource* resource();
+    // on the main thread once the frame is done with its jobs
+    void endFrame();
+
+    const FrameArenaStats& getStats() const { return m_stats; };
+
+private:
+    FrameArena() {};
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    struct ThreadArenas {
+        explicit ThreadArenas(size_t bytes)
+            : arenas{ LinearArena(bytes), LinearArena(bytes) } {};
+        LinearArena arenas[FRAMES];
+        ArenaResource resources[FRAMES] = { ArenaResource(arenas[0]), ArenaResource(arenas[1]) };
+    };
+
+    std::vector<std::unique_ptr<ThreadArenas>> m_threads;
+    // which arena of every pair this frame uses, only changes while no jobs run
+    size_t m_frame = 0;
+    FrameArenaStats m_stats;
+    // the capacity of all arenas (MemoryTracker)
+    TrackedMemory m_memory;
+};
+
+// containers and strings for the FrameArena (or any other memory_resource)
+template<typename T>
+using FrameVector = std::pmr::vector<T>;
+using FrameString = std::pmr::string;
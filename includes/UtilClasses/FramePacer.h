@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// what the pacer measured, all times in milliseconds
+struct FramePacingStats {
+    // start of the previous frame to the start of this one
+    double frameMs = 0.0;
+    // exponential moving average of frameMs (see FramePacer::setSmoothing)
+    double smoothedMs = 0.0;
+    double fps = 0.0;
+    // average distance between frameMs and smoothedMs, 0 means every frame took exactly as long
+    double jitterMs = 0.0;
+    // the previous frame without the wait, and the wait itself (sleeping + spinning)
+    double workMs = 0.0;
+    double waitMs = 0.0;
+    double spinMs = 0.0;
+    uint64_t frames = 0;
+    uint64_t stutters = 0;
+    double lastStutterMs = 0.0;
+    // FramePacer::now() when the last stutter happened
+    double lastStutterTime = 0.0;
+};
+
+// paces the main loop: caps the frame rate and measures how even the frames are
+// -----------------------------------------------------------------------------
+// a frame may only start once the previous one's deadline passed, deadlines are exactly one frame time apart
+// (start + n * frame time) so small errors don't add up, a frame that is more than a frame late starts over from "now"
+// waiting is a hybrid: sleep while there is enough time left (cheap but the OS wakes us up whenever it likes)
+// and spin the last part (precise but burns the core), the spin part follows how late sleeps have been lately
+// so a 60Hz cap only spins for a fraction of a millisecond on a decent scheduler
+// https://www.geisswerks.com/ryan/FAQS/timing.html
+//
+// v-sync still works as before, the cap is for displays or runs where v-sync isn't available or isn't wanted
+class FramePacer {
+public:
+    // seconds since the first call, monotonic and in double precision (a float runs out of precision after hours)
+    static double now();
+
+    // 0 (the default) doesn't cap the frame rate
+    void setTargetFps(double fps);
+    void setTargetFrameTime(double milliseconds);
+    double getTargetFrameTime() const { return m_targetSeconds * 1000.0; };
+
+    // weight of the newest frame in the moving average (0..1, 0.1 by default)
+    void setSmoothing(double factor);
+    // beginFrame returns the moving average instead of the measured delta time
+    // (a stutter still returns the real one, otherwise the game would fall behind the clock)
+    void setSmoothDeltaTime(bool smooth) { m_smoothDeltaTime = smooth; };
+    // a frame that takes this many times the average counts as a stutter (1.5 by default)
+    void setStutterThreshold(double factor) { m_stutterFactor = factor; };
+
+    // waits until the next frame may start and returns its delta time in seconds (0 for the first frame)
+    double beginFrame();
+    // waits until now() reaches "time", see above
+    void waitUntil(double time);
+
+    const FramePacingStats& getStats() const { return m_stats; };
+    // the last HISTORY_SIZE frame times (ms) as a ring buffer, the oldest one is at getHistoryOffset()
+    static constexpr size_t HISTORY_SIZE = 240;
+    const std::vector<float>& getHistory() const { return m_history; };
+    size_t getHistoryOffset() const { return m_historyOffset; };
+
+private:
+    double m_targetSeconds = 0.0;
+    double m_smoothing = 0.1;
+    bool m_smoothDeltaTime = false;
+    double m_stutterFactor = 1.5;
+
+    // -1 until the first frame started
+    double m_lastStart = -1.0;
+    double m_nextDeadline = 0.0;
+    // how much later than asked a sleep usually returns, the wait spins for this long (plus some)
+    double m_sleepOvershoot = 0.001;
+
+    FramePacingStats m_stats;
+    std::vector<float> m_history = std::vector<float>(HISTORY_SIZE, 0.0f);
+    size_t m_historyOffset = 0;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+#include "TransformStorage.h"
+
+// the 6 planes (left, right, bottom, top, near, far) of what a camera can see
+// pulled straight out of projection * view (Gribb & Hartmann), every plane points inwards
+// https://www.gamedevs.org/uploads/fast-extraction-viewing-frustum-planes-from-world-view-projection-matrix.pdf
+struct Frustum {
+    glm::vec4 planes[6];
+
+    static Frustum fromMatrix(const glm::mat4& viewProjection)
+    {
+        Frustum frustum;
+        glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+        glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+        glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+        glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+        frustum.planes[0] = row3 + row0;
+        frustum.planes[1] = row3 - row0;
+        frustum.planes[2] = row3 + row1;
+        frustum.planes[3] = row3 - row1;
+        frustum.planes[4] = row3 + row2;
+        frustum.planes[5] = row3 - row2;
+        return frustum;
+    };
+
+    // false only when the box is completely behind one of the planes
+    // (a box next to a corner of the frustum can pass, that's fine for culling)
+    // objects without bounds are always visible
+    bool intersects(const TransformBounds& bounds) const
+    {
+        if (!bounds.valid())
+            return true;
+        for (const glm::vec4& plane : planes)
+        {
+            // the corner of the box that lies furthest along the plane's normal
+            float x = plane.x >= 0.0f ? bounds.max.x : bounds.min.x;
+            float y = plane.y >= 0.0f ? bounds.max.y : bounds.min.y;
+            float z = plane.z >= 0.0f ? bounds.max.z : bounds.min.z;
+            if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f)
+                return false;
+        }
+        return true;
+    };
+};
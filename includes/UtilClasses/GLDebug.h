@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "glad/glad.h"
+
+// what a driver message is about, performance warnings are split up by what they usually point at
+enum class GLDebugCategory {
+    // not ERROR, windows.h defines that
+    API_ERROR,
+    // the CPU waited for the GPU (mapping or updating a buffer that is still in use, a sync)
+    STALL,
+    // a shader compiled again for a different state
+    RECOMPILE,
+    REDUNDANT_STATE,
+    // any other performance warning
+    PERFORMANCE,
+    // deprecated or undefined behaviour, portability
+    WARNING,
+    INFO,
+    COUNT,
+};
+
+struct GLDebugStats {
+    bool active = false;
+    // messages per GLDebugCategory, repeats included
+    uint64_t messages[(size_t)GLDebugCategory::COUNT] = {};
+    // different messages (the rest were repeats that weren't logged again)
+    size_t distinct = 0;
+    uint64_t suppressed = 0;
+};
+
+// the driver's own messages (KHR_debug, core in OpenGL 4.3)
+// ---------------------------------------------------------
+// https://www.khronos.org/opengl/wiki/Debug_Output
+// without it the only errors we see are the ones Shader::checkCompileErrors asks for, while drivers (Mesa in particular)
+// also tell us when a buffer update stalled, a shader was recompiled for some state or a state change was redundant
+// with --gl-debug=1 the window gets a 4.3 debug context (a 3.3 one when the driver can't do 4.3, then there are no messages)
+// and every message goes through the callback: it is classified (GLDebugCategory), counted and logged with the profiler
+// zone the GL thread was in (the output is synchronous, so the zone is the one that made the call)
+// a message is logged the first time and then again after 10, 100, 1000 ... repeats, a driver complaining every draw
+// doesn't flood the log
+// label() names GL objects after their resources, the driver's messages (and tools like RenderDoc) use those names
+class GLDebug {
+public:
+    static GLDebug& getInstance();
+
+    // before the window is created
+    void setRequested(bool requested) { m_requested = requested; };
+    bool isRequested() const { return m_requested; };
+
+    // after GLAD was loaded, on the thread that owns the context
+    // installs the callback when the context turned out to be a debug context
+    void init();
+    bool isActive() const { return m_active; };
+
+    // on the thread that owns the context, does nothing without a debug context
+    // (a vertex array or query has to have been bound once before it can be named)
+    void label(GLenum identifier, GLuint name, const std::string& label);
+
+    GLDebugStats getStats();
+    // how often each category came up over the run, at exit
+    void logSummary();
+
+    static const char* categoryName(GLDebugCategory category);
+
+private:
+    GLDebug() {};
+    GLDebug(const GLDebug&) = delete;
+    GLDebug& operator=(const GLDebug&) = delete;
+
+    static void APIENTRY callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* user);
+    static GLDebugCategory classify(GLenum type, GLenum severity, const std::string& message);
+    void handle(GLenum source, GLenum type, GLuint id, GLenum severity, const std::string& message);
+
+    bool m_requested = false;
+    bool m_active = false;
+    GLint m_maxLabelLength = 0;
+
+    // the driver may call in from whichever thread owns the context
+    std::mutex m_mutex;
+    // by source, type and id (by the text when the driver gives every message id 0)
+    std::unordered_map<uint64_t, uint64_t> m_repeats;
+    uint64_t m_messages[(size_t)GLDebugCategory::COUNT] = {};
+    uint64_t m_suppressed = 0;
+};
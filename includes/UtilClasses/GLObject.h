@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "glad/glad.h"
+
+enum class GLObjectType : uint8_t {
+    BUFFER,
+    VERTEX_ARRAY,
+    TEXTURE,
+    PROGRAM,
+    QUERY,
+    COUNT,
+};
+
+struct GLNamePoolStats {
+    // names handed out / given back over the whole run
+    uint64_t acquired = 0;
+    uint64_t released = 0;
+    // glGen* calls, each one makes BATCH_SIZE names
+    uint64_t batches = 0;
+    // given back but not deleted yet (their frame may still be on the GPU)
+    size_t pendingDeletes = 0;
+};
+
+// where the GL names come from and where they go
+// ----------------------------------------------
+// names are generated BATCH_SIZE at a time (one glGenBuffers(64, ...) instead of 64 calls) and handed out
+// from a free list, programs can't be generated ahead so they are created one by one
+// a released name is not deleted right away: a frame that is still queued or still on the GPU may use it,
+// so the names released during a frame are deleted together once a fence placed after that frame's swap
+// has signaled (checked without waiting, https://www.khronos.org/opengl/wiki/Sync_Object)
+// everything here runs on the thread that owns the context, the GLObjects hand their names back through
+// RenderThread::run, which also keeps a release behind the frames that were queued before it
+class GLNamePool {
+public:
+    static GLNamePool& getInstance();
+
+    static constexpr size_t BATCH_SIZE = 64;
+
+    GLuint acquire(GLObjectType type);
+    // deleted once the frames that may use it are done with it
+    void release(GLObjectType type, GLuint name);
+    // after a swap (see Game::presented): fences the names released during the frame
+    // and deletes the ones whose fence has signaled
+    void endFrame();
+    // waits for the GPU and deletes everything, names released after this are ignored (the context is going away)
+    void shutdown();
+
+    GLNamePoolStats getStats() const;
+
+private:
+    GLNamePool() {};
+    GLNamePool(const GLNamePool&) = delete;
+    GLNamePool& operator=(const GLNamePool&) = delete;
+
+    struct Release {
+        GLObjectType type;
+        GLuint name;
+    };
+    struct FencedReleases {
+        GLsync fence;
+        std::vector<Release> releases;
+    };
+
+    void refill(GLObjectType type);
+    static void deleteNames(std::vector<Release>& releases);
+    static void deleteNames(GLObjectType type, const GLuint* names, GLsizei count);
+
+    std::vector<GLuint> m_free[(size_t)GLObjectType::COUNT];
+    // released this frame, not fenced yet
+    std::vector<Release> m_released;
+    // oldest first
+    std::deque<FencedReleases> m_fenced;
+    bool m_shutdown = false;
+    // read by the UI on the main thread
+    std::atomic<uint64_t> m_acquiredCount{ 0 };
+    std::atomic<uint64_t> m_releasedCount{ 0 };
+    std::atomic<uint64_t> m_batchCount{ 0 };
+    std::atomic<size_t> m_pendingDeletes{ 0 };
+};
+
+// a GL object that owns its name, like std::unique_ptr it can be moved but not copied
+// so a copied Mesh or Texture2D can't delete the same name twice (or leak one)
+template<GLObjectType TYPE>
+class GLObject {
+public:
+    GLObject() = default;
+    ~GLObject() { reset(); };
+    GLObject(const GLObject&) = delete;
+    GLObject& operator=(const GLObject&) = delete;
+    GLObject(GLObject&& other) noexcept : m_name(other.m_name) { other.m_name = 0; };
+    GLObject& operator=(GLObject&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            m_name = other.m_name;
+            other.m_name = 0;
+        }
+        return *this;
+    };
+
+    // a new name from the GLNamePool (on the thread that owns the context)
+    static GLObject create()
+    {
+        GLObject object;
+        object.m_name = GLNamePool::getInstance().acquire(TYPE);
+        return object;
+    };
+
+    GLuint get() const { return m_name; };
+    explicit operator bool() const { return m_name != 0; };
+
+    // gives the name back to the GLNamePool, deleted once no frame uses it anymore
+    // (any thread, defined in GLObject.cpp for the types below)
+    void reset();
+
+private:
+    GLuint m_name = 0;
+};
+
+using GLBuffer      = GLObject<GLObjectType::BUFFER>;
+using GLVertexArray = GLObject<GLObjectType::VERTEX_ARRAY>;
+using GLTexture     = GLObject<GLObjectType::TEXTURE>;
+using GLProgram     = GLObject<GLObjectType::PROGRAM>;
+using GLQuery       = GLObject<GLObjectType::QUERY>;
+
+extern template class GLObject<GLObjectType::BUFFER>;
+extern template class GLObject<GLObjectType::VERTEX_ARRAY>;
+extern template class GLObject<GLObjectType::TEXTURE>;
+extern template class GLObject<GLObjectType::PROGRAM>;
+extern template class GLObject<GLObjectType::QUERY>;
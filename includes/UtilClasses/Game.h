@@ -21,6 +21,22 @@ enum GameState {
 #include "Cube.h"
 #include "UIEvent.h"
 #include "UIEventQueue.h"
+#include "RenderStats.h"
+#include "TransformStorage.h"
+#include "JobSystem.h"
+#include "TaskGraph.h"
+#include "Simulation.h"
+#include "RenderThread.h"
+#include "FramePacer.h"
+#include "InputLatency.h"
+#include "FrameArena.h"
+#include "ObjectPool.h"
+#include "AllocationTracker.h"
+#include "GpuBufferArena.h"
+#include "TextureResidency.h"
+#include "PipelineStatistics.h"
+#include "GLDebug.h"
+#include "FlightRecorder.h"
 
 class Game
 {
@@ -32,6 +48,10 @@ public:
     // a array that keeps track wether a keyboard button was pressed or released
     bool         m_keys[1024];
     bool         m_mouseKeys[8];
+    // --latency=1, see InputLatency
+    InputLatency m_inputLatency;
+    // found by name once, see Game::handleEvent
+    SceneHandle  m_mainScene;
     // window related variables
     unsigned int m_windowWidth;
     unsigned int m_windowHeight;
@@ -41,9 +61,11 @@ public:
     bool         m_enabledVSync = true;
     bool         m_enabledDepthTest = true;
     bool         m_enabledCaptureCursor = true;
+    // a headless game creates an invisible window and never waits for v-sync (used by benchmarks)
+    bool         m_headless = false;
 
     // constructor/destructor
-    Game(unsigned int width, unsigned int height,std::string name);
+    Game(unsigned int width, unsigned int height,std::string name, bool headless = false);
     ~Game();
     // initialize game state (load all shaders/textures/levels)
     void Init();
@@ -51,13 +73,35 @@ public:
     void Run();
     void Update(float dt);
     void Render();
+    // a single iteration of the main loop (the frame's TaskGraph, its submit step polls the events, swap)
+    void Frame(float dt);
+    // initialize the game resources (shader and textures)
+    void loadResources();
+    // the fixed timestep simulation, only used once it is started (until then Update/transforms run every frame)
+    Simulation& getSimulation() { return m_simulation; };
+    // caps the frame rate of Run and measures the frame times (shown in the "Frame Pacing" panel)
+    FramePacer& getFramePacer() { return m_framePacer; };
 
 private:
+    // update -> transforms -> cull -> draw lists -> submit, built once and executed every frame
+    TaskGraph    m_frameGraph;
+    float        m_frameDeltaTime = 0.0f;
+    Simulation   m_simulation;
+    FramePacer   m_framePacer;
+    void buildFrameGraph();
+    // polls the events and handles everything in the UIEventQueue, returns the time of the oldest input (-1 = none)
+    double latchInput();
+    void handleEvent(const UIEvent& event);
+    void handleKey(int key, int action);
+    // FramePacer::now() of the oldest input the frame being submitted applied
+    double       m_frameInputTime = -1.0;
+    // called after the swap (on the render thread if there is one), retires released GL objects
+    // and measures the input latency if asked to
+    void presented(double inputTime);
+
     // add all callbacks to the window
     void registerCallbacks();
     // initialize the window context
     void createWindow();
-    // initialize the game resources (shader and textures)
-    void loadResources();
 };
 
@@ -2,44 +2,81 @@
 
 #include "Mesh.h"
 #include "Material.h"
+#include "TransformStorage.h"
+#include "EntityWorld.h"
+#include "ObjectPool.h"
 #include <glm/gtc/matrix_transform.hpp>
 
+class Scene;
+
+// a GameObject doesn't store its transform itself, it only keeps the id of its
+// entry in the TransformStorage (setters mark it dirty, the matrix is rebuilt once per frame)
+// once it is added to a Scene it also becomes an entity there, the setters keep its components up to date
 class GameObject {
 public:
     GameObject();
     GameObject(Mesh* mesh, Material* material);
+    virtual ~GameObject();
+    // two objects sharing one transform id would destroy it twice
+    GameObject(const GameObject&) = delete;
+    GameObject& operator=(const GameObject&) = delete;
+
+    // GameObjects (and the primitives deriving from them) live in an ObjectPool
+    static void* operator new(size_t size) { return getPool().allocate(size); };
+    static void operator delete(void* object, size_t size) { getPool().deallocate(object, size); };
+    static ObjectPool& getPool();
 
     void setPosition(const glm::vec3&);
     void setRotation(const glm::quat&); // Use quaternions for rotation!
     void setScale(const glm::vec3&);
     void setMesh(Mesh*);
     void setMaterial(Material*);
-    glm::mat4 getModel();
+    // false draws the mesh as lines instead of triangles
+    void setDrawTriangles(bool);
+    bool getDrawTriangles();
+    const glm::mat4& getModel();
     glm::vec3 getPosition();
     glm::quat getRotation();
     glm::vec3 getScale();
     Mesh* getMesh();
     Material* getMaterial();
 
-    // Updates the internal model matrix
-    void updateModelMatrix();
-    // Update modelMatrix
+    TransformId getTransformId() const { return m_transform; };
 
+    // hierarchical transforms (e.g., robot arm): position, rotation and scale become relative to the parent
+    // passing nullptr makes the object a root again, returns false if "parent" is this object or one of its children
+    bool setParent(GameObject* parent);
+    GameObject* getParent();
+    const std::vector<GameObject*>& getChildren();
+    // world space bounding box of the mesh, follows the world matrix (refreshed once per frame)
+    const TransformBounds& getWorldBounds();
 
-    // Draws the object
-    virtual void draw(const glm::mat4&, const glm::mat4&);
+    // Draws the object on its own (a Scene draws all of its objects in one go instead)
+    void draw(const glm::mat4&, const glm::mat4&);
 
 
-    // Optionally, children for hierarchical transforms (e.g., robot arm)
-    // std::vector<GameObject*> children;
-    // GameObject* parent;
+protected:
+    // the primitives make their own mesh and material, those are deleted together with the object
+    void setOwnedMesh(Mesh*);
+    void setOwnedMaterial(Material*);
 
 private:
+    friend class Scene;
+    // pushes mesh, material and drawTriangles to the MeshRenderer component (when in a scene)
+    void syncRenderer();
+
     Mesh* m_mesh;
     Material* m_material;
+    Mesh* m_ownedMesh = nullptr;
+    Material* m_ownedMaterial = nullptr;
+    bool m_drawTriangles = true;
+    // the scene this object was added to and its entity there
+    Scene* m_scene = nullptr;
+    Entity m_entity;
+
+    // position, rotation (a quaternion, better for rotations than Euler angles), scale and model matrix
+    TransformId m_transform;
 
-    glm::vec3 m_position;
-    glm::quat m_rotation; // Better for rotations than Euler angles
-    glm::vec3 m_scale;
-    glm::mat4 m_model; // The calculated model matrix
+    GameObject* m_parent = nullptr;
+    std::vector<GameObject*> m_children;
 };
\ No newline at end of file
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "glad/glad.h"
+
+#include "GLObject.h"
+#include "HandlePool.h"
+#include "MemoryTracker.h"
+
+struct Vertex;
+
+struct TlsfStats {
+    uint32_t capacity = 0;
+    uint32_t used = 0;
+    uint32_t allocations = 0;
+    uint32_t freeBlocks = 0;
+    uint32_t largestFree = 0;
+};
+
+// a two level segregated fit allocator over a range of "capacity" elements
+// -----------------------------------------------------------------------
+// http://www.gii.upv.es/tlsf/files/papers/ecrts04_tlsf.pdf
+// the free blocks sit in lists per size class: the first level is the power of two of the size, the second
+// splits that power of two into SL_COUNT classes, two bitmaps tell which lists have a block so finding one
+// that fits is a couple of bit scans instead of a walk over the free blocks
+// only the bookkeeping lives here, the memory itself is a GL buffer (see GpuBufferArenas), so offsets and
+// sizes are in elements (vertices, indices) and a block is addressed by its id, not by a pointer
+// blocks that touch in memory are merged when freed, there is no header inside the managed range
+// not thread safe, GpuBufferArenas locks around it
+class TlsfAllocator {
+public:
+    static constexpr uint32_t INVALID = 0xFFFFFFFF;
+    static constexpr uint64_t NO_OWNER = ~0ull;
+
+    explicit TlsfAllocator(uint32_t capacity);
+
+    // a block id, INVALID when no free block is big enough (or size is 0)
+    uint32_t allocate(uint32_t size, uint64_t owner);
+    // the lowest block that fits and ends at or before "limit", to move an allocation down (compaction)
+    // walks the blocks in memory order, so it is slower than allocate
+    uint32_t allocateBelow(uint32_t size, uint32_t limit, uint64_t owner);
+    void free(uint32_t block);
+
+    uint32_t offset(uint32_t block) const { return m_blocks[block].offset; };
+    uint32_t size(uint32_t block) const { return m_blocks[block].size; };
+    bool isFree(uint32_t block) const { return m_blocks[block].free; };
+    // whatever the caller wants to find the block's user with, NO_OWNER for a free block
+    uint64_t owner(uint32_t block) const { return m_blocks[block].owner; };
+    void setOwner(uint32_t block, uint64_t owner) { m_blocks[block].owner = owner; };
+
+    // the blocks in memory order, from the end
+    uint32_t last() const { return m_last; };
+    uint32_t previous(uint32_t block) const { return m_blocks[block].previousPhysical; };
+
+    // true when there is nothing to compact: no free space, or all of it in one block at the end
+    bool isPacked() const { return m_freeBlocks == 0 || (m_freeBlocks == 1 && m_blocks[m_last].free); };
+    uint32_t getCapacity() const { return m_capacity; };
+    TlsfStats getStats() const;
+
+private:
+    static constexpr uint32_t SL_LOG2 = 4;
+    static constexpr uint32_t SL_COUNT = 1 << SL_LOG2;
+    // sizes below SL_COUNT all go in the first level, one class per size
+    static constexpr uint32_t FL_COUNT = 32 - SL_LOG2 + 1;
+
+    struct Block {
+        uint32_t offset = 0;
+        uint32_t size = 0;
+        uint32_t previousPhysical = INVALID;
+        uint32_t nextPhysical = INVALID;
+        uint32_t previousFree = INVALID;
+        uint32_t nextFree = INVALID;
+        uint64_t owner = NO_OWNER;
+        bool free = false;
+    };
+
+    static void mapping(uint32_t size, uint32_t& fl, uint32_t& sl);
+    uint32_t findFree(uint32_t size) const;
+    void insertFree(uint32_t block);
+    void removeFree(uint32_t block);
+    // takes "size" from the start of a free block that is already out of its list
+    uint32_t use(uint32_t block, uint32_t size, uint64_t owner);
+    // merges "second" into "first", they have to be neighbours in memory
+    void absorb(uint32_t first, uint32_t second);
+    uint32_t newBlock();
+
+    uint32_t m_capacity = 0;
+    uint32_t m_used = 0;
+    uint32_t m_allocations = 0;
+    uint32_t m_freeBlocks = 0;
+    uint32_t m_first = INVALID;
+    uint32_t m_last = INVALID;
+    uint32_t m_flBitmap = 0;
+    uint32_t m_slBitmap[FL_COUNT] = {};
+    uint32_t m_heads[FL_COUNT][SL_COUNT];
+    std::vector<Block> m_blocks;
+    // ids of merged blocks, reused before m_blocks grows
+    std::vector<uint32_t> m_unusedBlocks;
+};
+
+// where a mesh's vertices and indices are, the offsets change when the arena is compacted
+// so this is read when the mesh is drawn, never kept
+struct GpuMeshRange {
+    GLuint vertexArray = 0;
+    GLuint vertexBuffer = 0;
+    GLuint indexBuffer = 0;
+    uint32_t arena = 0;
+    uint32_t firstVertex = 0;
+    uint32_t vertexCount = 0;
+    uint32_t vertexBlock = TlsfAllocator::INVALID;
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    uint32_t indexBlock = TlsfAllocator::INVALID;
+};
+
+using GpuMeshHandle = Handle<GpuMeshRange>;
+
+struct GpuBufferArenaStats {
+    size_t arenas = 0;
+    size_t meshes = 0;
+    size_t capacityBytes = 0;
+    size_t usedBytes = 0;
+    size_t freeBytes = 0;
+    // the biggest vertex range a new mesh could still get without a new arena
+    size_t largestFreeBytes = 0;
+    size_t freeBlocks = 0;
+    // 0 when every buffer's free space is one block, towards 1 when it is spread over small holes
+    // (1 - largest free block / free space, summed over the buffers)
+    float fragmentation = 0.0f;
+    // freed or moved ranges that wait for the GPU to finish the frames using them
+    size_t pendingFrees = 0;
+    uint64_t moves = 0;
+    uint64_t movedBytes = 0;
+};
+
+// all mesh data in a few big vertex and index buffers
+// ---------------------------------------------------
+// a mesh used to make its own VAO, VBO and EBO, now it gets a range of an arena's vertex buffer and one of its
+// index buffer (TlsfAllocator), so there are a handful of buffers and VAOs instead of three GL objects per mesh
+// the meshes of one arena share its VAO and draw with glDrawElementsBaseVertex, their indices stay 0 based
+// a mesh that doesn't fit any arena gets a new one (sized for the mesh when it is bigger than an arena)
+// freed ranges are fenced like the GLNamePool's names: a queued frame may still draw them, so they only go back
+// to the allocator once a fence after that frame has signaled
+// removing meshes leaves holes, compact() moves the highest meshes down into them with glCopyBufferSubData
+// (a few per frame up to a byte budget), the mesh's range points at the copy right away, every frame recorded
+// after that is queued behind the copy
+// allocate, release and compact run on the main thread, endFrame on the thread that owns the context
+class GpuBufferArenas {
+public:
+    static GpuBufferArenas& getInstance();
+
+    // elements per arena, 1M vertices and 6M indices (24 MB each, a sphere has about 6 indices per vertex)
+    static constexpr uint32_t VERTEX_CAPACITY = 1 << 20;
+    static constexpr uint32_t INDEX_CAPACITY = 6 << 20;
+    // allocations looked at per buffer and frame, and moves per frame
+    static constexpr size_t COMPACTION_CANDIDATES = 8;
+    static constexpr size_t MAX_MOVES = 32;
+    static constexpr size_t DEFAULT_COMPACTION_BUDGET = 1024 * 1024;
+
+    // an invalid handle for a mesh without vertices
+    GpuMeshHandle allocate(uint32_t vertexCount, uint32_t indexCount);
+    // the ranges are given back once the frames that may draw them are done
+    void release(GpuMeshHandle handle);
+    // nullptr for a released handle
+    const GpuMeshRange* getRange(GpuMeshHandle handle) const { return m_ranges.get(handle); };
+    // copies the data into the range, on the thread that owns the context
+    static void upload(const GpuMeshRange& range, const Vertex* vertices, const unsigned int* indices);
+
+    // at the end of Game::Frame: moves meshes down into the holes, up to "bytes" of copies
+    void compact() { compact(m_compactionBudget); };
+    void compact(size_t bytes);
+    void setCompactionBudget(size_t bytes) { m_compactionBudget = bytes; };
+    // after a swap (see Game::presented), frees the ranges whose frames are done
+    void endFrame();
+    // deletes the arenas while there is a context, ranges released after this are only forgotten
+    void shutdown();
+
+    GpuBufferArenaStats getStats();
+
+private:
+    GpuBufferArenas() {};
+    GpuBufferArenas(const GpuBufferArenas&) = delete;
+    GpuBufferArenas& operator=(const GpuBufferArenas&) = delete;
+
+    struct Arena {
+        Arena(uint32_t vertexCapacity, uint32_t indexCapacity) : vertices(vertexCapacity), indices(indexCapacity) {};
+
+        GLVertexArray vertexArray;
+        GLBuffer vertexBuffer;
+        GLBuffer indexBuffer;
+        TlsfAllocator vertices;
+        TlsfAllocator indices;
+        TrackedMemory memory;
+    };
+    struct Retired {
+        uint32_t arena;
+        bool index;
+        uint32_t block;
+    };
+    struct FencedRetired {
+        GLsync fence;
+        std::vector<Retired> blocks;
+    };
+    // a copy inside one buffer, the old range is retired after it
+    struct Move {
+        GLuint buffer;
+        size_t from;
+        size_t to;
+        size_t bytes;
+        Retired retired;
+    };
+
+    // with m_mutex held
+    bool allocateFrom(uint32_t arena, GpuMeshRange& range, uint32_t vertexCount, uint32_t indexCount);
+    void collectMoves(uint32_t arena, bool index, size_t& bytes, Move* moves, size_t& moveCount);
+    void free(const Retired& retired);
+    static uint64_t ownerOf(GpuMeshHandle handle) { return ((uint64_t)handle.generation << 32) | handle.index; };
+    static GpuMeshHandle handleOf(uint64_t owner) { return GpuMeshHandle{ (uint32_t)owner, (uint32_t)(owner >> 32) }; };
+
+    // on the thread that owns the context
+    static std::unique_ptr<Arena> createArena(uint32_t vertexCapacity, uint32_t indexCapacity);
+    void retire(const Retired& retired);
+
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<Arena>> m_arenas;
+    // read while the frame is recorded, only changed on the main thread between frames
+    HandlePool<GpuMeshRange> m_ranges;
+    // retired this frame, not fenced yet
+    std::vector<Retired> m_retired;
+    // oldest first
+    std::deque<FencedRetired> m_fenced;
+    size_t m_compactionBudget = DEFAULT_COMPACTION_BUDGET;
+    uint64_t m_moves = 0;
+    uint64_t m_movedBytes = 0;
+    bool m_shutdown = false;
+};
+
+// a mesh's ranges, given back when it goes away
+// move-only like the GLObjects it replaces
+class GpuMeshAllocation {
+public:
+    GpuMeshAllocation() {};
+    ~GpuMeshAllocation() { reset(); };
+    GpuMeshAllocation(const GpuMeshAllocation&) = delete;
+    GpuMeshAllocation& operator=(const GpuMeshAllocation&) = delete;
+    GpuMeshAllocation(GpuMeshAllocation&& other) noexcept : m_handle(other.m_handle) { other.m_handle = GpuMeshHandle(); };
+    GpuMeshAllocation& operator=(GpuMeshAllocation&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            m_handle = other.m_handle;
+            other.m_handle = GpuMeshHandle();
+        }
+        return *this;
+    };
+
+    void allocate(uint32_t vertexCount, uint32_t indexCount);
+    void reset();
+    // an empty range (no vertex array) when nothing is allocated
+    const GpuMeshRange& range() const;
+
+private:
+    GpuMeshHandle m_handle;
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// a handle to something stored in a HandlePool<T>, like Entity the generation tells a removed
+// object apart from a new one that reuses its slot, so a stale handle finds nothing instead of the wrong thing
+// the type parameter only keeps a shader handle from being passed where a texture handle is expected
+template<typename T>
+struct Handle {
+    static constexpr uint32_t INVALID_INDEX = 0xFFFFFFFF;
+    uint32_t index = INVALID_INDEX;
+    uint32_t generation = 0;
+
+    bool valid() const { return index != INVALID_INDEX; };
+    bool operator==(const Handle& other) const { return index == other.index && generation == other.generation; };
+    bool operator!=(const Handle& other) const { return !(*this == other); };
+};
+
+// slots addressed by index + generation
+// -------------------------------------
+// a lookup is an index into a chunk and one compare of the generation, no hashing and no string compares
+// the slots live in fixed size chunks that never move, so a pointer from get() stays good until
+// that object is removed (Materials keep a Shader* for the whole run)
+// removed slots go on a free list and get a new generation when they are reused
+// an object is only constructed when it is added (a default Texture2D already asks GL for a name)
+// not thread safe, resources and scenes are added on the main thread (GL work itself goes through the RenderThread)
+template<typename T>
+class HandlePool {
+public:
+    static constexpr uint32_t CHUNK_SIZE = 64;
+
+    HandlePool() = default;
+    HandlePool(const HandlePool&) = delete;
+    HandlePool& operator=(const HandlePool&) = delete;
+    ~HandlePool() { clear(); };
+
+    Handle<T> add(T value)
+    {
+        uint32_t index;
+        if (!m_free.empty())
+        {
+            index = m_free.back();
+            m_free.pop_back();
+        }
+        else
+        {
+            index = m_capacity;
+            if ((index % CHUNK_SIZE) == 0)
+                m_chunks.push_back(std::make_unique<Slot[]>(CHUNK_SIZE));
+            m_capacity++;
+        }
+        Slot& slot = slotAt(index);
+        new (slot.storage) T(std::move(value));
+        slot.alive = true;
+        m_size++;
+        return Handle<T>{ index, slot.generation };
+    };
+
+    // nullptr for an invalid or stale handle
+    T* get(Handle<T> handle)
+    {
+        if (handle.index >= m_capacity)
+            return nullptr;
+        Slot& slot = slotAt(handle.index);
+        return (slot.alive && slot.generation == handle.generation) ? slot.value() : nullptr;
+    };
+    const T* get(Handle<T> handle) const { return const_cast<HandlePool*>(this)->get(handle); };
+
+    bool alive(Handle<T> handle) const { return get(handle) != nullptr; };
+
+    // false when the handle was already stale
+    bool remove(Handle<T> handle)
+    {
+        if (!alive(handle))
+            return false;
+        Slot& slot = slotAt(handle.index);
+        slot.value()->~T();
+        slot.alive = false;
+        // every handle to this slot is stale from now on
+        slot.generation++;
+        m_free.push_back(handle.index);
+        m_size--;
+        return true;
+    };
+
+    // fn(Handle<T>, T&) for every live object, in slot order
+    template<typename Fn>
+    void forEach(Fn&& fn)
+    {
+        for (uint32_t index = 0; index < m_capacity; index++)
+        {
+            Slot& slot = slotAt(index);
+            if (slot.alive)
+                fn(Handle<T>{ index, slot.generation }, *slot.value());
+        }
+    };
+
+    void clear()
+    {
+        for (uint32_t index = 0; index < m_capacity; index++)
+        {
+            Slot& slot = slotAt(index);
+            if (slot.alive)
+                remove(Handle<T>{ index, slot.generation });
+        }
+    };
+
+    size_t size() const { return m_size; };
+
+private:
+    struct Slot {
+        alignas(T) unsigned char storage[sizeof(T)];
+        uint32_t generation = 0;
+        bool alive = false;
+
+        T* value() { return std::launder(reinterpret_cast<T*>(storage)); };
+    };
+
+    Slot& slotAt(uint32_t index) { return m_chunks[index / CHUNK_SIZE][index % CHUNK_SIZE]; };
+
+    std::vector<std::unique_ptr<Slot[]>> m_chunks;
+    std::vector<uint32_t> m_free;
+    uint32_t m_capacity = 0;
+    size_t m_size = 0;
+};
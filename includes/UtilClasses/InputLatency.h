@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+
+// input to swap latency in milliseconds, over the frames since the last report
+struct InputLatencyStats {
+    uint64_t frames = 0;
+    double lastMs = 0.0;
+    double minMs = 0.0;
+    double maxMs = 0.0;
+    double totalMs = 0.0;
+    double meanMs() const { return frames ? totalMs / frames : 0.0; };
+};
+
+// measures how long input takes to reach the screen
+// -------------------------------------------------
+// the callbacks only queue camera input (UIEventQueue), the frame polls the events and applies them at its
+// start, before culling (Game::latchInput), and the view and projection are read from that camera, so a mouse
+// move shows up in the very next frame instead of the one after
+// when enabled this measures the time from the oldest input a frame applied until that frame was swapped
+// (glFinish after the swap, so the GPU is done with it as well, the display adds its own scan-out on top)
+class InputLatency {
+public:
+    void setEnabled(bool enabled) { m_enabled = enabled; };
+    bool isEnabled() const { return m_enabled; };
+    // a frame whose oldest input was at "inputTime" was swapped at "swapTime" (any thread, a render thread swaps)
+    // logs a summary every REPORT_FRAMES frames
+    void record(double inputTime, double swapTime);
+    InputLatencyStats getStats();
+    static constexpr uint64_t REPORT_FRAMES = 120;
+
+private:
+    bool m_enabled = false;
+    std::mutex m_mutex;
+    InputLatencyStats m_stats;
+};
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// a work-stealing thread pool
+// ---------------------------
+// every worker owns a queue of jobs: it pushes and pops its own jobs at the back (the most recent job,
+// its data is probably still in the cache) and when it runs out it steals from the front of another
+// worker's queue (the oldest job, most likely the biggest piece of work left over)
+// the thread that owns the GL context (the "main thread") has a queue as well, jobs it submits end up
+// there and while it waits for jobs it runs them itself instead of sleeping
+// queueing a job never allocates: the queues are fixed size rings made in start() and a job keeps its
+// callable inline (a lambda capturing a few pointers/indices), so a steady-state frame stays at 0 allocations
+// https://en.wikipedia.org/wiki/Work_stealing
+
+// counts the jobs of a batch that haven't finished yet, JobSystem::wait blocks until it reaches 0
+struct JobCounter {
+    std::atomic<uint32_t> remaining{ 0 };
+};
+
+class JobSystem {
+public:
+    static JobSystem& getInstance();
+
+    // one worker per core, minus the core of the main thread
+    static constexpr size_t DEFAULT_WORKERS = (size_t)-1;
+
+    // starts "workerCount" worker threads (0 is allowed: every job runs on the main thread then)
+    // the thread calling start() becomes the main thread, calling it again does nothing
+    void start(size_t workerCount = DEFAULT_WORKERS);
+    // finishes the jobs that are still queued and joins all workers
+    void stop();
+    ~JobSystem();
+
+    size_t workerCount() const { return m_workers.size(); };
+    // workers + the main thread, threadIndex() is always smaller than this
+    size_t threadCount() const { return m_workers.size() + 1; };
+    // 0..workerCount()-1 on a worker, workerCount() on the main thread (and any other thread)
+    // handy to give every thread its own output buffer
+    size_t threadIndex() const;
+    // true on the thread that called start() (the one that owns the GL context)
+    bool isMainThread() const { return std::this_thread::get_id() == m_mainThread; };
+    // a worker or the main thread
+    bool isPoolThread() const;
+
+    // queues a job, "counter" (optional) is incremented now and decremented when the job is done
+    // "function" is copied into the job as plain bytes, so it has to be small and trivially copyable
+    // (capture pointers and indices, not containers), a full queue runs the job right away instead
+    template<typename Function>
+    void run(Function&& function, JobCounter* counter = nullptr)
+    {
+        using Callable = typename std::decay<Function>::type;
+        static_assert(sizeof(Callable) <= Job::INLINE_SIZE && alignof(Callable) <= alignof(std::max_align_t),
+            "JobSystem::run: the job's captures don't fit inline, capture a pointer to them instead");
+        static_assert(std::is_trivially_copyable<Callable>::value && std::is_trivially_destructible<Callable>::value,
+            "JobSystem::run: jobs are copied as plain bytes, capture pointers instead of objects that own memory");
+
+        Job job;
+        new (job.storage) Callable(std::forward<Function>(function));
+        job.invoke = [](Job& self) { (*reinterpret_cast<Callable*>(self.storage))(); };
+        job.counter = counter;
+        push(job);
+    };
+    // runs other jobs until every job of "counter" finished
+    void wait(JobCounter& counter);
+    // runs one queued job on the calling thread, false if there was nothing to do
+    // (always false outside the pool, those threads only hand out jobs)
+    bool runPendingJob();
+
+    // calls function(begin, end) on ranges of [0, count) spread over all threads and waits for them
+    // ranges are never smaller than "minBatch" (too small and the queueing costs more than the work),
+    // and there are a few more ranges than threads so a thread that finishes early can steal the rest
+    // a thread outside the pool (e.g. the simulation thread) runs the whole range itself, it can't help
+    // with other jobs while it waits and threadIndex() would not be unique for it
+    template<typename Function>
+    void parallelFor(size_t count, size_t minBatch, Function&& function)
+    {
+        if (count == 0)
+            return;
+        size_t threads = m_workers.size() + 1;
+        size_t batches = std::min((count + minBatch - 1) / std::max<size_t>(minBatch, 1), threads * 4);
+        if (batches <= 1 || m_workers.empty() || !isPoolThread())
+        {
+            function((size_t)0, count);
+            return;
+        }
+
+        JobCounter counter;
+        size_t batchSize = (count + batches - 1) / batches;
+        // the calling thread takes the first range itself instead of queueing it
+        for (size_t begin = batchSize; begin < count; begin += batchSize)
+        {
+            size_t end = std::min(begin + batchSize, count);
+            run([&function, begin, end]() { function(begin, end); }, &counter);
+        }
+        function((size_t)0, std::min(batchSize, count));
+        wait(counter);
+    };
+
+private:
+    JobSystem() {};
+
+    // a function pointer plus the bytes of the callable it calls, trivially copyable itself
+    // 48 bytes hold the lambda of parallelFor (a reference and a range) with room to spare
+    struct Job {
+        static constexpr size_t INLINE_SIZE = 48;
+        void (*invoke)(Job&) = nullptr;
+        JobCounter* counter = nullptr;
+        alignas(std::max_align_t) unsigned char storage[INLINE_SIZE];
+    };
+
+    // one per worker plus one for the main thread (the last one)
+    // a ring instead of a deque so pushing never allocates, the owner takes from the back and
+    // thieves from the front, so it's used like a deque that never grows
+    struct WorkQueue {
+        // more than parallelFor ever queues at once (4 ranges per thread), a burst past it runs inline
+        static constexpr size_t CAPACITY = 1024;
+        std::mutex mutex;
+        std::array<Job, CAPACITY> jobs;
+        // "front" and "back" only grow, the slot is the position modulo CAPACITY
+        uint64_t front = 0;
+        uint64_t back = 0;
+    };
+
+    void push(Job&);
+    void workerLoop(size_t index);
+    // the queue of the calling thread (worker or main), nullptr for any other thread
+    WorkQueue* ownQueue();
+    bool popOwn(WorkQueue&, Job&);
+    bool steal(size_t thiefIndex, Job&);
+    void execute(Job&);
+
+    std::vector<std::thread> m_workers;
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+    std::thread::id m_mainThread = std::this_thread::get_id();
+    std::atomic<bool> m_running{ false };
+
+    // idle workers sleep here instead of spinning on 31 empty queues
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wakeUp;
+    std::atomic<size_t> m_queuedJobs{ 0 };
+};
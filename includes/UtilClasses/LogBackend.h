@@ -0,0 +1,226 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// the asynchronous half of the Logger
+// ---------------------------------------
+// every thread that logs gets its own single-producer/single-consumer ring buffer,
+// writing a record is a memcpy and one atomic store (no locks, no allocations, no I/O)
+// a background thread collects the records of all rings, puts them back in global order,
+// formats them and hands the lines to the sinks (console, rotating files, ...)
+
+// the numeric values match the LOG_LEVEL_* defines in Logger.h
+enum class LogLevel : uint8_t {
+	Trace,
+	Debug,
+	Info,
+	Succes,
+	Warning,
+	Error,
+};
+
+// everything about a log statement that is known at compile time
+// every LOG_* macro owns one of these as a static constant, so a record only needs a pointer to it
+struct LogSite {
+	LogLevel level;
+	const char* file;
+	uint32_t line;
+	// "{}" placeholders are replaced by the arguments in order ("{{" and "}}" are literal braces)
+	const char* format;
+	const char* color;
+};
+
+enum class LogRecordKind : uint8_t {
+	// filler at the end of a ring so that records never wrap around
+	Padding,
+	// a message with level, time, file and line
+	Message,
+	// a line that goes to the sinks as-is (Logger::print)
+	Raw,
+	// a LogSite plus its encoded arguments, formatted by the logging thread (LOG_* macros)
+	Format,
+};
+
+// what happens when a thread logs faster than the background thread can write
+enum class LogOverflowPolicy : uint8_t {
+	// the record is thrown away and counted, the caller never waits
+	Drop,
+	// the caller waits until the background thread made room
+	Block,
+};
+
+// every record starts with this header, the message bytes follow right after it
+// the header (and therefore every record) is 8 byte aligned
+struct LogRecordHeader {
+	uint32_t size;			// bytes of the whole record (header + payload + alignment)
+	LogRecordKind kind;
+	LogLevel level;
+	uint16_t colorLength;
+	uint32_t payloadSize;	// bytes of the message
+	uint32_t line;
+	uint64_t sequence;		// global order over all threads
+	int64_t timestamp;		// nanoseconds of the steady_clock, turned into wall time by the logging thread
+	const char* file;		// always __FILE__, so it lives for the whole program
+	const LogSite* site;	// only set for LogRecordKind::Format
+	char color[16];			// ANSI color escape sequence
+
+	const char* payload() const { return reinterpret_cast<const char*>(this + 1); };
+	char* payload() { return reinterpret_cast<char*>(this + 1); };
+};
+
+// a lock-free single-producer/single-consumer byte ring
+// the producer is the thread that owns it, the consumer is whoever holds the backend's drain lock
+class LogRingBuffer {
+public:
+	explicit LogRingBuffer(size_t capacity);
+
+	// producer: returns room for "size" bytes (8 byte aligned) or nullptr when the ring is full
+	LogRecordHeader* reserve(uint32_t size);
+	// producer: publishes the record returned by reserve
+	void commit(LogRecordHeader*);
+
+	// consumer
+	uint64_t readPosition() const { return m_tail.load(std::memory_order_relaxed); };
+	uint64_t writePosition() const { return m_head.load(std::memory_order_acquire); };
+	const LogRecordHeader* recordAt(uint64_t position) const;
+	void release(uint64_t position) { m_tail.store(position, std::memory_order_release); };
+
+	// cleared by the owning thread when it exits, the backend frees the ring once it's empty
+	std::atomic<bool> m_producerAlive{ true };
+
+private:
+	std::vector<uint64_t> m_storage;
+	char* m_buffer;
+	uint64_t m_capacity;
+	// keep producer and consumer positions on separate cache lines
+	alignas(64) std::atomic<uint64_t> m_head{ 0 };
+	alignas(64) std::atomic<uint64_t> m_tail{ 0 };
+};
+
+// a destination for formatted lines
+class LogSink {
+public:
+	virtual ~LogSink() = default;
+	// "line" has no color codes and no newline, the sink decides how to present it
+	virtual void write(const LogRecordHeader&, const std::string& line) = 0;
+	virtual void flush() = 0;
+	// the file descriptor a signal handler may write(2) to directly, -1 when there is none
+	virtual int descriptor() const { return -1; };
+};
+
+// standard output, colored when the terminal supports it
+class ConsoleSink : public LogSink {
+public:
+	ConsoleSink(bool colors);
+	virtual void write(const LogRecordHeader&, const std::string& line) override;
+	virtual void flush() override;
+	virtual int descriptor() const override { return m_descriptor; };
+private:
+	bool m_colors;
+	int m_descriptor;
+};
+
+// a file that is rotated to "<path>.1" ... "<path>.<maxFiles>" once it grows beyond maxBytes
+class RotatingFileSink : public LogSink {
+public:
+	RotatingFileSink(std::string path, size_t maxBytes, int maxFiles);
+	~RotatingFileSink();
+	virtual void write(const LogRecordHeader&, const std::string& line) override;
+	virtual void flush() override;
+	virtual int descriptor() const override { return m_descriptor.load(std::memory_order_acquire); };
+private:
+	void rotate();
+	// -1 while no file is open
+	void updateDescriptor();
+
+	std::string m_path;
+	size_t m_maxBytes;
+	int m_maxFiles;
+	size_t m_currentBytes = 0;
+	FILE* m_file = nullptr;
+	std::atomic<int> m_descriptor{ -1 };
+};
+
+class LogBackend {
+public:
+	// the backend is created on first use and intentionally never destroyed
+	// so objects with static lifetime can still log from their destructors
+	static LogBackend& instance();
+
+	// producer side (any thread)
+	// reserves a record with room for payloadSize bytes, returns nullptr if it was dropped
+	LogRecordHeader* reserve(uint32_t payloadSize);
+	void commit(LogRecordHeader*);
+
+	// writes everything that was logged so far, from the calling thread
+	void flush();
+	// stops the background thread after writing everything (registered with atexit)
+	void shutdown();
+	// last resort flush from a signal handler: formats what is still in the rings into a preallocated
+	// line and write(2)s it to the sinks' descriptors, no lock, no allocation, no stdio (best effort)
+	// the engine's only crash handler is FlightRecorder's, it calls this first (nothing happens before the backend exists)
+	static void flushFromSignal();
+
+	void addSink(std::unique_ptr<LogSink>);
+	// the steady_clock is what callers store in LogRecordHeader::timestamp (cheap and monotonic)
+	static int64_t now();
+	void setOverflowPolicy(LogOverflowPolicy);
+	uint64_t droppedRecords() const { return m_dropped.load(std::memory_order_relaxed); };
+
+	// bytes of every per-thread ring
+	static constexpr size_t RING_CAPACITY = 64 * 1024;
+	// rings flushFromSignal looks at (it can't allocate a bigger list), and the longest line it writes
+	static constexpr size_t MAX_SIGNAL_RINGS = 64;
+	static constexpr size_t SIGNAL_LINE_SIZE = 2048;
+
+private:
+	LogBackend();
+	void start();
+	void run();
+	// consumes all rings once, returns the amount of records written
+	size_t drain();
+	LogRingBuffer* threadRing();
+	std::string format(const LogRecordHeader&);
+
+	std::mutex m_ringsMutex;
+	std::vector<std::unique_ptr<LogRingBuffer>> m_rings;
+
+	// only one consumer at a time may read the rings
+	std::mutex m_drainMutex;
+	std::vector<std::unique_ptr<LogSink>> m_sinks;
+
+	// drain's scratch lists (guarded by m_drainMutex), kept between drains so the
+	// logging thread doesn't allocate every time it wakes up to find nothing
+	struct PendingRecord {
+		uint64_t sequence;
+		const LogRecordHeader* record;
+	};
+	struct ConsumedRing {
+		LogRingBuffer* ring;
+		uint64_t end;
+	};
+	std::vector<PendingRecord> m_pending;
+	std::vector<ConsumedRing> m_consumed;
+
+	std::thread m_thread;
+	std::mutex m_wakeMutex;
+	std::condition_variable m_wake;
+	std::atomic<bool> m_running{ false };
+
+	// wall time = steady time + offset, measured once when the backend starts
+	int64_t m_clockOffset = 0;
+	std::atomic<uint64_t> m_sequence{ 0 };
+	std::atomic<uint64_t> m_dropped{ 0 };
+	uint64_t m_reportedDropped = 0;
+	std::atomic<LogOverflowPolicy> m_policy{ LogOverflowPolicy::Drop };
+	// allocated up front, flushFromSignal can't
+	char m_signalLine[SIGNAL_LINE_SIZE];
+};
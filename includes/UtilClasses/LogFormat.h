@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// encoding of LOG_* arguments
+// -----------------------------
+// the caller doesn't turn its arguments into text, it copies their raw bytes behind a one byte tag:
+//   integers/enums -> Int64/UInt64 (8 bytes), floats -> Double (8 bytes), bool/char -> 1 byte,
+//   pointers -> Pointer (8 bytes), strings -> Length (4 bytes) + the characters
+// the logging thread walks the format string and decodes one argument per "{}"
+
+enum class LogArgType : uint8_t {
+	Int64,
+	UInt64,
+	Double,
+	Bool,
+	Char,
+	Pointer,
+	String,
+};
+
+namespace LogArgs {
+
+	template<typename T>
+	using Decayed = std::decay_t<T>;
+
+	template<typename T>
+	constexpr bool isString = std::is_same_v<Decayed<T>, const char*> || std::is_same_v<Decayed<T>, char*>
+		|| std::is_same_v<Decayed<T>, std::string> || std::is_same_v<Decayed<T>, std::string_view>;
+
+	inline std::string_view asStringView(const char* value) { return value ? std::string_view(value) : std::string_view("(null)"); };
+	inline std::string_view asStringView(const std::string& value) { return value; };
+	inline std::string_view asStringView(std::string_view value) { return value; };
+
+	// bytes the argument takes in the record (tag included)
+	template<typename T>
+	inline size_t encodedSize(const T& value)
+	{
+		using U = Decayed<T>;
+		if constexpr (isString<T>)
+			return 1 + sizeof(uint32_t) + asStringView(value).size();
+		else if constexpr (std::is_same_v<U, bool> || std::is_same_v<U, char>)
+			return 2;
+		else if constexpr (std::is_arithmetic_v<U> || std::is_enum_v<U> || std::is_pointer_v<U>)
+			return 1 + 8;
+		else
+			static_assert(std::is_arithmetic_v<U>, "LOG_*: unsupported argument type (use numbers, bools, chars, pointers or strings)");
+		return 0;
+	};
+
+	template<typename T>
+	inline void write(char*& out, LogArgType type, const T& raw)
+	{
+		*out++ = (char)type;
+		std::memcpy(out, &raw, sizeof(T));
+		out += sizeof(T);
+	};
+
+	template<typename T>
+	inline void encode(char*& out, const T& value)
+	{
+		using U = Decayed<T>;
+		if constexpr (isString<T>)
+		{
+			std::string_view view = asStringView(value);
+			uint32_t length = (uint32_t)view.size();
+			write(out, LogArgType::String, length);
+			std::memcpy(out, view.data(), length);
+			out += length;
+		}
+		else if constexpr (std::is_same_v<U, bool>)
+		{
+			*out++ = (char)LogArgType::Bool;
+			*out++ = value ? 1 : 0;
+		}
+		else if constexpr (std::is_same_v<U, char>)
+		{
+			*out++ = (char)LogArgType::Char;
+			*out++ = value;
+		}
+		else if constexpr (std::is_floating_point_v<U>)
+		{
+			write(out, LogArgType::Double, (double)value);
+		}
+		else if constexpr (std::is_enum_v<U>)
+		{
+			write(out, LogArgType::Int64, (int64_t)value);
+		}
+		else if constexpr (std::is_pointer_v<U>)
+		{
+			write(out, LogArgType::Pointer, (uint64_t)(uintptr_t)value);
+		}
+		else if constexpr (std::is_signed_v<U>)
+		{
+			write(out, LogArgType::Int64, (int64_t)value);
+		}
+		else
+		{
+			write(out, LogArgType::UInt64, (uint64_t)value);
+		}
+	};
+}
+
+// replaces the "{}" of format with the encoded arguments (runs on the logging thread)
+std::string formatLogArguments(const char* format, const char* arguments, uint32_t size);
+// the same into a fixed buffer without allocating or touching stdio, for signal handlers
+// (doubles get a plain fixed point form instead of %g), cut at "capacity" bytes, returns the length
+size_t formatLogArguments(char* out, size_t capacity, const char* format, const char* arguments, uint32_t size);
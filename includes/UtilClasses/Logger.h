@@ -3,27 +3,101 @@
 #include <iostream>
 #include <map>
 #include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include "Defaults/config.h"
+#include "LogBackend.h"
+#include "LogFormat.h"
+#include "FlightRecorder.h"
 
 // if someone wishes to log something using the Logger class
 // they either pass a MESSAGE Macro or a 
 #define MESSAGE(msg) LoggerMessage(__FILE__ , __LINE__ , msg)
 
-struct LoggerMessage {
-    LoggerMessage(std::string fileName, int lineNumber, std::string message)
-    {
-        std::stringstream formatedMessage;
+// log levels
+// ------------
+// statements below LOG_COMPILE_LEVEL are removed by the preprocessor (their arguments aren't even evaluated),
+// statements above it are checked against the runtime level (Logger::setLevel) with a single relaxed load
+#define LOG_LEVEL_TRACE   0
+#define LOG_LEVEL_DEBUG   1
+#define LOG_LEVEL_INFO    2
+#define LOG_LEVEL_SUCCES  3
+#define LOG_LEVEL_WARNING 4
+#define LOG_LEVEL_ERROR   5
+#define LOG_LEVEL_OFF     6
+
+#ifndef LOG_COMPILE_LEVEL
+#ifdef NDEBUG
+#define LOG_COMPILE_LEVEL LOG_LEVEL_INFO
+#else
+#define LOG_COMPILE_LEVEL LOG_LEVEL_TRACE
+#endif
+#endif
+
+// the format string and the call site are stored once per statement in a static LogSite,
+// at runtime only the arguments are copied into the ring ("{}" is replaced on the logging thread)
+//      LOG_INFO("loaded {} meshes in {} ms", count, milliseconds);
+#define LOG_AT(level, color, fmt, ...) \
+    do { \
+        if (Logger::isEnabled(level)) { \
+            static constexpr LogSite logSite{ level, __FILE__, __LINE__, fmt, color }; \
+            Logger::write(logSite, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_TRACE
+#define LOG_TRACE(fmt, ...) LOG_AT(LogLevel::Trace, WHITE, fmt, ##__VA_ARGS__)
+#else
+#define LOG_TRACE(fmt, ...) ((void)0)
+#endif
 
-        auto now = std::chrono::system_clock::now();
-        std::time_t now_time = std::chrono::system_clock::to_time_t(now);
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(fmt, ...) LOG_AT(LogLevel::Debug, TURQUOISE, fmt, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(fmt, ...) ((void)0)
+#endif
 
-        formatedMessage << "[" << std::put_time(std::localtime(&now_time), "%Y-%m-%d %H:%M:%S") << "] ";
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(fmt, ...) LOG_AT(LogLevel::Info, BLUE, fmt, ##__VA_ARGS__)
+// same as LOG_INFO but with a different color, e.g. LOG_INFO_COLORED(PURPLE, "...")
+#define LOG_INFO_COLORED(color, fmt, ...) LOG_AT(LogLevel::Info, color, fmt, ##__VA_ARGS__)
+#else
+#define LOG_INFO(fmt, ...) ((void)0)
+#define LOG_INFO_COLORED(color, fmt, ...) ((void)0)
+#endif
 
-        formatedMessage << fileName << ":" << lineNumber << " " << message;
-        m_message = formatedMessage.str();
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_SUCCES
+#define LOG_SUCCES(fmt, ...) LOG_AT(LogLevel::Succes, GREEN, fmt, ##__VA_ARGS__)
+#else
+#define LOG_SUCCES(fmt, ...) ((void)0)
+#endif
 
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_WARNING
+#define LOG_WARNING(fmt, ...) LOG_AT(LogLevel::Warning, ORANGE, fmt, ##__VA_ARGS__)
+#else
+#define LOG_WARNING(fmt, ...) ((void)0)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(fmt, ...) LOG_AT(LogLevel::Error, RED, fmt, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(fmt, ...) ((void)0)
+#endif
+
+// only captures what's needed to build the line later on,
+// the time stamp, file and line are turned into text by the logging thread
+// (prefer the LOG_* macros, a LoggerMessage always builds its string even if nobody reads it)
+struct LoggerMessage {
+    LoggerMessage(const char* fileName, int lineNumber, std::string message)
+        : m_file(fileName), m_line(lineNumber), m_message(std::move(message)), m_time(std::chrono::steady_clock::now())
+    {
     };
+    const char* m_file;
+    int m_line;
     std::string m_message;
+    std::chrono::steady_clock::time_point m_time;
 };
 
 class Logger {
@@ -35,9 +109,62 @@ public:
     static void error(LoggerMessage, std::string=RED);
     static void print(std::string);
 
+    // blocks until every message logged so far reached the sinks
+    static void flush();
+    // also write all messages to a file that rotates after maxBytes (keeping maxFiles old files)
+    static void addFileSink(std::string path, size_t maxBytes = 10 * 1024 * 1024, int maxFiles = 5);
+    // what happens when a thread logs faster than the logging thread can write
+    static void setOverflowPolicy(LogOverflowPolicy);
+
+    // messages below this level are skipped at runtime (LOG_COMPILE_LEVEL still removes the ones below it entirely)
+    static void setLevel(LogLevel level) { m_level.store((uint8_t)level, std::memory_order_relaxed); };
+    static bool isEnabled(LogLevel level) { return (uint8_t)level >= m_level.load(std::memory_order_relaxed); };
+
+    // used by the LOG_* macros: copies the arguments behind the record, nothing is formatted here
+    template<typename... Args>
+    static void write(const LogSite& site, const Args&... args)
+    {
+        size_t payloadSize = (0 + ... + LogArgs::encodedSize(args));
+        LogRecordHeader* record = LogBackend::instance().reserve((uint32_t)payloadSize);
+        if (!record)
+        {
+            if (site.level >= LogLevel::Warning)
+                FlightRecorder::recordLog(site, nullptr, 0);
+            return;
+        }
+
+        record->kind = LogRecordKind::Format;
+        record->level = site.level;
+        record->site = &site;
+        record->file = site.file;
+        record->line = site.line;
+        record->timestamp = LogBackend::now();
+        if (m_colorsAvailable)
+        {
+            record->colorLength = (uint16_t)std::min(std::strlen(site.color), sizeof(record->color));
+            std::memcpy(record->color, site.color, record->colorLength);
+        }
+        if (record->payloadSize == payloadSize)
+        {
+            // unused when the statement has no arguments
+            [[maybe_unused]] char* out = record->payload();
+            (LogArgs::encode(out, args), ...);
+        }
+        else
+        {
+            // the arguments didn't fit (half a ring), the format string alone still tells what happened
+            record->payloadSize = 0;
+        }
+        if (site.level >= LogLevel::Warning)
+            FlightRecorder::recordLog(site, record->payload(), record->payloadSize);
+        LogBackend::instance().commit(record);
+    };
+
     static const bool m_colorsAvailable = true;
 
 private:
-    static void debugMessage(std::string, std::string);
+    inline static std::atomic<uint8_t> m_level{ (uint8_t)LogLevel::Info };
+
+    static void debugMessage(LogLevel, const LoggerMessage&, const std::string&);
     Logger();
-};
\ No newline at end of file
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+
+#include "HandlePool.h"
+
+// what a block of memory is used for, the first ones live on the GPU
+enum class MemoryCategory {
+    MESHES,         // vertex and index buffers
+    TEXTURES,       // texture storage (all mip levels)
+    PROGRAMS,       // linked shader programs
+    OBJECT_POOLS,   // the chunks of the ObjectPools (GameObject, Mesh, Material)
+    FRAME_ARENA,    // the FrameArena's arenas
+    OTHER,          // anything else that tags its memory
+    COUNT,
+};
+
+// one tracked allocation (a mesh's buffers, a texture, a pool, ...)
+struct MemoryRecord {
+    MemoryCategory category = MemoryCategory::OTHER;
+    std::string label;
+    size_t bytes = 0;
+};
+
+using MemoryHandle = Handle<MemoryRecord>;
+
+struct MemoryCategoryStats {
+    const char* name = nullptr;
+    bool gpu = false;
+    size_t bytes = 0;
+    size_t peakBytes = 0;
+    size_t records = 0;
+    // 0 => no budget
+    size_t budgetBytes = 0;
+};
+
+// how much memory the engine's resources use, per resource and per category
+// -------------------------------------------------------------------------
+// resources report their own size (TrackedMemory), the GL sizes are what we asked the driver for
+// (a driver may pad or keep extra copies), so these numbers are a lower bound of the real usage
+// every category and the GPU/CPU totals can have a budget, going over it logs a warning once
+// (until the usage drops below the budget again)
+//
+//   --memory-budget=textures:256 --memory-budget=gpu:1024   (in MB)
+class MemoryTracker {
+public:
+    static MemoryTracker& getInstance();
+
+    MemoryHandle track(MemoryCategory category, std::string label, size_t bytes);
+    void resize(MemoryHandle handle, size_t bytes);
+    void rename(MemoryHandle handle, std::string label);
+    void untrack(MemoryHandle handle);
+
+    void setBudget(MemoryCategory category, size_t bytes);
+    void setGpuBudget(size_t bytes);
+    void setCpuBudget(size_t bytes);
+    // "<category>:<MB>" with a category name (see categoryName) or "gpu"/"cpu", false when it isn't one
+    bool parseBudget(const std::string& budget);
+
+    MemoryCategoryStats getStats(MemoryCategory category);
+    size_t getGpuBytes();
+    size_t getCpuBytes();
+    size_t getGpuBudget();
+    size_t getCpuBudget();
+    // holds the tracker's lock, "function" can't track or untrack anything
+    void forEachRecord(const std::function<void(const MemoryRecord&)>& function);
+    // categories, totals and the largest records of every category
+    std::string toJson(size_t recordsPerCategory = 8);
+    bool writeJson(const std::string& path);
+
+    static const char* categoryName(MemoryCategory category);
+    static bool isGpu(MemoryCategory category);
+
+private:
+    MemoryTracker() {};
+    MemoryTracker(const MemoryTracker&) = delete;
+    MemoryTracker& operator=(const MemoryTracker&) = delete;
+
+    // with m_mutex held
+    void add(MemoryCategory category, size_t bytes);
+    void remove(MemoryCategory category, size_t bytes);
+    void checkBudgets(MemoryCategory category);
+
+    std::mutex m_mutex;
+    HandlePool<MemoryRecord> m_records;
+    size_t m_bytes[(size_t)MemoryCategory::COUNT] = {};
+    size_t m_peakBytes[(size_t)MemoryCategory::COUNT] = {};
+    size_t m_recordCount[(size_t)MemoryCategory::COUNT] = {};
+    size_t m_budgets[(size_t)MemoryCategory::COUNT] = {};
+    bool m_overBudget[(size_t)MemoryCategory::COUNT] = {};
+    size_t m_gpuBudget = 0;
+    size_t m_cpuBudget = 0;
+    bool m_gpuOverBudget = false;
+    bool m_cpuOverBudget = false;
+};
+
+// a MemoryTracker record that goes away with its owner (Mesh, Texture2D, Shader, ObjectPool, ...)
+// move-only like the GLObjects it usually sits next to
+class TrackedMemory {
+public:
+    TrackedMemory() {};
+    ~TrackedMemory() { reset(); };
+    TrackedMemory(const TrackedMemory&) = delete;
+    TrackedMemory& operator=(const TrackedMemory&) = delete;
+    TrackedMemory(TrackedMemory&& other) noexcept : m_handle(other.m_handle) { other.m_handle = MemoryHandle(); };
+    TrackedMemory& operator=(TrackedMemory&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            m_handle = other.m_handle;
+            other.m_handle = MemoryHandle();
+        }
+        return *this;
+    };
+
+    // the first call creates the record, later calls only change its size
+    void track(MemoryCategory category, std::string label, size_t bytes);
+    void setLabel(std::string label);
+    void reset();
+
+private:
+    MemoryHandle m_handle;
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "MemoryTracker.h"
+
+struct ObjectPoolStats {
+    std::string name;
+    // objects alive right now and the most that were ever alive at once
+    size_t live = 0;
+    size_t highWater = 0;
+    // slots in all chunks, live or free
+    size_t capacity = 0;
+    size_t chunks = 0;
+    uint64_t allocations = 0;
+};
+
+// slots of one size in chunks that never move or shrink
+// -----------------------------------------------------
+// a free slot stores the pointer to the next free slot, allocating and freeing is popping and pushing that list
+// so creating and destroying objects over and over reuses the same memory instead of fragmenting the heap
+class FixedSizePool {
+public:
+    FixedSizePool(size_t slotSize, size_t slotsPerChunk);
+    ~FixedSizePool();
+    FixedSizePool(const FixedSizePool&) = delete;
+    FixedSizePool& operator=(const FixedSizePool&) = delete;
+
+    void* allocate();
+    void deallocate(void* slot);
+
+    size_t slotSize() const { return m_slotSize; };
+    size_t live() const { return m_live; };
+    size_t highWater() const { return m_highWater; };
+    size_t capacity() const { return m_chunks.size() * m_slotsPerChunk; };
+    size_t chunks() const { return m_chunks.size(); };
+    size_t bytes() const { return m_chunks.size() * m_slotsPerChunk * m_slotSize; };
+
+private:
+    struct FreeSlot {
+        FreeSlot* next;
+    };
+    void addChunk();
+
+    size_t m_slotSize;
+    size_t m_slotsPerChunk;
+    std::vector<std::byte*> m_chunks;
+    FreeSlot* m_free = nullptr;
+    size_t m_live = 0;
+    size_t m_highWater = 0;
+};
+
+// the memory of one class and everything deriving from it
+// --------------------------------------------------------
+// a class hands its operator new/delete to a pool (see GameObject, Mesh, Material), so every
+// "new Sphere(...)" takes a slot here and "delete" gives it back, the objects never move
+// derived classes differ in size, every size (rounded up to 16 bytes) gets its own FixedSizePool
+// every pool registers itself so the sizes and high-water marks can be reported (forEachPool)
+class ObjectPool {
+public:
+    static constexpr size_t CHUNK_BYTES = 16 * 1024;
+
+    explicit ObjectPool(std::string name);
+    ~ObjectPool();
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    void* allocate(size_t size);
+    void deallocate(void* object, size_t size);
+
+    ObjectPoolStats getStats();
+    static void forEachPool(const std::function<void(ObjectPool&)>& function);
+
+private:
+    FixedSizePool& poolFor(size_t size);
+
+    std::string m_name;
+    std::mutex m_mutex;
+    // (slot size, pool), a class has only a handful of sizes
+    std::vector<std::pair<size_t, std::unique_ptr<FixedSizePool>>> m_sizes;
+    size_t m_live = 0;
+    size_t m_highWater = 0;
+    uint64_t m_allocations = 0;
+    // the bytes of all chunks (MemoryTracker)
+    size_t m_chunkBytes = 0;
+    TrackedMemory m_memory;
+};
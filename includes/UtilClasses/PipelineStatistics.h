@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+
+#include "glad/glad.h"
+
+#include "GLObject.h"
+#include "RenderStats.h"
+
+// what the GPU did with the draws of a frame, counted by the GPU itself
+// ---------------------------------------------------------------------
+// https://registry.khronos.org/OpenGL/extensions/ARB/ARB_pipeline_statistics_query.txt
+// core since OpenGL 4.6, we ask for a 3.3 context so it is either the extension or a driver that gives us 4.6 anyway
+// a frame (swap to swap) is wrapped in one query per counter, RenderStats counts what we asked for
+// and these count what actually ran: vertex shader invocations show how well the post transform cache does,
+// the clipping primitives how much the culling left for the GPU to throw away, fragment shader invocations the overdraw
+// the results arrive a few frames late, a frame's queries are only read once they are available (never waits on the GPU)
+// and when all FRAMES are still in flight a frame goes unmeasured
+// frameBoundary runs on the thread that owns the context, latest on any
+class PipelineStatistics {
+public:
+    static PipelineStatistics& getInstance();
+
+    static constexpr size_t FRAMES = 4;
+    static constexpr size_t COUNTERS = 6;
+
+    // checks what the driver supports, after GLAD was loaded
+    void init();
+    bool isSupported() const { return m_supported; };
+
+    // after a swap (see Game::presented): ends the frame's queries, reads the finished ones and starts the next frame's
+    void frameBoundary();
+    // the newest finished frame, available is false until there is one
+    PipelineStatisticsCounts latest();
+    // gives the query objects back while there is a context
+    void shutdown();
+
+private:
+    PipelineStatistics() {};
+    PipelineStatistics(const PipelineStatistics&) = delete;
+    PipelineStatistics& operator=(const PipelineStatistics&) = delete;
+
+    struct Frame {
+        GLQuery queries[COUNTERS];
+        bool pending = false;
+    };
+
+    bool m_supported = false;
+    // the queries of m_frames[m_current] are running
+    bool m_active = false;
+    size_t m_current = 0;
+    Frame m_frames[FRAMES];
+
+    std::mutex m_mutex;
+    PipelineStatisticsCounts m_latest;
+};
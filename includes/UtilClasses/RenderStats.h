@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+
+#include "glad/glad.h"
+
+// what the GPU itself counted for a frame (pipeline statistics queries, see PipelineStatistics)
+struct PipelineStatisticsCounts {
+	// false when the driver has no pipeline statistics queries (or none finished yet)
+	bool available = false;
+	uint64_t verticesSubmitted = 0;
+	uint64_t primitivesSubmitted = 0;
+	uint64_t vertexShaderInvocations = 0;
+	uint64_t fragmentShaderInvocations = 0;
+	uint64_t clippingInputPrimitives = 0;
+	uint64_t clippingOutputPrimitives = 0;
+};
+
+// per-frame counters of the work we hand to OpenGL
+// every draw reports here when it is recorded (Scene::record, Scene::drawMeshes, Mesh::draw), so the numbers
+// are exactly what the driver received this frame (not what the scene contains)
+struct FrameRenderStats {
+	uint64_t drawCalls = 0;
+	// nothing draws instanced yet, every draw is one instance
+	uint64_t instances = 0;
+	uint64_t triangles = 0;
+	uint64_t vertices = 0;
+	// state changes: glUseProgram, glBindVertexArray, glBindTexture
+	uint64_t programBinds = 0;
+	uint64_t vertexArrayBinds = 0;
+	uint64_t textureBinds = 0;
+	// glUniform* calls of the draws (camera matrices per program, the model matrix per draw)
+	uint64_t uniformUploads = 0;
+	// bytes copied from the CPU into buffers and textures (meshes, streamed mip levels)
+	uint64_t uploadBytes = 0;
+	// objects the culling left out of the draw lists
+	uint64_t culledObjects = 0;
+	// model matrices rebuilt by TransformStorage::updateModelMatrices and how long that took
+	uint64_t transformsUpdated = 0;
+	double transformUpdateMs = 0.0;
+	// heap allocations during the frame, only counted while the AllocationTracker is enabled
+	uint64_t allocations = 0;
+	uint64_t allocatedBytes = 0;
+	// of an earlier frame, the queries are read once the GPU is done with them
+	PipelineStatisticsCounts pipeline;
+};
+
+// the counters by name, for the overlay and the benchmark JSON
+enum class RenderCounter {
+	DRAW_CALLS,
+	INSTANCES,
+	TRIANGLES,
+	VERTICES,
+	PROGRAM_BINDS,
+	VERTEX_ARRAY_BINDS,
+	TEXTURE_BINDS,
+	UNIFORM_UPLOADS,
+	UPLOAD_BYTES,
+	CULLED_OBJECTS,
+	// from here on only valid when pipeline.available is
+	VERTICES_SUBMITTED,
+	PRIMITIVES_SUBMITTED,
+	VERTEX_SHADER_INVOCATIONS,
+	FRAGMENT_SHADER_INVOCATIONS,
+	CLIPPING_INPUT_PRIMITIVES,
+	CLIPPING_OUTPUT_PRIMITIVES,
+	COUNT,
+};
+
+class RenderStats {
+public:
+	// resets the counters of the current frame (call once at the start of a frame)
+	static void beginFrame();
+	// registers a single glDraw* call with its primitive mode and amount of vertices/indices
+	static void recordDraw(GLenum mode, uint64_t count, uint64_t instances = 1);
+	static void recordProgramBind() { m_current.programBinds++; };
+	static void recordVertexArrayBind() { m_current.vertexArrayBinds++; };
+	static void recordTextureBind() { m_current.textureBinds++; };
+	static void recordUniformUploads(uint64_t count) { m_current.uniformUploads += count; };
+	static void recordUpload(uint64_t bytes) { m_current.uploadBytes += bytes; };
+	static void recordCulled(uint64_t count) { m_current.culledObjects += count; };
+	// the newest finished pipeline statistics queries
+	static void recordPipelineStatistics(const PipelineStatisticsCounts& counts) { m_current.pipeline = counts; };
+	// registers a batch of rebuilt model matrices
+	static void recordTransformUpdate(uint64_t count, double milliseconds);
+	// registers what the AllocationTracker counted for the frame
+	static void recordAllocations(uint64_t count, uint64_t bytes);
+
+	static const FrameRenderStats& current();
+	// the frame before the current one, complete (the overlay runs while the current one is still counting)
+	static const FrameRenderStats& last();
+
+	static const char* counterName(RenderCounter counter);
+	static uint64_t counterValue(const FrameRenderStats& stats, RenderCounter counter);
+	static bool isPipelineCounter(RenderCounter counter) { return counter >= RenderCounter::VERTICES_SUBMITTED; };
+
+private:
+	RenderStats() {};
+	static FrameRenderStats m_current;
+	static FrameRenderStats m_last;
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "glad/glad.h"
+#include "GLFW/glfw3.h"
+#include "imgui.h"
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+
+// one draw of a recorded frame, only GL names and copies so the render thread never
+// has to look at a Scene, GameObject or Mesh that the main thread may be changing (or deleting)
+struct DrawPacket {
+    glm::mat4 model;
+    // shaders live in the ResourceManager and are only (re)compiled on the render thread
+    Shader* shader;
+    // the mesh's arena and where the mesh starts in it (see GpuBufferArenas)
+    unsigned int vertexArray;
+    unsigned int firstIndex;
+    int baseVertex;
+    unsigned int count;
+    bool indexed;
+    bool drawTriangles;
+};
+
+// a scene's camera and its draws, already in the order Scene::buildDrawList sorted them in
+struct SceneCommands {
+    glm::mat4 view;
+    glm::mat4 projection;
+    std::vector<DrawPacket> packets;
+};
+
+// everything the render thread needs to draw one frame
+struct FrameCommands {
+    glm::vec4 clearColor = glm::vec4(0.1f, 0.1f, 0.1f, 1.0f);
+    // only the first "sceneCount" are part of the frame, the rest keep their memory for later frames
+    std::vector<SceneCommands> scenes;
+    size_t sceneCount = 0;
+    // a copy of ImGui's draw data, ImGui reuses its own draw lists as soon as the next frame starts
+    ImDrawData ui;
+    bool hasUI = false;
+    // FramePacer::now() of the oldest input this frame applied (-1 = none), see Game::latchInput
+    double inputTime = -1.0;
+
+    SceneCommands& addScene();
+    // copies the draw lists of ImGui::GetDrawData() into "ui"
+    void copyUI(const ImDrawData* drawData);
+    void clear();
+};
+
+// a thread that owns the GL context and replays the frames the main thread records
+// --------------------------------------------------------------------------------
+// the main thread keeps GLFW (events, callbacks) and the game logic, the render thread does every
+// GL call: while it submits frame N the main thread already runs the TaskGraph of frame N+1
+// frames are double buffered, recording a frame waits until the render thread is done with the
+// buffer it used 2 frames ago, so the main thread never gets more than one frame ahead
+//
+// frames and other GL work (run/runSync) go into a single queue and are executed in order,
+// so a mesh deleted after a frame was submitted only loses its buffers after that frame was drawn
+// while the thread isn't running run/runSync call the function right away (the caller owns the context then)
+class RenderThread {
+public:
+    static RenderThread& getInstance();
+
+    // moves the window's GL context from the calling thread to the render thread
+    void start(GLFWwindow* window);
+    // replays what is still queued and hands the context back to the calling thread
+    void stop();
+    ~RenderThread();
+    bool isRunning() const { return m_running; };
+    bool isRenderThread() const;
+
+    // queues GL work behind everything submitted so far
+    void run(std::function<void()> command);
+    // same, but waits until it ran (for results the caller needs, e.g. glGetProgramiv)
+    void runSync(std::function<void()> command);
+
+    // recording frames only makes sense while the thread runs, otherwise Scene::submit draws directly
+    // the buffer of the next frame, cleared and free to fill (waits while it's still being replayed)
+    FrameCommands& beginFrame();
+    // the frame between beginFrame and submitFrame
+    FrameCommands& recordingFrame() { return m_frames[m_recording]; };
+    // queues the recorded frame, the render thread draws it and swaps the buffers
+    void submitFrame();
+
+    // called on the render thread right after every swap with the frame's inputTime (set it before start)
+    void setSwapCallback(std::function<void(double inputTime)> callback) { m_onSwap = std::move(callback); };
+
+    uint64_t getFramesReplayed() const { return m_framesReplayed; };
+    // how long the render thread took for its last frame (GL calls + swap)
+    double getLastReplayMilliseconds() const { return m_lastReplayMs; };
+
+private:
+    RenderThread() {};
+    void loop();
+    void replay(FrameCommands& frame);
+
+    GLFWwindow* m_window = nullptr;
+    std::thread m_thread;
+    std::atomic<bool> m_running{ false };
+
+    std::mutex m_mutex;
+    std::condition_variable m_commandQueued;
+    std::condition_variable m_frameReplayed;
+    std::deque<std::function<void()>> m_commands;
+    bool m_stopping = false;
+
+    FrameCommands m_frames[2];
+    // guarded by m_mutex, true from submitFrame until the render thread finished the frame
+    bool m_frameBusy[2] = { false, false };
+    int m_recording = 0;
+
+    std::function<void(double)> m_onSwap;
+    std::atomic<uint64_t> m_framesReplayed{ 0 };
+    std::atomic<double> m_lastReplayMs{ 0.0 };
+};
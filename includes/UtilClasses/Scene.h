@@ -3,20 +3,48 @@
 #include "GameObject.h"
 #include "Camera.h"
 #include "Logger.h"
+#include "EntityWorld.h"
+#include "Components.h"
+#include "Frustum.h"
+#include "DrawCommandList.h"
+#include "RenderThread.h"
 #include <map>
+#include <unordered_map>
 
+// a Scene keeps its objects twice: by name (for the UI and lookups) and as entities
+// in an EntityWorld, which is what the per frame systems (bounds, rendering) iterate over
 class Scene {
 public:
     Scene();
     Scene(Camera*);
+    ~Scene();
+    // a name that is already taken replaces the object that had it
     void addGameObject(std::string,GameObject* obj);
+    // takes the object out of the scene (the object itself is not deleted)
+    void removeGameObject(GameObject* obj);
+    // takes the object out of the scene and deletes it (with the mesh and material it made), its memory goes back to the pool
+    void destroyGameObject(GameObject* obj);
     std::map<std::string, GameObject*>* getGameObjects();
+    EntityWorld& getWorld() { return m_world; };
+    // sets what an entity draws, gives mesh and material a number in the scene's tables when they are new
+    void updateRenderer(Entity, Mesh*, Material*, bool drawTriangles);
 
     void setCamera(Camera* cam);
     Camera * getCamera();
-    // The main rendering pass
+    // The main rendering pass (cull + buildDrawList + submit on the calling thread)
     void renderScene(); 
 
+    // the rendering pass split up in the steps of the frame's TaskGraph
+    // cull and buildDrawList spread their work over the JobSystem, only submit touches OpenGL
+    // so only submit has to run on the main thread
+    // buildDrawList records a DrawCommandList per thread, sorts and merges them, submit replays the result
+    // the transforms come from the TransformStorage or, with a simulation thread, from its interpolated snapshot
+    void cull(const TransformSnapshot* snapshot = nullptr);
+    void buildDrawList(const TransformSnapshot* snapshot = nullptr);
+    void submit();
+    // with a render thread submit is replaced by this, it copies what submit would draw into "commands"
+    void record(SceneCommands& commands);
+
     bool isActive;
 
     // For handling FBOs (Framebuffer Objects)
@@ -27,6 +55,25 @@ public:
 
 
 private:
+    // systems
+    // copies the world bounds of every entity out of the transforms
+    // and marks the ones outside the camera's frustum as invisible
+    template<typename Transforms>
+    void cullBounds(const Transforms&, const Frustum&);
+    // packs every visible entity into the draw list of the thread that visits it
+    template<typename Transforms>
+    void recordDrawLists(const Transforms&);
+    // replays the merged draw lists
+    void drawMeshes(const glm::mat4& view, const glm::mat4& projection);
+
+    // one draw list per JobSystem thread, so the threads never have to share one
+    std::vector<DrawCommandList> m_drawLists;
+    std::vector<DrawCommandRef> m_submitOrder;
+    // every mesh and material that was ever drawn in this scene gets a number (only grows)
+    std::vector<Material*> m_materials;
+    std::unordered_map<const Material*, uint32_t> m_materialIndices;
+    std::unordered_map<const Mesh*, uint32_t> m_meshIndices;
     std::map<std::string, GameObject*> m_gameObjects;
+    EntityWorld m_world;
     Camera* m_camera;
 };
\ No newline at end of file
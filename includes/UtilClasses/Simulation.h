@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "TransformStorage.h"
+
+// a fixed timestep simulation on its own thread
+// ----------------------------------------------
+// the simulation advances in ticks of exactly 1 / tickRate seconds, no matter how fast the frames are
+// after every tick it copies the world matrices into one of 3 snapshots (triple buffering):
+//   previous tick | newest tick | the one being written
+// the renderer never reads the TransformStorage, it blends the two newest snapshots depending on how
+// far the current frame is between them (so a 30Hz simulation still moves smoothly at 144 fps)
+// https://gafferongames.com/post/fix_your_timestep/
+//
+// while the thread runs only the simulation may touch the TransformStorage (and GameObject transforms),
+// code on the main thread that has to (the UI) holds lockWorld() while doing so
+class Simulation {
+public:
+    Simulation() {};
+    ~Simulation();
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+    void setTickRate(float ticksPerSecond);
+    float getTickRate() const { return 1.0f / m_tickSeconds; };
+
+    // called once per tick with the fixed step (in seconds) and the total simulated time
+    // systems run on the simulation thread, they may move transforms but should not touch GL or the ECS
+    void addSystem(std::function<void(float dt, double time)> system);
+
+    void start();
+    void stop();
+    bool isRunning() const { return m_running; };
+
+    // blocks the simulation between two ticks for as long as the lock lives
+    std::unique_lock<std::mutex> lockWorld() { return std::unique_lock<std::mutex>(m_worldMutex); };
+
+    // blends the two newest snapshots for a frame at "now" (one tick behind the simulation)
+    // and returns the result, also what getRenderTransforms() returns until the next call
+    // runs on the JobSystem threads, call it once per frame before anything reads the transforms
+    const TransformSnapshot& interpolate();
+    // nullptr while the simulation thread isn't running (the renderer reads the TransformStorage then)
+    const TransformSnapshot* getRenderTransforms() const { return m_running ? &m_render : nullptr; };
+
+    uint64_t getTickCount() const { return m_tick; };
+    // ticks that were skipped because the simulation couldn't keep up (see run)
+    uint64_t getDroppedTicks() const { return m_droppedTicks; };
+
+private:
+    void run();
+    // one step of all systems, "scheduledTime" is when the tick should have run (seconds since start())
+    void tick(double scheduledTime);
+    // the snapshot the next tick writes, waits while the renderer is still blending it
+    TransformSnapshot& acquireWriteSnapshot();
+    void publish();
+    double secondsSinceStart() const;
+
+    float m_tickSeconds = 1.0f / 60.0f;
+    std::vector<std::function<void(float, double)>> m_systems;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{ false };
+    std::mutex m_worldMutex;
+    std::chrono::steady_clock::time_point m_startTime;
+    std::atomic<uint64_t> m_tick{ 0 };
+    std::atomic<uint64_t> m_droppedTicks{ 0 };
+
+    // triple buffer, indices into m_snapshots, all of them guarded by m_snapshotMutex
+    TransformSnapshot m_snapshots[3];
+    std::mutex m_snapshotMutex;
+    std::condition_variable m_snapshotReleased;
+    int m_previous = -1;
+    int m_newest = -1;
+    int m_writing = 0;
+    // the two snapshots interpolate() is reading from right now (-1 = none)
+    int m_pinned[2] = { -1, -1 };
+
+    // what the renderer reads this frame
+    TransformSnapshot m_render;
+};
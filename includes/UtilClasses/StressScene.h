@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Scene.h"
+#include "Camera.h"
+#include "GameObject.h"
+#include "ObjectPool.h"
+#include "AllocationTracker.h"
+#include "MemoryTracker.h"
+#include "GpuBufferArena.h"
+#include "RenderStats.h"
+
+class Game;
+
+// how the generated objects move every frame
+enum class MotionPattern {
+	STATIC,	// objects never move (measures pure submission cost)
+	ORBIT,	// objects circle around the world Y-axis
+	BOB,	// objects move up and down on a sine wave
+	SPIN,	// objects rotate around their own axis
+};
+
+// how the camera moves every frame
+enum class CameraPath {
+	STATIC,		// camera stays at its start position
+	ORBIT,		// camera circles around the center of the scene
+	FLYTHROUGH,	// camera follows a lissajous curve through the scene
+};
+
+// everything that describes a stress run, a run is fully determined by this struct
+// so two runs with the same config (and seed) produce the exact same scene and camera path
+struct StressSceneConfig {
+	uint32_t seed = 1337;
+	// object counts
+	int sphereCount = 200;
+	int cubeCount = 200;
+	int axisCount = 10;
+	// tessellation of every generated sphere
+	int sphereLongitudes = 20;
+	int sphereLatitudes = 20;
+	// objects are spawned uniformly inside a cube of [-spawnExtent, spawnExtent]
+	float spawnExtent = 40.0f;
+	// objects are chained into parent/child assemblies of this many objects (1 => no hierarchy)
+	int hierarchyDepth = 1;
+	MotionPattern motion = MotionPattern::ORBIT;
+	float motionSpeed = 1.0f;
+	CameraPath cameraPath = CameraPath::ORBIT;
+	float cameraRadius = 80.0f;
+	float cameraSpeed = 0.25f;
+	// frames that are rendered but not measured (driver warm-up, shader compilation, etc...)
+	int warmupFrames = 30;
+	int frameCount = 600;
+	// waits for the GPU after every frame so frame times include the GPU work
+	bool gpuSync = true;
+	// where the JSON report goes (empty => stdout only)
+	std::string outputPath;
+	// a previous report to compare against (empty => no comparison)
+	std::string baselinePath;
+	// allowed slowdown relative to the baseline before we call it a regression (0.10 => 10%)
+	double regressionTolerance = 0.10;
+	// > 0 moves the objects on the simulation thread at this many ticks per second
+	// (frames are no longer identical between runs then, the camera still follows the frame count)
+	float simulationRate = 0.0f;
+	// the measured frames must not allocate (needs the AllocationTracker, main enables it for --alloc-check=1)
+	bool allocCheck = false;
+
+	// true when the command line asks for a stress run (--stress)
+	static bool requested(int argc, char** argv);
+	// parses --key=value arguments, unknown keys are reported and ignored
+	static StressSceneConfig fromArgs(int argc, char** argv);
+};
+
+// fills a Scene with a deterministic set of objects and animates them
+class StressSceneGenerator {
+public:
+	StressSceneGenerator(const StressSceneConfig&);
+
+	// creates all objects and adds them to the scene, also attaches the camera
+	void populate(Scene&, Camera&);
+	// destroys every object populate() created (their memory goes back to the pools)
+	void clear(Scene&);
+	// moves all generated objects and the camera to where they should be at "time" (seconds)
+	void animate(float time);
+	void animateObjects(float time);
+	void animateCamera(float time);
+
+private:
+	// per object parameters we need to replay the motion pattern
+	struct Animated {
+		GameObject* object;
+		glm::vec3 origin;
+		float phase;
+		float speed;
+	};
+
+	// a float in [0, 1) that is identical on every platform
+	// (std::uniform_real_distribution is implementation defined, std::mt19937 is not)
+	float random01();
+	float randomRange(float, float);
+
+	StressSceneConfig m_config;
+	std::mt19937 m_random;
+	std::vector<Animated> m_objects;
+	Camera* m_camera = nullptr;
+};
+
+// summary of the measured frames
+struct FrameTimeReport {
+	int frames = 0;
+	double minMs = 0.0;
+	double meanMs = 0.0;
+	double p50Ms = 0.0;
+	double p95Ms = 0.0;
+	double p99Ms = 0.0;
+	double maxMs = 0.0;
+	double drawCallsPerFrame = 0.0;
+	double trianglesPerFrame = 0.0;
+	// time spent rebuilding model matrices (TransformStorage::updateModelMatrices)
+	double transformUpdateMs = 0.0;
+	double transformsPerFrame = 0.0;
+	// ticks the simulation thread ran during the run and how many it had to skip
+	uint64_t simulationTicks = 0;
+	uint64_t droppedTicks = 0;
+	// the object pools after the scene was cleared (live should be back to 0)
+	std::vector<ObjectPoolStats> pools;
+	// every MemoryTracker category while the scene was still there
+	std::vector<MemoryCategoryStats> memory;
+	// the mesh arenas at the same moment (size, fragmentation, compaction)
+	GpuBufferArenaStats meshArenas;
+	// every RenderStats counter per frame, the pipeline statistics only when the driver had them
+	double counters[(size_t)RenderCounter::COUNT] = {};
+	bool pipelineStatistics = false;
+	// with --alloc-check=1: measured frames that allocated and the most one of them did
+	bool allocationsTracked = false;
+	int allocatingFrames = 0;
+	uint64_t maxAllocationsPerFrame = 0;
+	std::vector<AllocationZoneStats> allocationZones;
+
+	static FrameTimeReport fromSamples(std::vector<double> frameTimesMs, double drawCalls, double triangles);
+	std::string toJson(const StressSceneConfig&) const;
+};
+
+// runs a stress scene for a fixed number of frames and reports the frame times
+// the return value of run() is meant to be used as the process exit code:
+// 0 => ok, 1 => regression against the baseline, 2 => the run itself failed,
+// 3 => a measured frame allocated (only with --alloc-check=1)
+class StressHarness {
+public:
+	StressHarness(const StressSceneConfig&);
+	int run(Game&, Scene&, Camera&);
+
+private:
+	// compares against the baseline file, returns true if any metric regressed
+	bool compareWithBaseline(const FrameTimeReport&);
+
+	StressSceneConfig m_config;
+};
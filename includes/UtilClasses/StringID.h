@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// a string hashed to a 64 bit number (FNV-1a), comparing or looking up an id is comparing two integers
+// -----------------------------------------------------------------------------------------------------
+// literals are hashed by the compiler: "model"_sid or StringID("model") in a constexpr context never
+// touch the string at runtime, names that only exist at runtime (files, UI labels) go through intern()
+// http://www.isthe.com/chongo/tech/comp/fnv/index.html
+//
+// in debug builds intern() remembers the name behind every id so lookup() can print it, and logs an
+// error when two different names end up with the same id (with 64 bits that should never happen,
+// but when it does the two things would silently share a slot), release builds only keep the numbers
+class StringID {
+public:
+    constexpr StringID() : m_hash(0) {};
+    constexpr StringID(const char* string, size_t length) : m_hash(hash(string, length)) {};
+    constexpr explicit StringID(const char* string) : m_hash(hash(string, length(string))) {};
+    explicit StringID(std::string_view string) : m_hash(hash(string.data(), string.size())) {};
+
+    // hashes a runtime name and (in debug builds) registers it for lookup and collision checks
+    static StringID intern(std::string_view name);
+    // the name behind an id, only known in debug builds and only for interned names ("#<hash>" otherwise)
+    static std::string lookup(StringID id);
+
+    constexpr uint64_t value() const { return m_hash; };
+    constexpr bool valid() const { return m_hash != 0; };
+    constexpr bool operator==(const StringID& other) const { return m_hash == other.m_hash; };
+    constexpr bool operator!=(const StringID& other) const { return m_hash != other.m_hash; };
+    constexpr bool operator<(const StringID& other) const { return m_hash < other.m_hash; };
+
+    static constexpr uint64_t hash(const char* string, size_t length)
+    {
+        uint64_t result = 14695981039346656037ull;
+        for (size_t i = 0; i < length; i++)
+        {
+            result ^= (uint64_t)(unsigned char)string[i];
+            result *= 1099511628211ull;
+        }
+        return result;
+    };
+
+private:
+    static constexpr size_t length(const char* string)
+    {
+        size_t count = 0;
+        while (string[count] != '\0')
+            count++;
+        return count;
+    };
+
+    uint64_t m_hash;
+};
+
+constexpr StringID operator""_sid(const char* string, size_t length)
+{
+    return StringID(string, length);
+};
+
+// already a good hash, so unordered containers can use it as is
+template<>
+struct std::hash<StringID> {
+    size_t operator()(const StringID& id) const { return (size_t)id.value(); };
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// where a task is allowed to run
+enum class TaskAffinity {
+    // any thread of the JobSystem
+    ANY,
+    // only the thread that owns the GL context (everything that calls gl* or ImGui)
+    MAIN_THREAD,
+};
+
+using TaskId = uint32_t;
+
+// a set of tasks and what they depend on, executed once per frame
+// -----------------------------------------------------------------
+// a task starts as soon as all tasks it depends on are finished, tasks that don't depend on each
+// other run at the same time on the JobSystem workers
+// the graph is built once and executed every frame, only the functions run again
+//
+//   update -> transforms -> cull -> draw lists -> submit (main thread)
+class TaskGraph {
+public:
+    TaskId add(std::string name, std::function<void()> function, std::initializer_list<TaskId> dependsOn = {}, TaskAffinity affinity = TaskAffinity::ANY);
+    // runs every task once and returns when all of them are done, has to be called on the main thread
+    // (MAIN_THREAD tasks are run by the caller while it waits)
+    void execute();
+    void clear();
+
+    size_t size() const { return m_tasks.size(); };
+    const std::string& getName(TaskId task) const { return m_tasks[task]->name; };
+    // how long the task took during the last execute()
+    double getMilliseconds(TaskId task) const { return m_tasks[task]->milliseconds; };
+
+private:
+    struct Task {
+        std::string name;
+        std::function<void()> function;
+        TaskAffinity affinity;
+        std::vector<TaskId> dependents;
+        uint32_t dependencyCount = 0;
+        // dependencies that aren't finished yet during execute()
+        std::atomic<uint32_t> waitingFor{ 0 };
+        double milliseconds = 0.0;
+        // the task's allocations count for a zone with its name (see AllocationTracker)
+        uint16_t zone = 0;
+    };
+
+    void schedule(TaskId);
+    void runTask(TaskId);
+
+    // unique_ptr because of the atomic (tasks never move once added)
+    std::vector<std::unique_ptr<Task>> m_tasks;
+    std::atomic<uint32_t> m_unfinished{ 0 };
+
+    // MAIN_THREAD tasks whose dependencies are done, picked up by execute()
+    std::mutex m_mainThreadMutex;
+    std::vector<TaskId> m_mainThreadReady;
+};
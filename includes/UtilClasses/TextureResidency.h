@@ -0,0 +1,152 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ResourceManager.h"
+
+// the pixels of a few mip levels, level "firstLevel" first
+struct MipLevels {
+    unsigned int firstLevel = 0;
+    std::vector<std::vector<unsigned char>> levels;
+
+    size_t bytes() const
+    {
+        size_t total = 0;
+        for (const auto& level : levels)
+            total += level.size();
+        return total;
+    };
+};
+
+struct TextureResidencyStats {
+    size_t textures = 0;
+    // what the resident levels of the streamed textures take, and the budget they stay under (0 => none)
+    size_t residentBytes = 0;
+    size_t budgetBytes = 0;
+    // levels read from disk / dropped again over the whole run
+    uint64_t streamedIn = 0;
+    uint64_t evicted = 0;
+    size_t loading = 0;
+};
+
+// which mip levels of the loaded textures are in GPU memory
+// ---------------------------------------------------------
+// a texture loaded through the ResourceManager starts with its small levels only (up to START_SIZE pixels),
+// every frame the scenes request the level each textured object needs: the texture's size against the
+// object's size on screen (its bounding box, as if the texture covered the object once), so a far away
+// object asks for a small level and one that fills the screen for level 0
+// update() then streams the missing levels in: a loader thread reads the file again and builds the levels,
+// the next update() uploads them (on the thread that owns the context) and lowers the texture's base level
+// the textures budget of the MemoryTracker (--memory-budget=textures:<MB>) is the limit: to make room (or when
+// the budget is exceeded) the most detailed level of the least recently used texture is dropped first, a
+// texture that nobody asked for in a while gives back the levels it doesn't need anyway
+// requests come from the recording threads (atomics), everything else runs on the main thread
+class TextureResidency {
+public:
+    static TextureResidency& getInstance();
+
+    // textures start with their levels up to this many pixels (in their largest dimension),
+    // those are never evicted
+    static constexpr unsigned int START_SIZE = 256;
+    // a load reads and decodes a whole file, only a few at a time
+    static constexpr size_t MAX_LOADS_IN_FLIGHT = 2;
+    // frames without a request after which a texture drops the levels it no longer asks for
+    static constexpr uint64_t STREAM_OUT_FRAMES = 300;
+    static constexpr uint32_t NO_REQUEST = 0xFFFFFFFF;
+
+    // the first level a texture of this size is loaded with
+    static unsigned int startLevel(unsigned int width, unsigned int height);
+    // box filtered levels [firstLevel, endLevel) from the full size pixels
+    static MipLevels buildLevels(const unsigned char* pixels, unsigned int width, unsigned int height, unsigned int channels,
+        unsigned int firstLevel, unsigned int endLevel);
+
+    // called by the ResourceManager after loading (or reloading) a texture from "file"
+    void add(TextureHandle handle, const std::string& file, bool alpha);
+    // the level "texture" needs this frame for an object covering "screenPixels" pixels (any thread)
+    void request(const Texture2D& texture, float screenPixels);
+    // the height of the framebuffer, the requests convert the objects' sizes into pixels with it
+    void setViewportHeight(float height) { m_viewportHeight.store(height, std::memory_order_relaxed); };
+    float getViewportHeight() const { return m_viewportHeight.load(std::memory_order_relaxed); };
+
+    // once per frame on the main thread, after the draws were recorded
+    void update();
+    // stops the loader thread, before the ResourceManager clears the textures
+    void shutdown();
+
+    TextureResidencyStats getStats();
+
+private:
+    TextureResidency() {};
+    TextureResidency(const TextureResidency&) = delete;
+    TextureResidency& operator=(const TextureResidency&) = delete;
+
+    struct Entry {
+        TextureHandle handle;
+        std::string file;
+        bool alpha = false;
+        // bumped when the texture is reloaded, a load for an older version is thrown away
+        uint32_t version = 0;
+        // the levels it was loaded with (never evicted) and the most detailed one it has
+        // (what the texture's BaseLevel will be once the queued uploads and drops ran)
+        unsigned int startLevel = 0;
+        unsigned int residentLevel = 0;
+        // the lowest level asked for this frame
+        std::atomic<uint32_t> requested{ NO_REQUEST };
+        // the level the texture wants (the last request), and when that was
+        uint32_t wanted = NO_REQUEST;
+        uint64_t lastUsedFrame = 0;
+        bool loading = false;
+        // the file couldn't be read again, it keeps what it has until it is reloaded
+        bool failed = false;
+    };
+    struct Load {
+        uint32_t entry;
+        uint32_t version;
+        std::string file;
+        bool alpha;
+        unsigned int firstLevel;
+        unsigned int endLevel;
+        // filled in by the loader thread, empty when the file couldn't be read
+        MipLevels levels;
+    };
+
+    // main thread
+    void applyLoads();
+    void startLoads(size_t budget);
+    // drops the most detailed level of the least recently used texture that has one to spare
+    bool evictOne(uint32_t keepEntry);
+    void dropLevels(Entry& entry, unsigned int baseLevel);
+    size_t levelBytes(const Entry& entry, unsigned int firstLevel, unsigned int endLevel);
+    size_t residentBytes();
+
+    void loaderLoop();
+
+    // only grows on the main thread while loading, the requests read it while recording
+    std::vector<std::unique_ptr<Entry>> m_entries;
+    uint64_t m_frame = 0;
+    uint64_t m_streamedIn = 0;
+    uint64_t m_evicted = 0;
+    size_t m_inFlight = 0;
+    // what the loads in flight will add, they count against the budget already
+    size_t m_pendingBytes = 0;
+    std::atomic<float> m_viewportHeight{ 720.0f };
+
+    // between the main thread and the loader
+    std::mutex m_loadMutex;
+    std::condition_variable m_loadQueued;
+    std::deque<Load> m_queuedLoads;
+    std::vector<Load> m_finishedLoads;
+    // swapped with m_finishedLoads, keeps its capacity
+    std::vector<Load> m_applying;
+    std::thread m_loader;
+    bool m_stopLoader = false;
+};
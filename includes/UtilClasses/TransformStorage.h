@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// the id a GameObject keeps to find its transform again, stays the same for the lifetime of the transform
+using TransformId = uint32_t;
+static const TransformId INVALID_TRANSFORM = 0xFFFFFFFF;
+
+// an axis aligned bounding box, min > max means "no bounds"
+struct TransformBounds {
+    glm::vec3 min = glm::vec3(1.0f);
+    glm::vec3 max = glm::vec3(-1.0f);
+    bool valid() const { return min.x <= max.x; };
+};
+
+// the world matrices and bounds of every transform at one moment (see TransformStorage::copyTo)
+// the simulation thread publishes one after every tick so the renderer never reads the live arrays
+struct TransformSnapshot {
+    // in slot order, like inside the TransformStorage
+    std::vector<glm::mat4> world;
+    std::vector<TransformBounds> worldBounds;
+    std::vector<uint32_t> idToSlot;
+    std::vector<TransformId> slotToId;
+    // changes every time an id is reused, so an old snapshot can't be mistaken for a new transform
+    std::vector<uint32_t> idGeneration;
+    // the simulation tick and the time (in seconds) it belongs to
+    uint64_t tick = 0;
+    double time = 0.0;
+
+    // false for transforms created after the snapshot was taken
+    bool contains(TransformId id) const { return id < idToSlot.size() && idToSlot[id] < slotToId.size() && slotToId[idToSlot[id]] == id; };
+    const glm::mat4& getModel(TransformId id) const { return world[idToSlot[id]]; };
+    const TransformBounds& getWorldBounds(TransformId id) const { return worldBounds[idToSlot[id]]; };
+};
+
+// every transform of the engine in one place (data-oriented design)
+// ------------------------------------------------------------------
+// instead of every GameObject owning a position, rotation, scale and model matrix
+// (and rebuilding the matrix on every single setter call) we keep each component
+// in its own tightly packed array: a "structure of arrays" (SoA)
+//     positionX: [x0, x1, x2, ...]   positionY: [y0, y1, y2, ...]   ...
+// a setter only writes the value and sets a dirty flag, once per frame updateModelMatrices()
+// rebuilds the local matrix of every dirty transform in one go, 4 (SSE) or 8 (AVX2) at a time
+// https://en.wikipedia.org/wiki/AoS_and_SoA
+//
+// transforms can have a parent, the arrays are kept in depth-first order:
+//     [ root A | child A1 | grandchild A1a | child A2 | root B | ... ]
+// a parent always comes before its children and every subtree is one contiguous range,
+// so world matrices are computed in a single front to back pass (world = parent world * local)
+// and a subtree without any changes is jumped over in one step
+//
+// ids point to slots through an indirection table so they never change when slots move
+class TransformStorage {
+public:
+    static TransformStorage& getInstance();
+
+    TransformId create(const glm::vec3& position = glm::vec3(0.0f), const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f), const glm::vec3& scale = glm::vec3(1.0f));
+    // the children of a destroyed transform are attached to its parent
+    void destroy(TransformId);
+
+    // position, rotation and scale are relative to the parent (INVALID_TRANSFORM => relative to the world)
+    // returns false (and changes nothing) when "parent" is the transform itself or one of its descendants
+    // moves the subtree inside the arrays, meant for building hierarchies and not for every frame
+    bool setParent(TransformId, TransformId parent);
+    TransformId getParent(TransformId) const;
+
+    void setPosition(TransformId, const glm::vec3&);
+    void setRotation(TransformId, const glm::quat&);
+    void setScale(TransformId, const glm::vec3&);
+    glm::vec3 getPosition(TransformId) const;
+    glm::quat getRotation(TransformId) const;
+    glm::vec3 getScale(TransformId) const;
+    // the matrices of the last updateModelMatrices() call
+    // getModel is the world matrix (what the shaders call "model"), getLocal is relative to the parent
+    const glm::mat4& getModel(TransformId) const;
+    const glm::mat4& getLocal(TransformId) const;
+
+    // bounds in the transform's own space (e.g. of its mesh), the world bounds follow the world matrix
+    void setLocalBounds(TransformId, const TransformBounds&);
+    const TransformBounds& getWorldBounds(TransformId) const;
+
+    // rebuilds the local matrix (T * R * S) of every transform that changed since the last call
+    // and the world matrix + world bounds of those transforms and everything below them,
+    // returns the amount of world matrices that were rebuilt
+    size_t updateModelMatrices();
+    // how long the last updateModelMatrices() took (0 when there was nothing to do)
+    double lastUpdateMilliseconds() const { return m_lastUpdateMs; };
+    // copies the matrices and bounds of the last updateModelMatrices() call (reuses the snapshot's memory)
+    void copyTo(TransformSnapshot&) const;
+
+    size_t size() const { return m_slotToId.size(); };
+    bool contains(TransformId id) const { return id < m_idToSlot.size() && m_idToSlot[id] < m_slotToId.size() && m_slotToId[m_idToSlot[id]] == id; };
+    // which kernel updateModelMatrices() uses ("avx2", "sse" or "scalar"), picked at compile time
+    static const char* kernelName();
+
+private:
+    TransformStorage() {};
+
+    enum SlotFlags : uint8_t {
+        // position/rotation/scale changed => the local matrix has to be rebuilt
+        LOCAL_DIRTY = 1 << 0,
+        // some transform below this one is LOCAL_DIRTY (so its subtree can't be skipped)
+        SUBTREE_DIRTY = 1 << 1,
+        // set during updateModelMatrices when the world matrix changed (the children need a new one too)
+        WORLD_CHANGED = 1 << 2,
+    };
+
+    void markDirty(uint32_t slot);
+    // "ranges" roughly equal slot ranges that all start at a root (so they can be updated independently),
+    // written into "boundaries" (its capacity is kept)
+    void rootBoundaries(size_t ranges, std::vector<size_t>& boundaries) const;
+    // the world pass over [begin, end), returns the amount of rebuilt world matrices
+    size_t updateWorldRange(size_t begin, size_t end);
+    void updateWorldBounds(uint32_t slot);
+    // recomputes the parent slots from "firstSlot" on and every subtree size, after slots moved around
+    void rebuildLinks(uint32_t firstSlot);
+    // calls "function" with every per-slot array (they all have to move together)
+    template<typename Function>
+    void forEachSlotArray(Function function);
+
+    // one array per float so the kernels can load 4/8 consecutive transforms with a single instruction
+    std::vector<float> m_positionX, m_positionY, m_positionZ;
+    std::vector<float> m_rotationX, m_rotationY, m_rotationZ, m_rotationW;
+    std::vector<float> m_scaleX, m_scaleY, m_scaleZ;
+    // m_local is only used by transforms with a parent, a root's local matrix is its world matrix
+    std::vector<glm::mat4> m_local;
+    std::vector<glm::mat4> m_world;
+    std::vector<TransformBounds> m_localBounds;
+    std::vector<TransformBounds> m_worldBounds;
+
+    // hierarchy, the parent slot is -1 for roots and always smaller than the slot itself
+    std::vector<TransformId> m_parentId;
+    std::vector<int32_t> m_parentSlot;
+    // amount of slots of the subtree starting at this slot (itself included)
+    std::vector<uint32_t> m_subtreeSize;
+    std::vector<uint8_t> m_flags;
+    bool m_anyDirty = false;
+
+    // id -> slot and slot -> id, destroyed ids are reused
+    std::vector<uint32_t> m_idToSlot;
+    std::vector<TransformId> m_slotToId;
+    std::vector<TransformId> m_freeIds;
+    std::vector<uint32_t> m_idGeneration;
+    double m_lastUpdateMs = 0.0;
+
+    // updateModelMatrices' scratch lists, they only grow so a steady-state frame doesn't allocate
+    std::vector<size_t> m_boundaries;
+    std::vector<uint32_t> m_cleanChildren;
+    // one per JobSystem thread (indexed by threadIndex()), so the threads never share one
+    std::vector<std::vector<uint32_t>> m_threadCleanChildren;
+};
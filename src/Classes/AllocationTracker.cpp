@@ -0,0 +1,427 @@
+#include "UtilClasses/AllocationTracker.h"
+#include "UtilClasses/Logger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <malloc.h>
+#elif defined(__GLIBC__) || defined(__APPLE__)
+#include <execinfo.h>
+#define ALLOCATION_TRACKER_BACKTRACE
+#endif
+
+// everything in here may be used by operator new before main (or any constructor) ran,
+// so it is all constant initialized: atomics, plain arrays and a std::mutex (constexpr constructor)
+
+namespace {
+
+struct Zone {
+    char name[32];
+    std::atomic<uint64_t> frameAllocations;
+    std::atomic<uint64_t> lastFrameAllocations;
+    std::atomic<uint64_t> totalAllocations;
+    std::atomic<uint64_t> totalBytes;
+};
+
+struct CallSiteSlot {
+    // hash of the stack, 0 => free slot
+    std::atomic<uint64_t> key;
+    // set once frames/depth/zone are written
+    std::atomic<bool> ready;
+    void* frames[AllocationCallSite::MAX_FRAMES];
+    int depth;
+    uint16_t zone;
+    std::atomic<uint64_t> allocations;
+    std::atomic<uint64_t> bytes;
+};
+
+std::atomic<bool> s_enabled{ false };
+std::atomic<bool> s_captureCallSites{ false };
+
+std::atomic<uint64_t> s_frameAllocations{ 0 };
+std::atomic<uint64_t> s_frameBytes{ 0 };
+std::atomic<uint64_t> s_frameFrees{ 0 };
+AllocationFrameStats s_lastFrame;
+
+std::mutex s_zoneMutex;
+Zone s_zones[AllocationTracker::MAX_ZONES];
+std::atomic<uint16_t> s_zoneCount{ 1 };
+
+CallSiteSlot s_callSites[AllocationTracker::MAX_CALL_SITES];
+std::atomic<uint64_t> s_droppedCallSites{ 0 };
+
+thread_local uint16_t t_zone = AllocationTracker::NO_ZONE;
+// set while the tracker itself runs on this thread (capturing a stack may allocate)
+thread_local bool t_busy = false;
+
+const char* zoneName(uint16_t zone)
+{
+    return zone == AllocationTracker::NO_ZONE ? "untracked" : s_zones[zone].name;
+}
+
+uint64_t hashStack(void* const* frames, int depth)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (int i = 0; i < depth; i++)
+    {
+        hash ^= (uint64_t)(uintptr_t)frames[i];
+        hash *= 1099511628211ull;
+    }
+    // 0 marks a free slot
+    return hash | 1;
+}
+
+int captureStack(void** frames, int maxFrames)
+{
+#if defined(_WIN32)
+    return (int)CaptureStackBackTrace(0, (DWORD)maxFrames, frames, nullptr);
+#elif defined(ALLOCATION_TRACKER_BACKTRACE)
+    return backtrace(frames, maxFrames);
+#else
+    (void)frames;
+    (void)maxFrames;
+    return 0;
+#endif
+}
+
+void recordCallSite(size_t bytes)
+{
+    void* frames[AllocationCallSite::MAX_FRAMES];
+    int depth = captureStack(frames, AllocationCallSite::MAX_FRAMES);
+    uint64_t key = hashStack(frames, depth);
+
+    // open addressing, a slot is claimed once and never freed until reset()
+    size_t start = (size_t)(key % AllocationTracker::MAX_CALL_SITES);
+    for (size_t probe = 0; probe < AllocationTracker::MAX_CALL_SITES; probe++)
+    {
+        CallSiteSlot& slot = s_callSites[(start + probe) % AllocationTracker::MAX_CALL_SITES];
+        uint64_t current = slot.key.load(std::memory_order_acquire);
+        if (current == 0)
+        {
+            if (slot.key.compare_exchange_strong(current, key, std::memory_order_acq_rel))
+            {
+                std::memcpy(slot.frames, frames, sizeof(void*) * depth);
+                slot.depth = depth;
+                slot.zone = t_zone;
+                slot.ready.store(true, std::memory_order_release);
+                current = key;
+            }
+        }
+        if (current == key)
+        {
+            slot.allocations.fetch_add(1, std::memory_order_relaxed);
+            slot.bytes.fetch_add(bytes, std::memory_order_relaxed);
+            return;
+        }
+    }
+    s_droppedCallSites.fetch_add(1, std::memory_order_relaxed);
+}
+
+void* allocate(size_t bytes)
+{
+    void* memory = std::malloc(bytes ? bytes : 1);
+    if (memory)
+        AllocationTracker::recordAllocation(bytes);
+    return memory;
+}
+
+void* allocateAligned(size_t bytes, size_t alignment)
+{
+    alignment = std::max(alignment, sizeof(void*));
+#if defined(_WIN32)
+    void* memory = _aligned_malloc(bytes ? bytes : 1, alignment);
+#else
+    void* memory = nullptr;
+    if (posix_memalign(&memory, alignment, bytes ? bytes : 1) != 0)
+        memory = nullptr;
+#endif
+    if (memory)
+        AllocationTracker::recordAllocation(bytes);
+    return memory;
+}
+
+void release(void* memory)
+{
+    if (!memory)
+        return;
+    AllocationTracker::recordFree();
+    std::free(memory);
+}
+
+void releaseAligned(void* memory)
+{
+    if (!memory)
+        return;
+    AllocationTracker::recordFree();
+#if defined(_WIN32)
+    _aligned_free(memory);
+#else
+    std::free(memory);
+#endif
+}
+
+} // namespace
+
+void AllocationTracker::setEnabled(bool enabled)
+{
+#if defined(ALLOCATION_TRACKER_BACKTRACE)
+    // the first backtrace() loads the unwinder (and allocates), get that over with now
+    if (enabled)
+    {
+        void* frames[4];
+        t_busy = true;
+        backtrace(frames, 4);
+        t_busy = false;
+    }
+#endif
+    s_enabled.store(enabled, std::memory_order_relaxed);
+};
+
+bool AllocationTracker::isEnabled()
+{
+    return s_enabled.load(std::memory_order_relaxed);
+};
+
+void AllocationTracker::setCaptureCallSites(bool capture)
+{
+    s_captureCallSites.store(capture, std::memory_order_relaxed);
+};
+
+uint16_t AllocationTracker::registerZone(const char* name)
+{
+    std::lock_guard<std::mutex> lock(s_zoneMutex);
+    uint16_t count = s_zoneCount.load(std::memory_order_relaxed);
+    for (uint16_t zone = 1; zone < count; zone++)
+    {
+        if (std::strncmp(s_zones[zone].name, name, sizeof(s_zones[zone].name) - 1) == 0)
+            return zone;
+    }
+    // out of zones, the rest counts as untracked
+    if (count == MAX_ZONES)
+        return NO_ZONE;
+    std::snprintf(s_zones[count].name, sizeof(s_zones[count].name), "%s", name);
+    s_zoneCount.store(count + 1, std::memory_order_release);
+    return count;
+};
+
+uint16_t AllocationTracker::enterZone(uint16_t zone)
+{
+    uint16_t previous = t_zone;
+    t_zone = zone;
+    return previous;
+};
+
+void AllocationTracker::leaveZone(uint16_t previous)
+{
+    t_zone = previous;
+};
+
+const char* AllocationTracker::currentZoneName()
+{
+    return zoneName(t_zone);
+};
+
+void AllocationTracker::beginFrame()
+{
+    s_frameAllocations.store(0, std::memory_order_relaxed);
+    s_frameBytes.store(0, std::memory_order_relaxed);
+    s_frameFrees.store(0, std::memory_order_relaxed);
+    uint16_t count = s_zoneCount.load(std::memory_order_acquire);
+    for (uint16_t zone = 0; zone < count; zone++)
+        s_zones[zone].frameAllocations.store(0, std::memory_order_relaxed);
+};
+
+AllocationFrameStats AllocationTracker::endFrame()
+{
+    AllocationFrameStats stats;
+    stats.allocations = s_frameAllocations.load(std::memory_order_relaxed);
+    stats.bytes = s_frameBytes.load(std::memory_order_relaxed);
+    stats.frees = s_frameFrees.load(std::memory_order_relaxed);
+    uint16_t count = s_zoneCount.load(std::memory_order_acquire);
+    for (uint16_t zone = 0; zone < count; zone++)
+        s_zones[zone].lastFrameAllocations.store(s_zones[zone].frameAllocations.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    s_lastFrame = stats;
+    return stats;
+};
+
+const AllocationFrameStats& AllocationTracker::lastFrame()
+{
+    return s_lastFrame;
+};
+
+void AllocationTracker::forEachZone(const std::function<void(const AllocationZoneStats&)>& function)
+{
+    uint16_t count = s_zoneCount.load(std::memory_order_acquire);
+    for (uint16_t zone = 0; zone < count; zone++)
+    {
+        AllocationZoneStats stats;
+        stats.name = zoneName(zone);
+        stats.frameAllocations = s_zones[zone].lastFrameAllocations.load(std::memory_order_relaxed);
+        stats.totalAllocations = s_zones[zone].totalAllocations.load(std::memory_order_relaxed);
+        stats.totalBytes = s_zones[zone].totalBytes.load(std::memory_order_relaxed);
+        function(stats);
+    }
+};
+
+void AllocationTracker::forEachCallSite(const std::function<void(const AllocationCallSite&)>& function)
+{
+    for (CallSiteSlot& slot : s_callSites)
+    {
+        if (!slot.ready.load(std::memory_order_acquire))
+            continue;
+        AllocationCallSite site;
+        std::memcpy(site.frames, slot.frames, sizeof(void*) * slot.depth);
+        site.depth = slot.depth;
+        site.zone = zoneName(slot.zone);
+        site.allocations = slot.allocations.load(std::memory_order_relaxed);
+        site.bytes = slot.bytes.load(std::memory_order_relaxed);
+        function(site);
+    }
+};
+
+void AllocationTracker::logCallSites(size_t maxSites)
+{
+    // whatever reporting allocates is not part of what we report
+    bool wasBusy = t_busy;
+    t_busy = true;
+
+    std::vector<AllocationCallSite> sites;
+    forEachCallSite([&sites](const AllocationCallSite& site) {
+        sites.push_back(site);
+    });
+    std::sort(sites.begin(), sites.end(), [](const AllocationCallSite& a, const AllocationCallSite& b) {
+        return a.allocations > b.allocations;
+    });
+    if (sites.size() > maxSites)
+        sites.resize(maxSites);
+
+    for (const AllocationCallSite& site : sites)
+    {
+        LOG_WARNING("ALLOC: {} allocations ({} bytes) in zone \"{}\"", site.allocations, site.bytes, site.zone);
+        // the first frames are the tracker and operator new themselves
+#if defined(ALLOCATION_TRACKER_BACKTRACE)
+        char** symbols = backtrace_symbols(site.frames, site.depth);
+        for (int i = 0; i < site.depth; i++)
+            LOG_WARNING("ALLOC:     {}", symbols ? symbols[i] : "?");
+        std::free(symbols);
+#else
+        char address[32];
+        for (int i = 0; i < site.depth; i++)
+        {
+            std::snprintf(address, sizeof(address), "%p", site.frames[i]);
+            LOG_WARNING("ALLOC:     {}", address);
+        }
+#endif
+    }
+    uint64_t dropped = s_droppedCallSites.load(std::memory_order_relaxed);
+    if (dropped > 0)
+        LOG_WARNING("ALLOC: {} allocations came from more distinct stacks than the table holds", dropped);
+
+    t_busy = wasBusy;
+};
+
+void AllocationTracker::reset()
+{
+    uint16_t count = s_zoneCount.load(std::memory_order_acquire);
+    for (uint16_t zone = 0; zone < count; zone++)
+    {
+        s_zones[zone].totalAllocations.store(0, std::memory_order_relaxed);
+        s_zones[zone].totalBytes.store(0, std::memory_order_relaxed);
+    }
+    for (CallSiteSlot& slot : s_callSites)
+    {
+        slot.ready.store(false, std::memory_order_relaxed);
+        slot.allocations.store(0, std::memory_order_relaxed);
+        slot.bytes.store(0, std::memory_order_relaxed);
+        slot.key.store(0, std::memory_order_release);
+    }
+    s_droppedCallSites.store(0, std::memory_order_relaxed);
+};
+
+void AllocationTracker::recordAllocation(size_t bytes)
+{
+    if (!s_enabled.load(std::memory_order_relaxed) || t_busy)
+        return;
+    t_busy = true;
+    s_frameAllocations.fetch_add(1, std::memory_order_relaxed);
+    s_frameBytes.fetch_add(bytes, std::memory_order_relaxed);
+    Zone& zone = s_zones[t_zone];
+    zone.frameAllocations.fetch_add(1, std::memory_order_relaxed);
+    zone.totalAllocations.fetch_add(1, std::memory_order_relaxed);
+    zone.totalBytes.fetch_add(bytes, std::memory_order_relaxed);
+    if (s_captureCallSites.load(std::memory_order_relaxed))
+        recordCallSite(bytes);
+    t_busy = false;
+};
+
+void AllocationTracker::recordFree()
+{
+    if (!s_enabled.load(std::memory_order_relaxed) || t_busy)
+        return;
+    s_frameFrees.fetch_add(1, std::memory_order_relaxed);
+};
+
+// the global operator new and delete ------------------------------------------------------------
+// every form the standard lets a program replace, the aligned ones have to be freed with their own free
+
+void* operator new(std::size_t bytes)
+{
+    void* memory = allocate(bytes);
+    if (!memory)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new[](std::size_t bytes)
+{
+    void* memory = allocate(bytes);
+    if (!memory)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new(std::size_t bytes, const std::nothrow_t&) noexcept { return allocate(bytes); }
+void* operator new[](std::size_t bytes, const std::nothrow_t&) noexcept { return allocate(bytes); }
+
+void* operator new(std::size_t bytes, std::align_val_t alignment)
+{
+    void* memory = allocateAligned(bytes, (size_t)alignment);
+    if (!memory)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new[](std::size_t bytes, std::align_val_t alignment)
+{
+    void* memory = allocateAligned(bytes, (size_t)alignment);
+    if (!memory)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new(std::size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocateAligned(bytes, (size_t)alignment); }
+void* operator new[](std::size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocateAligned(bytes, (size_t)alignment); }
+
+void operator delete(void* memory) noexcept { release(memory); }
+void operator delete[](void* memory) noexcept { release(memory); }
+void operator delete(void* memory, std::size_t) noexcept { release(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { release(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { release(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { release(memory); }
+
+void operator delete(void* memory, std::align_val_t) noexcept { releaseAligned(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { releaseAligned(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { releaseAligned(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept { releaseAligned(memory); }
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept { releaseAligned(memory); }
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept { releaseAligned(memory); }
@@ -14,8 +14,10 @@ Axis::Axis(float length)
 		Vertex(glm::vec3(0.0f, 0.0f, length * 1.0f), glm::vec3(0.0f, 0.0f, 1.0f)), // Z-axis
 	};
 
-	GameObject::setMesh(new Mesh(vertices));
-	GameObject::setMaterial(new Material(ResourceManager::GetShader(STD_SHADER)));
+	setOwnedMesh(new Mesh(vertices));
+	setOwnedMaterial(new Material(ResourceManager::GetShader(ResourceManager::FindShader(StringID(STD_SHADER)))));
+	// the axis are lines, not triangles
+	GameObject::setDrawTriangles(false);
 };
 
 Axis::Axis(float length, glm::vec3& axisPosition)
@@ -24,13 +26,3 @@ Axis::Axis(float length, glm::vec3& axisPosition)
 	setPosition(axisPosition);
 };
 
-
-void Axis::draw(const glm::mat4& view, const glm::mat4& projection)
-{
-	Shader& currentShader = GameObject::getMaterial()->use();
-	currentShader.SetMatrix4("model", GameObject::getModel());
-	currentShader.SetMatrix4("view", view);
-	currentShader.SetMatrix4("projection", projection);
-
-	GameObject::getMesh()->draw(false);
-};
\ No newline at end of file
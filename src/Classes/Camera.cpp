@@ -81,6 +81,22 @@ void Camera::processZoom(float yoffset)
 	updateView();
 };
 
+void Camera::lookAt(const glm::vec3& position, const glm::vec3& target)
+{
+	m_cameraPosition = position;
+	m_cameraTarget = target;
+	// keep the orbit parameters in sync so mouse input continues from where the path left the camera
+	// (the inverse of the spherical coordinates in updatePosition)
+	glm::vec3 offset = m_cameraPosition - m_cameraTarget;
+	m_distance = glm::length(offset);
+	if (m_distance > 0.0f)
+	{
+		m_pitch = glm::degrees(asin(glm::clamp(offset.y / m_distance, -1.0f, 1.0f)));
+		m_yaw = glm::degrees(atan2(offset.z, offset.x));
+	}
+	updateView();
+};
+
 void Camera::updateProjection(float width , float height)
 {
 	// orthographic:
@@ -97,7 +113,8 @@ void Camera::updateProjection(float width , float height)
 	// param 1 => fov (field of view) value
 	// param 2 => aspect ratio 
 	// param 3 & 4 => distance between the near and far plane 
-	m_projection = glm::perspective(glm::radians(45.0f), width / height, 0.1f, 100.0f);
+	m_aspect = width / height;
+	m_projection = glm::perspective(glm::radians(45.0f), m_aspect, m_nearPlane, m_farPlane);
 	// 3 Major matrices should be noted (the MVP's):
 	// 1) Model Matrix		-> This matrix transforms vertices from a model/mesh's local space to world space
 	// 2) View Matrix		-> This matrix represents the camera's position and orientation transforming vertices from world space into the camera's view space
@@ -109,11 +126,16 @@ void Camera::updateProjection(float width , float height)
 	// http://www.songho.ca/opengl/gl_projectionmatrix.html
 };
 
+void Camera::setClipPlanes(float nearPlane, float farPlane)
+{
+	m_nearPlane = nearPlane;
+	m_farPlane = farPlane;
+	m_projection = glm::perspective(glm::radians(45.0f), m_aspect, m_nearPlane, m_farPlane);
+};
+
 void Camera::updateView()
 {
-	Logger::info(
-		MESSAGE("X: " + std::to_string(m_cameraPosition.x) + " Y: " + std::to_string(m_cameraPosition.y) + " Z: " + std::to_string(m_cameraPosition.z))
-	);
+	LOG_TRACE("X: {} Y: {} Z: {}", m_cameraPosition.x, m_cameraPosition.y, m_cameraPosition.z);
 	// takes the position from which you want to look at
 	// target position you want to look at
 	// and the vector which tells us what is up in worldspace
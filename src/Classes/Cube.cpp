@@ -60,8 +60,8 @@ Cube::Cube()
 		6, 7, 3
 	};
 
-	GameObject::setMesh(new Mesh(vertices, indices));
-	GameObject::setMaterial(new Material(ResourceManager::GetShader(STD_SHADER)));
+	setOwnedMesh(new Mesh(vertices, indices));
+	setOwnedMaterial(new Material(ResourceManager::GetShader(ResourceManager::FindShader(StringID(STD_SHADER)))));
 };
 
 Cube::Cube(glm::vec3& cubePosition)
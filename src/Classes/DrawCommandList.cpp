@@ -0,0 +1,80 @@
+#include "UtilClasses/DrawCommandList.h"
+#include "UtilClasses/FrameArena.h"
+
+#include <algorithm>
+#include <cstring>
+#include <queue>
+
+uint64_t DrawCommandList::makeSortKey(bool drawTriangles, uint32_t materialIndex, uint32_t meshIndex, float depth)
+{
+    // for a positive float the bit pattern grows with the value, so its top bits work as a depth
+    // with more precision close to the camera (where it matters) and no range to pick up front
+    uint32_t depthBits;
+    depth = std::max(depth, 0.0f);
+    std::memcpy(&depthBits, &depth, sizeof(depthBits));
+
+    uint64_t key = 0;
+    key |= (uint64_t)(drawTriangles ? 0 : 1) << 63;
+    key |= (uint64_t)std::min<uint32_t>(materialIndex, 0xFFFF) << 47;
+    key |= (uint64_t)std::min<uint32_t>(meshIndex, 0xFFFF) << 31;
+    key |= (uint64_t)((depthBits >> 7) & 0xFFFFFF) << 7;
+    return key;
+};
+
+void DrawCommandList::clear()
+{
+    // keeps the capacity, after the first frames recording doesn't allocate anymore
+    m_commands.clear();
+    m_sorted.clear();
+};
+
+void DrawCommandList::add(uint64_t sortKey, const DrawCommand& command)
+{
+    m_sorted.push_back({ sortKey, (uint32_t)m_commands.size() });
+    m_commands.push_back(command);
+};
+
+void DrawCommandList::sort()
+{
+    std::sort(m_sorted.begin(), m_sorted.end(), [](const SortEntry& a, const SortEntry& b) {
+        return a.key < b.key;
+    });
+};
+
+void DrawCommandList::merge(const std::vector<DrawCommandList>& lists, std::vector<DrawCommandRef>& order)
+{
+    order.clear();
+    size_t total = 0;
+    for (const DrawCommandList& list : lists)
+    {
+        total += list.m_sorted.size();
+    }
+    order.reserve(total);
+
+    // the head of every list in a min-heap, there are only as many lists as threads
+    // (scratch for this frame only, so it comes from the FrameArena instead of the heap)
+    struct Head {
+        uint64_t key;
+        uint32_t list;
+        uint32_t position;
+        bool operator>(const Head& other) const { return key > other.key; };
+    };
+    FrameVector<Head> headStorage(FrameArena::getInstance().resource());
+    headStorage.reserve(lists.size());
+    std::priority_queue<Head, FrameVector<Head>, std::greater<Head>> heads(std::greater<Head>(), std::move(headStorage));
+    for (uint32_t l = 0; l < lists.size(); l++)
+    {
+        if (!lists[l].m_sorted.empty())
+            heads.push({ lists[l].m_sorted[0].key, l, 0 });
+    }
+
+    while (!heads.empty())
+    {
+        Head head = heads.top();
+        heads.pop();
+        const std::vector<SortEntry>& sorted = lists[head.list].m_sorted;
+        order.push_back({ head.list, sorted[head.position].index });
+        if (head.position + 1 < sorted.size())
+            heads.push({ sorted[head.position + 1].key, head.list, head.position + 1 });
+    }
+};
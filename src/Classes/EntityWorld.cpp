@@ -0,0 +1,241 @@
+#include "UtilClasses/EntityWorld.h"
+
+#include <algorithm>
+#include <cassert>
+
+static const size_t CHUNK_ALIGNMENT = 64;
+
+static std::vector<ComponentInfo>& componentInfos()
+{
+    static std::vector<ComponentInfo> infos;
+    return infos;
+};
+
+uint32_t ComponentRegistry::add(const ComponentInfo& info)
+{
+    std::vector<ComponentInfo>& infos = componentInfos();
+    assert(infos.size() < 64 && "ComponentMask only has room for 64 component types");
+    infos.push_back(info);
+    return (uint32_t)infos.size() - 1;
+};
+
+const ComponentInfo& ComponentRegistry::info(uint32_t typeId)
+{
+    return componentInfos()[typeId];
+};
+
+// ------------------------------------------------------------------------------------------------
+// Archetype
+// ------------------------------------------------------------------------------------------------
+
+static size_t alignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+};
+
+Archetype::Archetype(ComponentMask mask)
+    : m_mask(mask)
+{
+    size_t bytesPerEntity = sizeof(Entity);
+    size_t padding = 0;
+    for (uint32_t typeId = 0; typeId < 64; typeId++)
+    {
+        if (has(typeId))
+        {
+            m_types.push_back(typeId);
+            bytesPerEntity += ComponentRegistry::info(typeId).size;
+            padding += ComponentRegistry::info(typeId).alignment;
+        }
+    }
+    m_chunkCapacity = (uint32_t)std::max<size_t>(1, (CHUNK_BYTES - padding) / bytesPerEntity);
+
+    // the entity array comes first, then every component array (each one aligned for its type)
+    size_t offset = sizeof(Entity) * m_chunkCapacity;
+    for (uint32_t typeId : m_types)
+    {
+        const ComponentInfo& info = ComponentRegistry::info(typeId);
+        offset = alignUp(offset, info.alignment);
+        m_offsets[typeId] = offset;
+        offset += info.size * m_chunkCapacity;
+    }
+    // a component that doesn't fit 16KB still gets a chunk (with room for one entity)
+    m_chunkBytes = std::max(CHUNK_BYTES, offset);
+};
+
+Archetype::~Archetype()
+{
+    for (Chunk& chunk : m_chunks)
+    {
+        for (uint32_t typeId : m_types)
+        {
+            for (uint32_t row = 0; row < chunk.count; row++)
+            {
+                ComponentRegistry::info(typeId).destruct(component(chunk, typeId, row));
+            }
+        }
+        ::operator delete(chunk.data, std::align_val_t(CHUNK_ALIGNMENT));
+    }
+};
+
+void* Archetype::component(const Chunk& chunk, uint32_t typeId, uint32_t row) const
+{
+    return chunk.data + m_offsets[typeId] + row * ComponentRegistry::info(typeId).size;
+};
+
+std::pair<uint32_t, uint32_t> Archetype::allocate(Entity entity)
+{
+    if (m_chunks.empty() || m_chunks.back().count == m_chunkCapacity)
+    {
+        Chunk chunk;
+        chunk.data = static_cast<std::byte*>(::operator new(m_chunkBytes, std::align_val_t(CHUNK_ALIGNMENT)));
+        m_chunks.push_back(chunk);
+    }
+
+    uint32_t chunkIndex = (uint32_t)m_chunks.size() - 1;
+    Chunk& chunk = m_chunks.back();
+    uint32_t row = chunk.count++;
+    entities(chunk)[row] = entity;
+    for (uint32_t typeId : m_types)
+    {
+        ComponentRegistry::info(typeId).construct(component(chunk, typeId, row));
+    }
+    return { chunkIndex, row };
+};
+
+Entity Archetype::remove(uint32_t chunkIndex, uint32_t row, bool destructComponents)
+{
+    Chunk& chunk = m_chunks[chunkIndex];
+    Chunk& last = m_chunks.back();
+    uint32_t lastRow = last.count - 1;
+    bool isLast = &chunk == &last && row == lastRow;
+
+    Entity moved;
+    for (uint32_t typeId : m_types)
+    {
+        const ComponentInfo& info = ComponentRegistry::info(typeId);
+        void* destination = component(chunk, typeId, row);
+        if (destructComponents)
+            info.destruct(destination);
+        if (!isLast)
+        {
+            void* source = component(last, typeId, lastRow);
+            info.moveConstruct(destination, source);
+            info.destruct(source);
+        }
+    }
+    if (!isLast)
+    {
+        moved = entities(last)[lastRow];
+        entities(chunk)[row] = moved;
+    }
+
+    last.count--;
+    if (last.count == 0)
+    {
+        ::operator delete(last.data, std::align_val_t(CHUNK_ALIGNMENT));
+        m_chunks.pop_back();
+    }
+    return moved;
+};
+
+// ------------------------------------------------------------------------------------------------
+// EntityWorld
+// ------------------------------------------------------------------------------------------------
+
+Archetype* EntityWorld::archetypeFor(ComponentMask mask)
+{
+    auto found = m_archetypeByMask.find(mask);
+    if (found != m_archetypeByMask.end())
+        return found->second;
+
+    m_archetypes.push_back(std::make_unique<Archetype>(mask));
+    Archetype* archetype = m_archetypes.back().get();
+    m_archetypeByMask[mask] = archetype;
+    return archetype;
+};
+
+Entity EntityWorld::allocateEntity(Archetype* archetype)
+{
+    Entity entity;
+    if (!m_freeIndices.empty())
+    {
+        entity.index = m_freeIndices.back();
+        m_freeIndices.pop_back();
+    }
+    else
+    {
+        entity.index = (uint32_t)m_records.size();
+        m_records.push_back(Record());
+    }
+
+    Record& record = m_records[entity.index];
+    entity.generation = record.generation;
+    auto [chunk, row] = archetype->allocate(entity);
+    record.archetype = archetype;
+    record.chunk = chunk;
+    record.row = row;
+    return entity;
+};
+
+bool EntityWorld::alive(Entity entity) const
+{
+    return entity.index < m_records.size()
+        && m_records[entity.index].archetype != nullptr
+        && m_records[entity.index].generation == entity.generation;
+};
+
+void EntityWorld::relocated(Entity moved, uint32_t chunk, uint32_t row)
+{
+    if (moved.valid())
+    {
+        m_records[moved.index].chunk = chunk;
+        m_records[moved.index].row = row;
+    }
+};
+
+void EntityWorld::destroy(Entity entity)
+{
+    if (!alive(entity))
+        return;
+
+    Record& record = m_records[entity.index];
+    Entity moved = record.archetype->remove(record.chunk, record.row, true);
+    relocated(moved, record.chunk, record.row);
+
+    record.archetype = nullptr;
+    record.generation++;
+    m_freeIndices.push_back(entity.index);
+};
+
+void EntityWorld::changeArchetype(Entity entity, ComponentMask mask)
+{
+    Record& record = m_records[entity.index];
+    Archetype* from = record.archetype;
+    Archetype* to = archetypeFor(mask);
+
+    auto [chunk, row] = to->allocate(entity);
+    Archetype::Chunk& source = from->chunks()[record.chunk];
+    Archetype::Chunk& destination = to->chunks()[chunk];
+    for (uint32_t typeId = 0; typeId < 64; typeId++)
+    {
+        if (!from->has(typeId))
+            continue;
+
+        const ComponentInfo& info = ComponentRegistry::info(typeId);
+        void* old = from->component(source, typeId, record.row);
+        if (to->has(typeId))
+        {
+            // the new row was default constructed by allocate, replace it with the old value
+            void* target = to->component(destination, typeId, row);
+            info.destruct(target);
+            info.moveConstruct(target, old);
+        }
+        info.destruct(old);
+    }
+
+    Entity moved = from->remove(record.chunk, record.row, false);
+    relocated(moved, record.chunk, record.row);
+    record.archetype = to;
+    record.chunk = chunk;
+    record.row = row;
+};
@@ -0,0 +1,328 @@
+#include "UtilClasses/FlightRecorder.h"
+#include "UtilClasses/LogBackend.h"
+#include "UtilClasses/LogFormat.h"
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct FlightEvent {
+    // index + 1 once the event is complete, 0 while it is written
+    std::atomic<uint64_t> sequence{ 0 };
+    uint64_t timeNs = 0;
+    uint64_t frame = 0;
+    double value = 0.0;
+    uint32_t thread = 0;
+    FlightEventType type = FlightEventType::MARKER;
+    // set for LOG_WARNING/LOG_ERROR, "text" then holds "payloadSize" bytes of their encoded arguments
+    const LogSite* site = nullptr;
+    uint32_t payloadSize = 0;
+    char text[FlightRecorder::TEXT_SIZE] = {};
+};
+
+constexpr uint32_t NO_THREAD = 0xFFFFFFFF;
+
+FlightEvent s_events[FlightRecorder::CAPACITY];
+std::atomic<uint64_t> s_next{ 0 };
+std::atomic<uint64_t> s_frame{ 0 };
+std::atomic<uint64_t> s_frameStart{ 0 };
+std::atomic<uint32_t> s_threadCount{ 0 };
+std::atomic<bool> s_crashing{ false };
+// a fixed buffer, the crash handler can't build a std::string
+char s_dumpPath[512] = "flight_recorder.txt";
+
+thread_local uint32_t t_thread = NO_THREAD;
+
+// claims the next slot and fills it, "fillText" writes the event's text (or payload)
+template<typename FillText>
+void writeEvent(FlightEventType type, double value, const LogSite* site, FillText&& fillText)
+{
+    if (t_thread == NO_THREAD)
+        t_thread = s_threadCount.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t index = s_next.fetch_add(1, std::memory_order_relaxed);
+    FlightEvent& event = s_events[index % FlightRecorder::CAPACITY];
+    // a reader that sees any of the new fields also sees that the event is incomplete (a seqlock)
+    event.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    event.timeNs = FlightRecorder::now();
+    event.frame = s_frame.load(std::memory_order_relaxed);
+    event.value = value;
+    event.thread = t_thread;
+    event.type = type;
+    event.site = site;
+    event.payloadSize = 0;
+    fillText(event);
+    event.sequence.store(index + 1, std::memory_order_release);
+}
+
+// the only file functions the crash handler may use
+int openFile(const char* path)
+{
+#if defined(_WIN32)
+    return _open(path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    return open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+}
+
+void writeFile(int file, const char* data, size_t size)
+{
+#if defined(_WIN32)
+    _write(file, data, (unsigned int)size);
+#else
+    while (size > 0)
+    {
+        ssize_t written = write(file, data, size);
+        if (written <= 0)
+            return;
+        data += written;
+        size -= (size_t)written;
+    }
+#endif
+}
+
+void closeFile(int file)
+{
+#if defined(_WIN32)
+    _close(file);
+#else
+    close(file);
+#endif
+}
+
+// builds the dump's lines in a fixed buffer, no snprintf (it may allocate or take a lock)
+class DumpWriter {
+public:
+    explicit DumpWriter(int file) : m_file(file) {};
+    ~DumpWriter() { flush(); };
+
+    void text(const char* value)
+    {
+        for (; *value; value++)
+            character(*value);
+    };
+    // one line per event, line breaks in it become spaces
+    void singleLine(const char* value, size_t size)
+    {
+        for (size_t i = 0; i < size && value[i]; i++)
+            character(value[i] == '\n' || value[i] == '\r' ? ' ' : value[i]);
+    };
+    void number(uint64_t value)
+    {
+        char digits[20];
+        int count = 0;
+        do
+        {
+            digits[count++] = (char)('0' + value % 10);
+            value /= 10;
+        } while (value > 0);
+        while (count > 0)
+            character(digits[--count]);
+    };
+    // with three decimals
+    void milliseconds(double value)
+    {
+        if (value < 0.0)
+        {
+            character('-');
+            value = -value;
+        }
+        uint64_t thousandths = (uint64_t)(value * 1000.0 + 0.5);
+        number(thousandths / 1000);
+        character('.');
+        uint64_t fraction = thousandths % 1000;
+        character((char)('0' + fraction / 100));
+        character((char)('0' + fraction / 10 % 10));
+        character((char)('0' + fraction % 10));
+    };
+    void character(char value)
+    {
+        if (m_size == sizeof(m_buffer))
+            flush();
+        m_buffer[m_size++] = value;
+    };
+    void flush()
+    {
+        writeFile(m_file, m_buffer, m_size);
+        m_size = 0;
+    };
+
+private:
+    int m_file;
+    char m_buffer[4096];
+    size_t m_size = 0;
+};
+
+}
+
+void FlightRecorder::beginFrame()
+{
+    s_frame.fetch_add(1, std::memory_order_relaxed);
+    s_frameStart.store(now(), std::memory_order_relaxed);
+    record(FlightEventType::FRAME_BEGIN, "");
+};
+
+void FlightRecorder::endFrame()
+{
+    record(FlightEventType::FRAME_END, "", (now() - s_frameStart.load(std::memory_order_relaxed)) / 1000000.0);
+};
+
+uint64_t FlightRecorder::frame()
+{
+    return s_frame.load(std::memory_order_relaxed);
+};
+
+void FlightRecorder::record(FlightEventType type, const char* text, double value)
+{
+    writeEvent(type, value, nullptr, [text](FlightEvent& event) {
+        size_t length = 0;
+        if (text)
+        {
+            for (; length < TEXT_SIZE - 1 && text[length]; length++)
+                event.text[length] = text[length];
+        }
+        event.text[length] = '\0';
+    });
+};
+
+void FlightRecorder::recordLog(const LogSite& site, const char* payload, uint32_t size)
+{
+    FlightEventType type = site.level == LogLevel::Error ? FlightEventType::ERROR_MESSAGE : FlightEventType::WARNING_MESSAGE;
+    writeEvent(type, 0.0, &site, [payload, size](FlightEvent& event) {
+        event.payloadSize = payload ? (uint32_t)std::min<size_t>(size, TEXT_SIZE) : 0;
+        if (event.payloadSize > 0)
+            std::memcpy(event.text, payload, event.payloadSize);
+    });
+};
+
+void FlightRecorder::setDumpPath(const std::string& path)
+{
+    size_t length = std::min(path.size(), sizeof(s_dumpPath) - 1);
+    std::memcpy(s_dumpPath, path.c_str(), length);
+    s_dumpPath[length] = '\0';
+};
+
+bool FlightRecorder::dump()
+{
+    return dump(s_dumpPath, 0);
+};
+
+bool FlightRecorder::dump(const char* path, int signal)
+{
+    int file = openFile(path);
+    if (file < 0)
+        return false;
+
+    uint64_t end = s_next.load(std::memory_order_acquire);
+    uint64_t begin = end > CAPACITY ? end - CAPACITY : 0;
+    uint64_t dumpTime = now();
+    DumpWriter out(file);
+    out.text("# flight recorder: the last ");
+    out.number(end - begin);
+    out.text(" events, newest last\n");
+    if (signal != 0)
+    {
+        out.text("# crashed with signal ");
+        out.number((uint64_t)signal);
+        out.character('\n');
+    }
+    out.text("# ms before the dump, thread, frame, event, value (ms for frames and zones), text\n");
+
+    FlightEvent copy;
+    // a log event's message, formatted here instead of on the thread that logged it
+    char message[512];
+    for (uint64_t index = begin; index < end; index++)
+    {
+        const FlightEvent& event = s_events[index % CAPACITY];
+        uint64_t sequence = event.sequence.load(std::memory_order_acquire);
+        if (sequence != index + 1)
+            continue;
+        copy.timeNs = event.timeNs;
+        copy.frame = event.frame;
+        copy.value = event.value;
+        copy.thread = event.thread;
+        copy.type = event.type;
+        copy.site = event.site;
+        copy.payloadSize = event.payloadSize;
+        std::memcpy(copy.text, event.text, TEXT_SIZE);
+        // overwritten while we copied it
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (event.sequence.load(std::memory_order_relaxed) != sequence)
+            continue;
+
+        out.milliseconds(copy.timeNs <= dumpTime ? -((dumpTime - copy.timeNs) / 1000000.0) : 0.0);
+        out.character(' ');
+        out.number(copy.thread);
+        out.character(' ');
+        out.number(copy.frame);
+        out.character(' ');
+        out.text(typeName(copy.type));
+        out.character(' ');
+        out.milliseconds(copy.value);
+        if (copy.site)
+        {
+            size_t length = formatLogArguments(message, sizeof(message), copy.site->format, copy.text, std::min<uint32_t>(copy.payloadSize, TEXT_SIZE));
+            out.character(' ');
+            out.singleLine(message, length);
+        }
+        else if (copy.text[0])
+        {
+            out.character(' ');
+            out.singleLine(copy.text, TEXT_SIZE - 1);
+        }
+        out.character('\n');
+    }
+    out.flush();
+    closeFile(file);
+    return true;
+};
+
+void FlightRecorder::installCrashHandlers()
+{
+    std::signal(SIGSEGV, &FlightRecorder::onCrash);
+    std::signal(SIGABRT, &FlightRecorder::onCrash);
+    std::signal(SIGFPE, &FlightRecorder::onCrash);
+    std::signal(SIGILL, &FlightRecorder::onCrash);
+};
+
+void FlightRecorder::onCrash(int signal)
+{
+    // a second crash (in here or on another thread) goes straight to the default handler
+    // the log lines first, they usually say what went wrong, the dump then shows what led up to it
+    if (!s_crashing.exchange(true))
+    {
+        LogBackend::flushFromSignal();
+        dump(s_dumpPath, signal);
+    }
+    std::signal(signal, SIG_DFL);
+    std::raise(signal);
+};
+
+const char* FlightRecorder::typeName(FlightEventType type)
+{
+    switch (type)
+    {
+    case FlightEventType::FRAME_BEGIN: return "frame_begin";
+    case FlightEventType::FRAME_END: return "frame_end";
+    case FlightEventType::ZONE: return "zone";
+    case FlightEventType::RESOURCE_LOAD: return "load";
+    case FlightEventType::SHADER_RELOAD: return "shader_reload";
+    case FlightEventType::WARNING_MESSAGE: return "warning";
+    case FlightEventType::ERROR_MESSAGE: return "error";
+    case FlightEventType::MARKER: return "marker";
+    default: return "unknown";
+    }
+};
@@ -0,0 +1,114 @@
+#include "UtilClasses/FrameArena.h"
+#include "UtilClasses/JobSystem.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+LinearArena::LinearArena(size_t blockSize)
+    : m_blockSize(blockSize)
+{
+    addBlock(blockSize);
+};
+
+LinearArena::~LinearArena()
+{
+    for (Block& block : m_blocks)
+        ::operator delete(block.data, std::align_val_t(alignof(std::max_align_t)));
+};
+
+void LinearArena::addBlock(size_t size)
+{
+    Block block;
+    block.data = static_cast<std::byte*>(::operator new(size, std::align_val_t(alignof(std::max_align_t))));
+    block.size = size;
+    m_blocks.push_back(block);
+    m_capacity += size;
+    m_offset = 0;
+};
+
+void* LinearArena::allocate(size_t bytes, size_t alignment)
+{
+    Block& block = m_blocks.back();
+    // aligned as an address, the block itself is only aligned to max_align_t
+    uintptr_t base = (uintptr_t)block.data;
+    size_t aligned = (size_t)(((base + m_offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base);
+    if (aligned + bytes > block.size)
+    {
+        // the block is full, this frame continues in a new one (reset() merges them)
+        m_overflows++;
+        addBlock(std::max(m_blockSize, bytes + alignment));
+        return allocate(bytes, alignment);
+    }
+    m_used += aligned - m_offset + bytes;
+    m_offset = aligned + bytes;
+    return block.data + aligned;
+};
+
+void LinearArena::reset()
+{
+    m_peak = std::max(m_peak, m_used);
+    if (m_blocks.size() > 1)
+    {
+        // one block that fits everything the last frame used
+        size_t total = m_capacity;
+        for (Block& block : m_blocks)
+            ::operator delete(block.data, std::align_val_t(alignof(std::max_align_t)));
+        m_blocks.clear();
+        m_capacity = 0;
+        m_blockSize = total;
+        addBlock(total);
+    }
+    m_offset = 0;
+    m_used = 0;
+};
+
+FrameArena& FrameArena::getInstance()
+{
+    static FrameArena instance;
+    return instance;
+};
+
+void FrameArena::init(size_t threadCount, size_t bytesPerThread)
+{
+    m_threads.clear();
+    for (size_t i = 0; i < threadCount; i++)
+        m_threads.push_back(std::make_unique<ThreadArenas>(bytesPerThread));
+};
+
+std::pmr::memory_resource* FrameArena::resource()
+{
+    JobSystem& jobs = JobSystem::getInstance();
+    if (!jobs.isPoolThread())
+        return std::pmr::new_delete_resource();
+    size_t index = jobs.threadIndex();
+    if (index >= m_threads.size())
+        return std::pmr::new_delete_resource();
+    return &m_threads[index]->resources[m_frame];
+};
+
+void FrameArena::endFrame()
+{
+    FrameArenaStats stats;
+    for (auto& thread : m_threads)
+    {
+        const LinearArena& current = thread->arenas[m_frame];
+        stats.usedBytes += current.used();
+        stats.overflows += current.overflows();
+    }
+
+    // the arenas of the frame before this one are free again
+    m_frame = (m_frame + 1) % FRAMES;
+    for (auto& thread : m_threads)
+    {
+        thread->arenas[m_frame].reset();
+        for (const LinearArena& arena : thread->arenas)
+        {
+            stats.capacityBytes += arena.capacity();
+            stats.peakBytes = std::max(stats.peakBytes, arena.peak());
+        }
+    }
+    m_stats = stats;
+    m_memory.track(MemoryCategory::FRAME_ARENA, "frame arenas", stats.capacityBytes);
+};
@@ -0,0 +1,124 @@
+#include "UtilClasses/FramePacer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "UtilClasses/Logger.h"
+
+// the spin part of a wait never goes below/above these (seconds)
+// below: sleeps are never exact, above: a scheduler that late isn't worth burning a core for
+static const double MIN_SPIN = 0.0002;
+static const double MAX_SPIN = 0.005;
+// the first frames include loading, compiling shaders, ... they don't count as stutters
+static const uint64_t STUTTER_WARMUP_FRAMES = 30;
+
+double FramePacer::now()
+{
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+};
+
+void FramePacer::setTargetFps(double fps)
+{
+    m_targetSeconds = fps > 0.0 ? 1.0 / fps : 0.0;
+    if (fps > 0.0)
+        LOG_INFO("FRAME PACER: Capped at {} fps", fps);
+    else
+        LOG_INFO("FRAME PACER: Uncapped");
+};
+
+void FramePacer::setTargetFrameTime(double milliseconds)
+{
+    setTargetFps(milliseconds > 0.0 ? 1000.0 / milliseconds : 0.0);
+};
+
+void FramePacer::setSmoothing(double factor)
+{
+    m_smoothing = std::min(std::max(factor, 0.001), 1.0);
+};
+
+void FramePacer::waitUntil(double time)
+{
+    double start = now();
+    double remaining = time - start;
+    while (remaining > 0.0)
+    {
+        double spin = std::min(std::max(m_sleepOvershoot * 1.25, MIN_SPIN), MAX_SPIN);
+        if (remaining <= spin)
+            break;
+
+        double request = remaining - spin;
+        double before = now();
+        std::this_thread::sleep_for(std::chrono::duration<double>(request));
+        double overshoot = std::max(now() - before - request, 0.0);
+        // follows a late sleep right away but only slowly trusts the scheduler again
+        m_sleepOvershoot = overshoot > m_sleepOvershoot ? overshoot : m_sleepOvershoot * 0.95 + overshoot * 0.05;
+        remaining = time - now();
+    }
+
+    double spinStart = now();
+    while (now() < time)
+    {
+        std::this_thread::yield();
+    }
+    double end = now();
+    m_stats.waitMs = (end - start) * 1000.0;
+    m_stats.spinMs = (end - std::max(spinStart, start)) * 1000.0;
+};
+
+double FramePacer::beginFrame()
+{
+    double workEnd = now();
+    if (m_lastStart < 0.0)
+    {
+        m_lastStart = workEnd;
+        m_nextDeadline = workEnd + m_targetSeconds;
+        return 0.0;
+    }
+
+    m_stats.workMs = (workEnd - m_lastStart) * 1000.0;
+    m_stats.waitMs = 0.0;
+    m_stats.spinMs = 0.0;
+    if (m_targetSeconds > 0.0)
+    {
+        // a whole frame late: catching up would mean several frames without any wait, start over instead
+        if (workEnd > m_nextDeadline + m_targetSeconds)
+            m_nextDeadline = workEnd;
+        waitUntil(m_nextDeadline);
+        m_nextDeadline += m_targetSeconds;
+    }
+
+    double start = now();
+    double deltaTime = start - m_lastStart;
+    m_lastStart = start;
+
+    double frameMs = deltaTime * 1000.0;
+    m_stats.frameMs = frameMs;
+    m_stats.frames++;
+    m_history[m_historyOffset] = (float)frameMs;
+    m_historyOffset = (m_historyOffset + 1) % HISTORY_SIZE;
+
+    if (m_stats.frames == 1)
+    {
+        m_stats.smoothedMs = frameMs;
+    }
+
+    bool stutter = m_stats.frames > STUTTER_WARMUP_FRAMES && frameMs > m_stats.smoothedMs * m_stutterFactor;
+    if (stutter)
+    {
+        m_stats.stutters++;
+        m_stats.lastStutterMs = frameMs;
+        m_stats.lastStutterTime = start;
+        LOG_DEBUG("FRAME PACER: Stutter, {} ms while frames take {} ms", frameMs, m_stats.smoothedMs);
+    }
+
+    m_stats.jitterMs += (std::abs(frameMs - m_stats.smoothedMs) - m_stats.jitterMs) * m_smoothing;
+    m_stats.smoothedMs += (frameMs - m_stats.smoothedMs) * m_smoothing;
+    m_stats.fps = m_stats.smoothedMs > 0.0 ? 1000.0 / m_stats.smoothedMs : 0.0;
+
+    if (m_smoothDeltaTime && !stutter)
+        return m_stats.smoothedMs / 1000.0;
+    return deltaTime;
+};
@@ -0,0 +1,162 @@
+#include "UtilClasses/GLDebug.h"
+#include "UtilClasses/AllocationTracker.h"
+#include "UtilClasses/Logger.h"
+
+#include <algorithm>
+#include <cctype>
+#include <functional>
+
+GLDebug& GLDebug::getInstance()
+{
+    static GLDebug instance;
+    return instance;
+};
+
+void GLDebug::init()
+{
+    if (!m_requested)
+        return;
+    GLint flags = 0;
+    if (GLAD_GL_VERSION_4_3)
+        glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+    if (!(flags & GL_CONTEXT_FLAG_DEBUG_BIT))
+    {
+        LOG_WARNING("GLDEBUG: No debug context (needs OpenGL 4.3), the driver's messages are not available");
+        return;
+    }
+
+    glEnable(GL_DEBUG_OUTPUT);
+    // the callback runs inside the GL call that caused the message, so the zone and the thread are the right ones
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    glDebugMessageCallback(&GLDebug::callback, this);
+    // notifications are mostly "buffer X will use video memory", performance hints are sometimes sent at that severity too
+    glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+    glDebugMessageControl(GL_DONT_CARE, GL_DEBUG_TYPE_PERFORMANCE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+    glGetIntegerv(GL_MAX_LABEL_LENGTH, &m_maxLabelLength);
+    m_active = true;
+    LOG_INFO("GLDEBUG: Debug output enabled ({})", std::string(reinterpret_cast<const char*>(glGetString(GL_RENDERER))));
+};
+
+void GLDebug::label(GLenum identifier, GLuint name, const std::string& label)
+{
+    if (!m_active || name == 0)
+        return;
+    // the limit counts the terminating null
+    GLsizei length = (GLsizei)std::min<size_t>(label.size(), (size_t)std::max(m_maxLabelLength - 1, 0));
+    glObjectLabel(identifier, name, length, label.c_str());
+};
+
+void APIENTRY GLDebug::callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* user)
+{
+    std::string text = length >= 0 ? std::string(message, (size_t)length) : std::string(message);
+    // drivers end some messages with a new line
+    while (!text.empty() && (text.back() == '\n' || text.back() == '\r'))
+        text.pop_back();
+    static_cast<GLDebug*>(const_cast<void*>(user))->handle(source, type, id, severity, text);
+};
+
+GLDebugCategory GLDebug::classify(GLenum type, GLenum severity, const std::string& message)
+{
+    if (type == GL_DEBUG_TYPE_ERROR)
+        return GLDebugCategory::API_ERROR;
+    if (type == GL_DEBUG_TYPE_PERFORMANCE)
+    {
+        // there is no standard for these, the words drivers (Mesa, NVIDIA, AMD) use for them
+        std::string lower = message;
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+        if (lower.find("stall") != std::string::npos || lower.find("busy") != std::string::npos
+            || lower.find("sync") != std::string::npos || lower.find("wait") != std::string::npos)
+            return GLDebugCategory::STALL;
+        if (lower.find("recompil") != std::string::npos)
+            return GLDebugCategory::RECOMPILE;
+        if (lower.find("redundant") != std::string::npos)
+            return GLDebugCategory::REDUNDANT_STATE;
+        return GLDebugCategory::PERFORMANCE;
+    }
+    if (type == GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR || type == GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR || type == GL_DEBUG_TYPE_PORTABILITY
+        || severity == GL_DEBUG_SEVERITY_HIGH)
+        return GLDebugCategory::WARNING;
+    return GLDebugCategory::INFO;
+};
+
+void GLDebug::handle(GLenum source, GLenum type, GLuint id, GLenum severity, const std::string& message)
+{
+    GLDebugCategory category = classify(type, severity, message);
+    uint64_t key = id != 0
+        ? ((uint64_t)(source & 0xFFFF) << 48) ^ ((uint64_t)(type & 0xFFFF) << 32) ^ id
+        : (uint64_t)std::hash<std::string>()(message);
+
+    uint64_t seen = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_messages[(size_t)category]++;
+        seen = ++m_repeats[key];
+        // the first time and then at every power of ten
+        uint64_t next = 1;
+        while (next < seen)
+            next *= 10;
+        if (next != seen)
+        {
+            m_suppressed++;
+            return;
+        }
+    }
+
+    const char* zone = AllocationTracker::currentZoneName();
+    switch (category)
+    {
+    case GLDebugCategory::API_ERROR:
+        LOG_ERROR("GLDEBUG: [{}] {} (id {}, seen {}x)", zone, message, id, seen);
+        break;
+    case GLDebugCategory::STALL:
+    case GLDebugCategory::RECOMPILE:
+    case GLDebugCategory::REDUNDANT_STATE:
+    case GLDebugCategory::PERFORMANCE:
+    case GLDebugCategory::WARNING:
+        LOG_WARNING("GLDEBUG: {} [{}] {} (id {}, seen {}x)", categoryName(category), zone, message, id, seen);
+        break;
+    default:
+        LOG_DEBUG("GLDEBUG: [{}] {} (id {}, seen {}x)", zone, message, id, seen);
+        break;
+    }
+};
+
+GLDebugStats GLDebug::getStats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    GLDebugStats stats;
+    stats.active = m_active;
+    for (size_t i = 0; i < (size_t)GLDebugCategory::COUNT; i++)
+        stats.messages[i] = m_messages[i];
+    stats.distinct = m_repeats.size();
+    stats.suppressed = m_suppressed;
+    return stats;
+};
+
+void GLDebug::logSummary()
+{
+    if (!m_active)
+        return;
+    GLDebugStats stats = getStats();
+    for (size_t i = 0; i < (size_t)GLDebugCategory::COUNT; i++)
+    {
+        if (stats.messages[i] > 0)
+            LOG_INFO("GLDEBUG: {} {} messages", stats.messages[i], categoryName((GLDebugCategory)i));
+    }
+    LOG_INFO("GLDEBUG: {} different messages, {} repeats not logged", stats.distinct, stats.suppressed);
+};
+
+const char* GLDebug::categoryName(GLDebugCategory category)
+{
+    switch (category)
+    {
+    case GLDebugCategory::API_ERROR: return "error";
+    case GLDebugCategory::STALL: return "stall";
+    case GLDebugCategory::RECOMPILE: return "recompile";
+    case GLDebugCategory::REDUNDANT_STATE: return "redundant state";
+    case GLDebugCategory::PERFORMANCE: return "performance";
+    case GLDebugCategory::WARNING: return "warning";
+    case GLDebugCategory::INFO: return "info";
+    default: return "unknown";
+    }
+};
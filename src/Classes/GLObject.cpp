@@ -0,0 +1,165 @@
+#include "UtilClasses/GLObject.h"
+#include "UtilClasses/RenderThread.h"
+
+#include <algorithm>
+
+GLNamePool& GLNamePool::getInstance()
+{
+    static GLNamePool instance;
+    return instance;
+};
+
+GLuint GLNamePool::acquire(GLObjectType type)
+{
+    m_acquiredCount.fetch_add(1, std::memory_order_relaxed);
+    // a program is made with its state, there is no glGenPrograms
+    if (type == GLObjectType::PROGRAM)
+        return glCreateProgram();
+
+    std::vector<GLuint>& names = m_free[(size_t)type];
+    if (names.empty())
+        refill(type);
+    GLuint name = names.back();
+    names.pop_back();
+    return name;
+};
+
+void GLNamePool::refill(GLObjectType type)
+{
+    std::vector<GLuint>& names = m_free[(size_t)type];
+    names.resize(BATCH_SIZE);
+    switch (type)
+    {
+    case GLObjectType::BUFFER:       glGenBuffers((GLsizei)BATCH_SIZE, names.data()); break;
+    case GLObjectType::VERTEX_ARRAY: glGenVertexArrays((GLsizei)BATCH_SIZE, names.data()); break;
+    case GLObjectType::TEXTURE:      glGenTextures((GLsizei)BATCH_SIZE, names.data()); break;
+    case GLObjectType::QUERY:        glGenQueries((GLsizei)BATCH_SIZE, names.data()); break;
+    default: break;
+    }
+    m_batchCount.fetch_add(1, std::memory_order_relaxed);
+};
+
+void GLNamePool::release(GLObjectType type, GLuint name)
+{
+    if (name == 0 || m_shutdown)
+        return;
+    m_releasedCount.fetch_add(1, std::memory_order_relaxed);
+    m_pendingDeletes.fetch_add(1, std::memory_order_relaxed);
+    m_released.push_back({ type, name });
+};
+
+void GLNamePool::endFrame()
+{
+    if (m_shutdown)
+        return;
+
+    if (!m_released.empty())
+    {
+        FencedReleases fenced;
+        fenced.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        fenced.releases.swap(m_released);
+        m_fenced.push_back(std::move(fenced));
+    }
+
+    // the fences signal in order, stop at the first one that hasn't
+    while (!m_fenced.empty())
+    {
+        FencedReleases& oldest = m_fenced.front();
+        GLenum state = glClientWaitSync(oldest.fence, 0, 0);
+        if (state != GL_ALREADY_SIGNALED && state != GL_CONDITION_SATISFIED)
+            break;
+        glDeleteSync(oldest.fence);
+        m_pendingDeletes.fetch_sub(oldest.releases.size(), std::memory_order_relaxed);
+        deleteNames(oldest.releases);
+        m_fenced.pop_front();
+    }
+};
+
+void GLNamePool::shutdown()
+{
+    if (m_shutdown)
+        return;
+    glFinish();
+    for (FencedReleases& fenced : m_fenced)
+    {
+        glDeleteSync(fenced.fence);
+        deleteNames(fenced.releases);
+    }
+    m_fenced.clear();
+    deleteNames(m_released);
+    m_released.clear();
+    // the names that were never handed out
+    for (size_t type = 0; type < (size_t)GLObjectType::COUNT; type++)
+    {
+        deleteNames((GLObjectType)type, m_free[type].data(), (GLsizei)m_free[type].size());
+        m_free[type].clear();
+    }
+    m_pendingDeletes.store(0, std::memory_order_relaxed);
+    m_shutdown = true;
+};
+
+GLNamePoolStats GLNamePool::getStats() const
+{
+    GLNamePoolStats stats;
+    stats.acquired = m_acquiredCount.load(std::memory_order_relaxed);
+    stats.released = m_releasedCount.load(std::memory_order_relaxed);
+    stats.batches = m_batchCount.load(std::memory_order_relaxed);
+    stats.pendingDeletes = m_pendingDeletes.load(std::memory_order_relaxed);
+    return stats;
+};
+
+void GLNamePool::deleteNames(std::vector<Release>& releases)
+{
+    // one glDelete* per type instead of one per name
+    std::sort(releases.begin(), releases.end(), [](const Release& a, const Release& b) { return a.type < b.type; });
+    std::vector<GLuint> names;
+    names.reserve(releases.size());
+    size_t begin = 0;
+    while (begin < releases.size())
+    {
+        GLObjectType type = releases[begin].type;
+        names.clear();
+        size_t end = begin;
+        while (end < releases.size() && releases[end].type == type)
+            names.push_back(releases[end++].name);
+        deleteNames(type, names.data(), (GLsizei)names.size());
+        begin = end;
+    }
+};
+
+void GLNamePool::deleteNames(GLObjectType type, const GLuint* names, GLsizei count)
+{
+    if (count == 0)
+        return;
+    switch (type)
+    {
+    case GLObjectType::BUFFER:       glDeleteBuffers(count, names); break;
+    case GLObjectType::VERTEX_ARRAY: glDeleteVertexArrays(count, names); break;
+    case GLObjectType::TEXTURE:      glDeleteTextures(count, names); break;
+    case GLObjectType::QUERY:        glDeleteQueries(count, names); break;
+    case GLObjectType::PROGRAM:
+        for (GLsizei i = 0; i < count; i++)
+            glDeleteProgram(names[i]);
+        break;
+    default: break;
+    }
+};
+
+template<GLObjectType TYPE>
+void GLObject<TYPE>::reset()
+{
+    if (m_name == 0)
+        return;
+    // through the render thread's queue, so frames recorded before this still find the name
+    GLuint name = m_name;
+    m_name = 0;
+    RenderThread::getInstance().run([name]() {
+        GLNamePool::getInstance().release(TYPE, name);
+    });
+};
+
+template class GLObject<GLObjectType::BUFFER>;
+template class GLObject<GLObjectType::VERTEX_ARRAY>;
+template class GLObject<GLObjectType::TEXTURE>;
+template class GLObject<GLObjectType::PROGRAM>;
+template class GLObject<GLObjectType::QUERY>;
@@ -1,7 +1,9 @@
 #include "UtilClasses/Game.h"
 
-Game::Game(unsigned int width, unsigned int height, std::string name)
-    : m_state(GAME_ACTIVE), m_keys(), m_windowWidth(width), m_windowHeight(height)
+#include <chrono>
+
+Game::Game(unsigned int width, unsigned int height, std::string name, bool headless)
+    : m_state(GAME_ACTIVE), m_keys(), m_windowWidth(width), m_windowHeight(height), m_headless(headless)
 {
 	Init();
 	
@@ -12,42 +14,75 @@ Game::Game(unsigned int width, unsigned int height, std::string name)
 
 	int nrAttributes;
 	glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &nrAttributes);
-	Logger::info(MESSAGE("Application started\nMaximum nr of vertex attributes supported : " + std::to_string(nrAttributes)));
-	Logger::succes(MESSAGE("Finished initialization...starting main rendering loop"));
+	LOG_INFO("Application started\nMaximum nr of vertex attributes supported : {}", nrAttributes);
+	LOG_SUCCES("Finished initialization...starting main rendering loop");
 }
 
 Game::~Game()
 {
-	Logger::succes(MESSAGE("Window was closed"));
+	LOG_SUCCES("Window was closed");
+	m_simulation.stop();
+	// draws what is still queued and gives the context back, glfwTerminate needs it here
+	RenderThread::getInstance().stop();
+	// the scenes (and their meshes) are gone by now, the shaders and textures go next
+	// and whatever the GLNamePool still holds is deleted while there is a context
+	// (no texture may be streamed in while they go)
+	TextureResidency::getInstance().shutdown();
+	PipelineStatistics::getInstance().shutdown();
+	ResourceManager::Clear();
+	GpuBufferArenas::getInstance().shutdown();
+	GLNamePool::getInstance().shutdown();
+	JobSystem::getInstance().stop();
+	// how big the object pools got, the chunks are sized from these
+	ObjectPool::forEachPool([](ObjectPool& pool) {
+		ObjectPoolStats stats = pool.getStats();
+		LOG_INFO("POOL: {} peak {} live {} in {} chunks ({} allocations)", stats.name, stats.highWater, stats.live, stats.chunks, stats.allocations);
+	});
+	GLDebug::getInstance().logSummary();
 	glfwTerminate();
-	Logger::succes(MESSAGE("Gl cleanup complete"));
+	LOG_SUCCES("Gl cleanup complete");
 }
 
 void Game::Init()
 {
+	// the thread that creates the GL context is the JobSystem's main thread
+	// (does nothing when main already started it with a specific amount of workers)
+	JobSystem::getInstance().start();
+	// scratch memory for the frames, one arena per JobSystem thread
+	FrameArena::getInstance().init(JobSystem::getInstance().threadCount());
 	glfwInit();
 	createWindow();
 	// GLAD manages function pointers for OpenGL 
 	// so we want to initialize GLAD before we call any OpenGL function
 	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
 	{
-		Logger::error(
-			MESSAGE("Failed to initialize GLAD")
-		);
+		LOG_ERROR("Failed to initialize GLAD");
 		glfwTerminate();
 		return;
 	}
+	// the driver's errors and performance warnings go to the Logger (--gl-debug=1)
+	GLDebug::getInstance().init();
 	// sets the callbacks for all devices (keyboard , display , window , mouse, etc...)
 	registerCallbacks();
 	// sets up ImGui
 	UIManager::getInstance().Init(m_gameWindow);
 	// enables VSync
 	// https://www.khronos.org/opengl/wiki/Swap_Interval
-	glfwSwapInterval(1);
+	// a headless run measures how fast we can go, so it should never wait on the display
+	m_enabledVSync = !m_headless;
+	glfwSwapInterval(m_enabledVSync ? 1 : 0);
 	// enables OpenGL to use the Z-buffer
 	glEnable(GL_DEPTH_TEST);
 	// set the input mode of the cursor
 	glfwSetInputMode(m_gameWindow, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+	// the textures' mip levels are picked from the objects' size in pixels
+	TextureResidency::getInstance().setViewportHeight((float)m_windowHeight);
+	// what the GPU counts per frame, if the driver can tell us
+	PipelineStatistics::getInstance().init();
+	// a render thread swaps the frames itself
+	RenderThread::getInstance().setSwapCallback([this](double inputTime) {
+		presented(inputTime);
+	});
 }
 
 void Game::registerCallbacks()
@@ -75,16 +110,25 @@ void Game::registerCallbacks()
 void Game::createWindow()
 {
 	// a list of all options : https://www.glfw.org/docs/latest/window.html#window_hints
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	// the driver's debug messages need OpenGL 4.3 (see GLDebug), everything else runs on 3.3
+	bool debugContext = GLDebug::getInstance().isRequested();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, debugContext ? 4 : 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, debugContext ? GLFW_TRUE : GLFW_FALSE);
+	// GLFW always needs a window to own the context, headless just means nobody gets to see it
+	glfwWindowHint(GLFW_VISIBLE, m_headless ? GLFW_FALSE : GLFW_TRUE);
 	// This window object holds all the windowing data and is required by most of GLFW's other functions.
 	m_gameWindow = glfwCreateWindow(WINDOW_STD_WIDTH, WINDOW_STD_HEIGHT, WINDOW_STD_NAME, NULL, NULL);
+	if (m_gameWindow == NULL && debugContext)
+	{
+		// a driver without 4.3 still runs the engine, GLDebug::init tells that there are no messages
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		m_gameWindow = glfwCreateWindow(WINDOW_STD_WIDTH, WINDOW_STD_HEIGHT, WINDOW_STD_NAME, NULL, NULL);
+	}
 	if (m_gameWindow == NULL)
 	{
-		Logger::error(
-			MESSAGE("Failed to create GLFW window")
-		);
+		LOG_ERROR("Failed to create GLFW window");
 		glfwTerminate();
 		return;
 	}
@@ -98,21 +142,210 @@ void Game::loadResources()
 	// the language has it's own datatypes and input output features
 	ResourceManager::LoadShader("vertexShaders.glsl", "fragmentShaders.glsl", nullptr, STD_SHADER);
 	UIManager::getInstance().generateEngineUI();
+	UIManager::getInstance().populateFramePacingPanel(&m_framePacer);
+	UIManager::getInstance().populateMemoryPanel();
+	UIManager::getInstance().populateRenderStatsPanel();
 }
 
 void Game::Update(float dt)
 {
+	// the UI may move objects, a running simulation has to wait for that between two ticks
+	auto lock = m_simulation.lockWorld();
 	UIManager::getInstance().update(dt);
 }
 
+void Game::presented(double inputTime)
+{
+	// the GL objects released during this frame are deleted once the GPU is done with it
+	// and the mesh ranges given back (or moved away from) become free again the same way
+	GLNamePool::getInstance().endFrame();
+	GpuBufferArenas::getInstance().endFrame();
+	// the pipeline statistics queries go from one swap to the next
+	PipelineStatistics::getInstance().frameBoundary();
+
+	if (!m_inputLatency.isEnabled() || inputTime < 0.0)
+		return;
+	// the swap only queues the frame, waiting for the GPU gets us a lot closer to when it's actually visible
+	glFinish();
+	m_inputLatency.record(inputTime, FramePacer::now());
+}
+
+double Game::latchInput()
+{
+	// CHECK EVENTS    ==========================================
+	// poll IO events (keys pressed/released, mouse moved etc.)
+	// this happens at the start of the frame (and not at the end of the one before) so the camera
+	// reflects the mouse in this frame instead of the next, and before "cull" so it culls with that camera
+	glfwPollEvents();
+
+	// the callbacks (and any other thread) only queued their events, they are all handled here at once
+	// UI handlers may move GameObjects, a running simulation waits for that between two ticks
+	auto lock = m_simulation.lockWorld();
+	double oldestInput = -1.0;
+	UIEventQueue::getInstance().drain([this, &oldestInput](const UIEvent& event) {
+		if (event.type != UIEventType::UI_CHANGED && event.type != UIEventType::SHADER_RELOAD && oldestInput < 0.0)
+			oldestInput = event.time;
+		handleEvent(event);
+	});
+	return oldestInput;
+}
+
+void Game::handleEvent(const UIEvent& event)
+{
+	// the name is only looked up again when the scene was replaced or isn't there yet
+	Scene* mainScene = UIManager::getScene(m_mainScene);
+	if (!mainScene)
+	{
+		m_mainScene = UIManager::findScene(StringID(STD_SCENE));
+		mainScene = UIManager::getScene(m_mainScene);
+	}
+	Camera* camera = mainScene ? mainScene->getCamera() : nullptr;
+	switch (event.type)
+	{
+	case UIEventType::CAMERA_ORBIT:
+		if (camera)
+			camera->processOrbit(event.motion.x, event.motion.y);
+		break;
+	case UIEventType::CAMERA_PAN:
+		if (camera)
+			camera->processPan(event.motion.x, event.motion.y);
+		break;
+	case UIEventType::CAMERA_ZOOM:
+		if (camera)
+			camera->processZoom(event.motion.y);
+		break;
+	case UIEventType::WINDOW_RESIZED:
+	{
+		// We have to tell OpenGL the size of the rendering window 
+		// so OpenGL knows how we want to display the data and coordinates 
+		// with respect to the window.
+		// (the context may be on the render thread, RenderThread::run just calls it when it isn't)
+		int width = (int)event.motion.x, height = (int)event.motion.y;
+		RenderThread::getInstance().run([width, height]() {
+			glViewport(0, 0, width, height);
+		});
+		if (camera && width > 0 && height > 0)
+			camera->updateProjection(event.motion.x, event.motion.y);
+		if (height > 0)
+			TextureResidency::getInstance().setViewportHeight(event.motion.y);
+		break;
+	}
+	case UIEventType::KEY:
+		handleKey(event.key.key, event.key.action);
+		break;
+	case UIEventType::UI_CHANGED:
+	{
+		BaseUIElement* element = BaseUIElement::find(event.element);
+		if (element && element->getHandler())
+			element->runHandler();
+		break;
+	}
+	case UIEventType::SHADER_RELOAD:
+	{
+		Shader* shader = ResourceManager::GetShader(ResourceManager::FindShader(StringID(event.name)));
+		if (!shader)
+		{
+			LOG_WARNING("Can't reload unknown shader {}", std::string(event.name));
+			break;
+		}
+		FlightRecorder::record(FlightEventType::SHADER_RELOAD, event.name);
+		// the sources are copied before the shader is replaced
+		std::string vertexSource = shader->getVertexSource();
+		std::string fragmentSource = shader->getFragmentSource();
+		std::string geometrySource = shader->getGeometrySource() ? shader->getGeometrySource() : "";
+		ResourceManager::LoadShader(vertexSource.c_str(), fragmentSource.c_str(), geometrySource.empty() ? nullptr : geometrySource.c_str(), event.name);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+void Game::handleKey(int key, int action)
+{
+	// when a user presses the escape key, we set the WindowShouldClose property to true, closing the application
+	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
+	{
+		glfwSetWindowShouldClose(m_gameWindow, true);
+		LOG_INFO("ESC pressed");
+	}
+
+	if (key == GLFW_KEY_1 && action == GLFW_RELEASE)
+	{
+		m_enabledDepthTest = !m_enabledDepthTest;
+		bool depthTest = m_enabledDepthTest;
+		RenderThread::getInstance().run([depthTest]() {
+			depthTest ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
+		});
+		LOG_INFO("Changed depth test");
+	}
+
+	if (key == GLFW_KEY_2 && action == GLFW_RELEASE)
+	{
+		m_enabledCaptureCursor = !m_enabledCaptureCursor;
+		m_enabledCaptureCursor ? glfwSetInputMode(m_gameWindow, GLFW_CURSOR, GLFW_CURSOR_CAPTURED) : glfwSetInputMode(m_gameWindow, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+		LOG_INFO("Changed cursor mode");
+	}
+
+	if (key == GLFW_KEY_F9 && action == GLFW_RELEASE)
+	{
+		// what the last few seconds looked like, without waiting for a crash
+		if (FlightRecorder::dump())
+			LOG_INFO("Dumped the flight recorder");
+		else
+			LOG_WARNING("Could not write the flight recorder dump");
+	}
+
+	if (key == GLFW_KEY_3 && action == GLFW_RELEASE)
+	{
+		m_enabledVSync = !m_enabledVSync;
+		// the swap interval belongs to the context as well
+		int interval = m_enabledVSync ? 1 : 0;
+		RenderThread::getInstance().run([interval]() {
+			glfwSwapInterval(interval);
+		});
+		LOG_INFO("Changed v-sync");
+	}
+
+	if (key >= 0 && key < 1024)
+	{
+		if (action == GLFW_PRESS)
+		{
+			m_keys[key] = true;
+		}
+		else if (action == GLFW_RELEASE)
+		{
+			m_keys[key] = false;
+		}
+	}
+}
+
 void Game::Render()
 {
-	// is a state-setting function
-	glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-	// is a state-using function
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	// with a render thread this records the frame instead of drawing it (same calls, see UIManager)
+	// the render thread clears, draws, and swaps it while the next frame runs here
+	RenderThread& renderThread = RenderThread::getInstance();
+	if (renderThread.isRunning())
+	{
+		FrameCommands& frame = renderThread.beginFrame();
+		frame.clearColor = glm::vec4(0.1f, 0.1f, 0.1f, 1.0f);
+		frame.inputTime = m_frameInputTime;
+	}
+	else
+	{
+		// is a state-setting function
+		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+		// is a state-using function
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	}
 	UIManager::getInstance().RenderActiveScenes();
-	UIManager::getInstance().RenderEngineUI();
+	{
+		// the panels read and write GameObject transforms (only locked for the UI, the scenes draw from snapshots)
+		auto lock = m_simulation.lockWorld();
+		UIManager::getInstance().RenderEngineUI();
+	}
+	if (renderThread.isRunning())
+		renderThread.submitFrame();
 }
 
 void Game::Run()
@@ -137,14 +370,21 @@ void Game::Run()
 
 	// DURING the drawing loop:
 	// ------------------------
-	// 1) Render calls the UIManger's RenderActiveScenes and then RenderUI
-	//  1.1) RenderActiveScenes calls renderScene on only the Scenes in which 'active' attribute is set to 'true'
-	//    1.1.1) renderScene = calls draw on every GameObject(such as Cube, Spheres) (glUseProgram + glDrawElements)
-	// 	  1.1.2) RenderUI    = calls all ImGui functions to draw and setup the UI + gathering input data
+	// 1) the frame's TaskGraph runs (see buildFrameGraph), the steps in between run on the worker threads
+	//  1.1) update     = polls the events and applies the camera input (latchInput, 2) happens here), then
+	//                    based upon input data perform some actions such are recompiling shaders or adjusting Uniforms
+	//  1.2) transforms = rebuild the model matrices of everything that moved
+	//  1.3) cull       = throw away every object outside the camera's view
+	//  1.4) draw lists = collect what is left for the GL thread
+	//  1.5) submit     = Render calls the UIManger's RenderActiveScenes and then RenderUI
+	//    1.5.1) RenderActiveScenes calls submit on only the Scenes in which 'active' attribute is set to 'true'
+	//           (glUseProgram + glDrawElements for every collected object)
+	// 	  1.5.2) RenderUI    = calls all ImGui functions to draw and setup the UI + gathering input data
 	// 	         (e.g.: ImGui::NewFrame(), ImGui::Begin(), ImGui::End(), ImGui::Render())
-	// 2) based upon input data perform some actions such are recompiling shaders or adjusting Uniforms 
-	// 3) glfwPollEvents is called to check for events (the callbacks)
-	// 4) glfwSwapBuffers is called to swap front and back buffer
+	// 2) glfwPollEvents is called to check for events (the callbacks), at the start of 1.1 so culling sees the new camera
+	// 3) glfwSwapBuffers is called to swap front and back buffer
+	// with a render thread (--render-thread) 1.5 only records the frame and the render thread
+	// does the GL calls and 3) while this thread already works on the next frame
 
 
 	// AFTER the drawing loop:
@@ -156,30 +396,96 @@ void Game::Run()
 	// shaders and textures
 	loadResources();
 	
-	float lastFrameTime = 0.0f;
-	float deltaTime = 0.0f;
 	while (!glfwWindowShouldClose(m_gameWindow))
 	{
-		float currentFrameTime = glfwGetTime();
-		deltaTime = currentFrameTime - lastFrameTime;
-		lastFrameTime = currentFrameTime;
-
-		// RENDER ===================================================
-		Render();
+		// waits for the frame cap (if any) and measures the frame in double precision
+		double deltaTime = m_framePacer.beginFrame();
+		Frame((float)deltaTime);
+	}
+};
 
-		// UPDATE   ==========================================
-		Update(deltaTime);
+void Game::Frame(float deltaTime)
+{
+	RenderStats::beginFrame();
+	AllocationTracker::beginFrame();
+	FlightRecorder::beginFrame();
 
-		// CHECK EVENTS    ==========================================
-		// poll IO events (keys pressed/released, mouse moved etc.)
-		glfwPollEvents();
+	// UPDATE -> TRANSFORMS -> CULL -> DRAW LISTS -> SUBMIT =====
+	if (m_frameGraph.size() == 0)
+		buildFrameGraph();
+	m_frameDeltaTime = deltaTime;
+	m_frameGraph.execute();
 
-		// UPDATE WINDOW   ==========================================
-		// windowing applications apply a double buffer for rendering
-		// the Front buffer
-		// the Back buffer
-		// as soon as all the rendering commands are finished we swap the back buffer to the front buffer
-		// so the image can be displayed without still being rendered to avoid any artifacts
+	// UPDATE WINDOW   ==========================================
+	// windowing applications apply a double buffer for rendering
+	// the Front buffer
+	// the Back buffer
+	// as soon as all the rendering commands are finished we swap the back buffer to the front buffer
+	// so the image can be displayed without still being rendered to avoid any artifacts
+	// (a render thread swaps after replaying the frame, this thread doesn't have the context then)
+	if (!RenderThread::getInstance().isRunning())
+	{
+		PROFILE_ZONE("present");
 		glfwSwapBuffers(m_gameWindow);
+		presented(m_frameInputTime);
 	}
+
+	// what the frame before this one allocated for itself is free again
+	FrameArena::getInstance().endFrame();
+	// meshes that were removed left holes in the arenas, a few of the meshes above them move down
+	// (between two frames, nothing is recording draws with the old offsets)
+	GpuBufferArenas::getInstance().compact();
+	// the draws of this frame asked for the mip levels their textures need, the missing ones are streamed in
+	TextureResidency::getInstance().update();
+
+	AllocationFrameStats allocations = AllocationTracker::endFrame();
+	RenderStats::recordAllocations(allocations.allocations, allocations.bytes);
+	RenderStats::recordPipelineStatistics(PipelineStatistics::getInstance().latest());
+	FlightRecorder::endFrame();
+};
+
+void Game::buildFrameGraph()
+{
+	// only "update" and "submit" touch ImGui/OpenGL, they stay on this thread (the one that owns the context,
+	// or with a render thread the one that records the frame for it)
+	// the steps in between run on the workers and split their own work with parallelFor
+	// callbacks (camera, keys) only run in glfwPollEvents at the start of "update", so nothing moves while the
+	// workers run, the camera input they queue is applied right there as well and "cull" uses that camera
+	TaskId update = m_frameGraph.add("update", [this]() {
+		m_frameInputTime = latchInput();
+		Update(m_frameDeltaTime);
+	}, {}, TaskAffinity::MAIN_THREAD);
+
+	// everything that moved since the last frame gets its model matrix rebuilt here, in one batch
+	// with a simulation thread that already happened there, the frame blends its two newest snapshots instead
+	TaskId transforms = m_frameGraph.add("transforms", [this]() {
+		auto start = std::chrono::steady_clock::now();
+		if (m_simulation.isRunning())
+		{
+			size_t blended = m_simulation.interpolate().world.size();
+			RenderStats::recordTransformUpdate(blended, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+			return;
+		}
+		TransformStorage& storage = TransformStorage::getInstance();
+		size_t rebuilt = storage.updateModelMatrices();
+		RenderStats::recordTransformUpdate(rebuilt, storage.lastUpdateMilliseconds());
+	}, { update });
+
+	TaskId cull = m_frameGraph.add("cull", [this]() {
+		UIManager::Scenes.forEach([this](SceneHandle, Scene* scene) {
+			if (scene->isActive)
+				scene->cull(m_simulation.getRenderTransforms());
+		});
+	}, { transforms });
+
+	TaskId drawLists = m_frameGraph.add("draw lists", [this]() {
+		UIManager::Scenes.forEach([this](SceneHandle, Scene* scene) {
+			if (scene->isActive)
+				scene->buildDrawList(m_simulation.getRenderTransforms());
+		});
+	}, { cull });
+
+	m_frameGraph.add("submit", [this]() {
+		Render();
+	}, { drawLists }, TaskAffinity::MAIN_THREAD);
 };
@@ -1,90 +1,154 @@
 #include "UtilClasses/GameObject.h"
+#include "UtilClasses/Scene.h"
+
+#include <algorithm>
+
+ObjectPool& GameObject::getPool()
+{
+	static ObjectPool pool("GameObject");
+	return pool;
+};
 
 GameObject::GameObject()
 {
 	m_material = nullptr;
 	m_mesh = nullptr;
-
-	m_position = glm::vec3(0.0f);
-	m_rotation = glm::vec3(0.0f);
-	m_scale = glm::vec3(1.0f);
-
-	updateModelMatrix();
+	m_transform = TransformStorage::getInstance().create();
 };
 
 GameObject::GameObject(Mesh* mesh, Material* material) 
 {
-	m_mesh = mesh;
+	m_mesh = nullptr;
 	m_material = material;
+	m_transform = TransformStorage::getInstance().create();
+	setMesh(mesh);
+};
+
+GameObject::~GameObject()
+{
+	if (m_scene)
+	{
+		m_scene->removeGameObject(this);
+	}
+	// our children move up to our parent (the TransformStorage does the same with the transforms)
+	for (GameObject* child : m_children)
+	{
+		child->m_parent = m_parent;
+		if (m_parent)
+			m_parent->m_children.push_back(child);
+	}
+	if (m_parent)
+	{
+		auto& siblings = m_parent->m_children;
+		siblings.erase(std::remove(siblings.begin(), siblings.end(), this), siblings.end());
+	}
+	TransformStorage::getInstance().destroy(m_transform);
+	delete m_ownedMesh;
+	delete m_ownedMaterial;
+};
+
+void GameObject::setOwnedMesh(Mesh* mesh)
+{
+	m_ownedMesh = mesh;
+	setMesh(mesh);
+};
 
-	m_position = glm::vec3(0.0f);
-	m_rotation = glm::vec3(0.0f);
-	m_scale = glm::vec3(1.0f);
-	m_model = glm::mat4(1.0f);
+void GameObject::setOwnedMaterial(Material* material)
+{
+	m_ownedMaterial = material;
+	setMaterial(material);
 };
 
+bool GameObject::setParent(GameObject* parent)
+{
+	TransformId parentTransform = parent ? parent->m_transform : INVALID_TRANSFORM;
+	if (!TransformStorage::getInstance().setParent(m_transform, parentTransform))
+	{
+		LOG_WARNING("GAMEOBJECT: Can't attach an object to itself or one of its children");
+		return false;
+	}
+
+	if (m_parent)
+	{
+		auto& siblings = m_parent->m_children;
+		siblings.erase(std::remove(siblings.begin(), siblings.end(), this), siblings.end());
+	}
+	m_parent = parent;
+	if (m_parent)
+	{
+		m_parent->m_children.push_back(this);
+	}
+	return true;
+};
+
+// the setters only store the new value, TransformStorage::updateModelMatrices
+// rebuilds the model matrix once per frame no matter how many setters were called
 void GameObject::setPosition(const glm::vec3& pos)
 {
-	m_position = pos;
-	updateModelMatrix();
+	TransformStorage::getInstance().setPosition(m_transform, pos);
 };
 
 void GameObject::setRotation(const glm::quat& rot)
 {
-	m_rotation = rot;
-	updateModelMatrix();
+	TransformStorage::getInstance().setRotation(m_transform, rot);
 };
 
 void GameObject::setScale(const glm::vec3& scale)
 {
-	m_scale = scale;
-	updateModelMatrix();
+	TransformStorage::getInstance().setScale(m_transform, scale);
 };
 
 void GameObject::setMesh(Mesh* mesh)
 {
 	m_mesh = mesh;
+	// the world bounds are the mesh bounds moved along with the transform
+	TransformBounds bounds;
+	if (mesh)
+	{
+		bounds.min = mesh->getBoundsMin();
+		bounds.max = mesh->getBoundsMax();
+	}
+	TransformStorage::getInstance().setLocalBounds(m_transform, bounds);
+	syncRenderer();
 };
 
 void GameObject::setMaterial(Material* material)
 {
 	m_material = material;
+	syncRenderer();
 };
 
-glm::mat4 GameObject::getModel() { return m_model; };
-glm::vec3 GameObject::getPosition() { return m_position; };
-glm::quat GameObject::getRotation() { return m_rotation; };
-glm::vec3 GameObject::getScale() { return m_scale; };
-Mesh* GameObject::getMesh() { return m_mesh; };
-Material* GameObject::getMaterial() { return m_material; };
+void GameObject::setDrawTriangles(bool drawTriangles)
+{
+	m_drawTriangles = drawTriangles;
+	syncRenderer();
+};
 
-void GameObject::updateModelMatrix()
+void GameObject::syncRenderer()
 {
-	m_model = glm::mat4(1.0f);
-	m_model = glm::translate(m_model, m_position);
-	m_model = m_model * glm::mat4_cast(m_rotation);
-	m_model = glm::scale(m_model, m_scale);
-	// The order (Translate * Rotate * Scale) is for the local coordinate system
-	// In matrix multiplication, this means: M = T * R * S
-	// glm operations apply transformations from right to left if you multiply
-	// the matrix by the new transformation: m_model = transform * m_model
-	// but if you do m_model = m_model * transform, it applies in world space
-	// The way done above is more intuitive and standard: build T, then multiply by R, then by S.
-	// Or, more explicitly:
-	/*
-		glm::mat4 transMatrix = glm::translate(glm::mat4(1.0f), m_position);
-		glm::mat4 rotMatrix = glm::mat4_cast(m_rotation);
-		glm::mat4 scaleMatrix = glm::scale(glm::mat4(1.0f), m_scale);
-		m_model = transMatrix * rotMatrix * scaleMatrix;
-	*/
+	if (!m_scene)
+		return;
+
+	m_scene->updateRenderer(m_entity, m_mesh, m_material, m_drawTriangles);
 };
 
+const glm::mat4& GameObject::getModel() { return TransformStorage::getInstance().getModel(m_transform); };
+glm::vec3 GameObject::getPosition() { return TransformStorage::getInstance().getPosition(m_transform); };
+glm::quat GameObject::getRotation() { return TransformStorage::getInstance().getRotation(m_transform); };
+glm::vec3 GameObject::getScale() { return TransformStorage::getInstance().getScale(m_transform); };
+const TransformBounds& GameObject::getWorldBounds() { return TransformStorage::getInstance().getWorldBounds(m_transform); };
+GameObject* GameObject::getParent() { return m_parent; };
+const std::vector<GameObject*>& GameObject::getChildren() { return m_children; };
+Mesh* GameObject::getMesh() { return m_mesh; };
+bool GameObject::getDrawTriangles() { return m_drawTriangles; };
+Material* GameObject::getMaterial() { return m_material; };
+
 void GameObject::draw(const glm::mat4& view, const glm::mat4& projection)
 {
 	Shader& currentShader = m_material->use();
-	currentShader.SetMatrix4("model", m_model);
-	currentShader.SetMatrix4("view", view);
-	currentShader.SetMatrix4("projection", projection);
+	currentShader.SetMatrix4("model"_sid, getModel());
+	currentShader.SetMatrix4("view"_sid, view);
+	currentShader.SetMatrix4("projection"_sid, projection);
 
-	m_mesh->draw();
+	m_mesh->draw(m_drawTriangles);
 };
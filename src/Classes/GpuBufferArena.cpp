@@ -0,0 +1,590 @@
+#include "UtilClasses/GpuBufferArena.h"
+#include "UtilClasses/RenderThread.h"
+#include "UtilClasses/GLDebug.h"
+#include "ResourceClasses/Mesh.h"
+
+#include <algorithm>
+#include <string>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// index of the lowest / highest set bit, "bits" is never 0
+static uint32_t lowestBit(uint32_t bits)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return (uint32_t)index;
+#else
+    return (uint32_t)__builtin_ctz(bits);
+#endif
+}
+
+static uint32_t highestBit(uint32_t bits)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse(&index, bits);
+    return (uint32_t)index;
+#else
+    return 31 - (uint32_t)__builtin_clz(bits);
+#endif
+}
+
+// TlsfAllocator
+// ------------------------------------------------------------------------------------------------
+
+TlsfAllocator::TlsfAllocator(uint32_t capacity)
+    : m_capacity(capacity)
+{
+    for (uint32_t fl = 0; fl < FL_COUNT; fl++)
+        std::fill(m_heads[fl], m_heads[fl] + SL_COUNT, INVALID);
+
+    // one free block over everything
+    uint32_t block = newBlock();
+    m_blocks[block].size = capacity;
+    m_blocks[block].free = true;
+    m_first = block;
+    m_last = block;
+    if (capacity > 0)
+        insertFree(block);
+};
+
+void TlsfAllocator::mapping(uint32_t size, uint32_t& fl, uint32_t& sl)
+{
+    if (size < SL_COUNT)
+    {
+        fl = 0;
+        sl = size;
+        return;
+    }
+    uint32_t log2 = highestBit(size);
+    fl = log2 - SL_LOG2 + 1;
+    sl = (size >> (log2 - SL_LOG2)) ^ SL_COUNT;
+};
+
+uint32_t TlsfAllocator::findFree(uint32_t size) const
+{
+    // every block in the list of the next bigger class fits, the list of "size" itself may only have smaller ones
+    uint64_t rounded = size;
+    if (size >= SL_COUNT)
+        rounded += (1ull << (highestBit(size) - SL_LOG2)) - 1;
+    if (rounded > m_capacity)
+        return INVALID;
+
+    uint32_t fl, sl;
+    mapping((uint32_t)rounded, fl, sl);
+    uint32_t slBits = m_slBitmap[fl] & (~0u << sl);
+    if (slBits == 0)
+    {
+        uint32_t flBits = fl + 1 < 32 ? m_flBitmap & (~0u << (fl + 1)) : 0;
+        if (flBits == 0)
+            return INVALID;
+        fl = lowestBit(flBits);
+        slBits = m_slBitmap[fl];
+    }
+    return m_heads[fl][lowestBit(slBits)];
+};
+
+void TlsfAllocator::insertFree(uint32_t block)
+{
+    uint32_t fl, sl;
+    mapping(m_blocks[block].size, fl, sl);
+    Block& inserted = m_blocks[block];
+    inserted.previousFree = INVALID;
+    inserted.nextFree = m_heads[fl][sl];
+    if (inserted.nextFree != INVALID)
+        m_blocks[inserted.nextFree].previousFree = block;
+    m_heads[fl][sl] = block;
+    m_slBitmap[fl] |= 1u << sl;
+    m_flBitmap |= 1u << fl;
+    m_freeBlocks++;
+};
+
+void TlsfAllocator::removeFree(uint32_t block)
+{
+    uint32_t fl, sl;
+    mapping(m_blocks[block].size, fl, sl);
+    Block& removed = m_blocks[block];
+    if (removed.previousFree != INVALID)
+        m_blocks[removed.previousFree].nextFree = removed.nextFree;
+    else
+        m_heads[fl][sl] = removed.nextFree;
+    if (removed.nextFree != INVALID)
+        m_blocks[removed.nextFree].previousFree = removed.previousFree;
+    removed.previousFree = INVALID;
+    removed.nextFree = INVALID;
+
+    if (m_heads[fl][sl] == INVALID)
+    {
+        m_slBitmap[fl] &= ~(1u << sl);
+        if (m_slBitmap[fl] == 0)
+            m_flBitmap &= ~(1u << fl);
+    }
+    m_freeBlocks--;
+};
+
+uint32_t TlsfAllocator::newBlock()
+{
+    if (!m_unusedBlocks.empty())
+    {
+        uint32_t block = m_unusedBlocks.back();
+        m_unusedBlocks.pop_back();
+        m_blocks[block] = Block();
+        return block;
+    }
+    m_blocks.emplace_back();
+    return (uint32_t)(m_blocks.size() - 1);
+};
+
+uint32_t TlsfAllocator::use(uint32_t block, uint32_t size, uint64_t owner)
+{
+    // what is left behind the allocation becomes a free block of its own
+    if (m_blocks[block].size > size)
+    {
+        uint32_t rest = newBlock();
+        Block& used = m_blocks[block];
+        Block& remainder = m_blocks[rest];
+        remainder.offset = used.offset + size;
+        remainder.size = used.size - size;
+        remainder.free = true;
+        remainder.previousPhysical = block;
+        remainder.nextPhysical = used.nextPhysical;
+        if (used.nextPhysical != INVALID)
+            m_blocks[used.nextPhysical].previousPhysical = rest;
+        else
+            m_last = rest;
+        used.nextPhysical = rest;
+        used.size = size;
+        insertFree(rest);
+    }
+    Block& used = m_blocks[block];
+    used.free = false;
+    used.owner = owner;
+    m_used += size;
+    m_allocations++;
+    return block;
+};
+
+uint32_t TlsfAllocator::allocate(uint32_t size, uint64_t owner)
+{
+    if (size == 0)
+        return INVALID;
+    uint32_t block = findFree(size);
+    if (block == INVALID)
+        return INVALID;
+    removeFree(block);
+    return use(block, size, owner);
+};
+
+uint32_t TlsfAllocator::allocateBelow(uint32_t size, uint32_t limit, uint64_t owner)
+{
+    if (size == 0)
+        return INVALID;
+    for (uint32_t block = m_first; block != INVALID && m_blocks[block].offset < limit; block = m_blocks[block].nextPhysical)
+    {
+        const Block& candidate = m_blocks[block];
+        if (candidate.free && candidate.size >= size && candidate.offset + size <= limit)
+        {
+            removeFree(block);
+            return use(block, size, owner);
+        }
+    }
+    return INVALID;
+};
+
+void TlsfAllocator::absorb(uint32_t first, uint32_t second)
+{
+    Block& kept = m_blocks[first];
+    const Block& merged = m_blocks[second];
+    kept.size += merged.size;
+    kept.nextPhysical = merged.nextPhysical;
+    if (merged.nextPhysical != INVALID)
+        m_blocks[merged.nextPhysical].previousPhysical = first;
+    else
+        m_last = first;
+    m_unusedBlocks.push_back(second);
+};
+
+void TlsfAllocator::free(uint32_t block)
+{
+    Block& freed = m_blocks[block];
+    m_used -= freed.size;
+    m_allocations--;
+    freed.free = true;
+    freed.owner = NO_OWNER;
+
+    // merged with the free neighbours, so two free blocks never touch
+    uint32_t previous = freed.previousPhysical;
+    if (previous != INVALID && m_blocks[previous].free)
+    {
+        removeFree(previous);
+        absorb(previous, block);
+        block = previous;
+    }
+    uint32_t next = m_blocks[block].nextPhysical;
+    if (next != INVALID && m_blocks[next].free)
+    {
+        removeFree(next);
+        absorb(block, next);
+    }
+    insertFree(block);
+};
+
+TlsfStats TlsfAllocator::getStats() const
+{
+    TlsfStats stats;
+    stats.capacity = m_capacity;
+    stats.used = m_used;
+    stats.allocations = m_allocations;
+    stats.freeBlocks = m_freeBlocks;
+    // the biggest block is in the highest non-empty list, which holds sizes of one class only
+    if (m_flBitmap != 0)
+    {
+        uint32_t fl = highestBit(m_flBitmap);
+        uint32_t sl = highestBit(m_slBitmap[fl]);
+        for (uint32_t block = m_heads[fl][sl]; block != INVALID; block = m_blocks[block].nextFree)
+            stats.largestFree = std::max(stats.largestFree, m_blocks[block].size);
+    }
+    return stats;
+};
+
+// GpuBufferArenas
+// ------------------------------------------------------------------------------------------------
+
+GpuBufferArenas& GpuBufferArenas::getInstance()
+{
+    static GpuBufferArenas instance;
+    return instance;
+};
+
+std::unique_ptr<GpuBufferArenas::Arena> GpuBufferArenas::createArena(uint32_t vertexCapacity, uint32_t indexCapacity)
+{
+    std::unique_ptr<Arena> arena = std::make_unique<Arena>(vertexCapacity, indexCapacity);
+    arena->vertexArray = GLVertexArray::create();
+    arena->vertexBuffer = GLBuffer::create();
+    arena->indexBuffer = GLBuffer::create();
+
+    // storage only, the meshes fill their ranges with glBufferSubData (upload)
+    glBindVertexArray(arena->vertexArray.get());
+    glBindBuffer(GL_ARRAY_BUFFER, arena->vertexBuffer.get());
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)vertexCapacity * sizeof(Vertex), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, arena->indexBuffer.get());
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)indexCapacity * sizeof(unsigned int), nullptr, GL_STATIC_DRAW);
+
+    // the layout every mesh used to set on its own VAO, a mesh's first vertex is the draw's base vertex
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_normal));
+    glEnableVertexAttribArray(1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    return arena;
+};
+
+bool GpuBufferArenas::allocateFrom(uint32_t arena, GpuMeshRange& range, uint32_t vertexCount, uint32_t indexCount)
+{
+    Arena& from = *m_arenas[arena];
+    uint32_t vertexBlock = from.vertices.allocate(vertexCount, TlsfAllocator::NO_OWNER);
+    if (vertexBlock == TlsfAllocator::INVALID)
+        return false;
+    uint32_t indexBlock = TlsfAllocator::INVALID;
+    if (indexCount > 0)
+    {
+        indexBlock = from.indices.allocate(indexCount, TlsfAllocator::NO_OWNER);
+        if (indexBlock == TlsfAllocator::INVALID)
+        {
+            from.vertices.free(vertexBlock);
+            return false;
+        }
+    }
+
+    range.vertexArray = from.vertexArray.get();
+    range.vertexBuffer = from.vertexBuffer.get();
+    range.indexBuffer = from.indexBuffer.get();
+    range.arena = arena;
+    range.firstVertex = from.vertices.offset(vertexBlock);
+    range.vertexCount = vertexCount;
+    range.vertexBlock = vertexBlock;
+    range.firstIndex = indexCount > 0 ? from.indices.offset(indexBlock) : 0;
+    range.indexCount = indexCount;
+    range.indexBlock = indexBlock;
+    return true;
+};
+
+GpuMeshHandle GpuBufferArenas::allocate(uint32_t vertexCount, uint32_t indexCount)
+{
+    if (vertexCount == 0)
+        return GpuMeshHandle();
+
+    GpuMeshRange range;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_shutdown)
+        return GpuMeshHandle();
+    bool allocated = false;
+    for (uint32_t arena = 0; arena < (uint32_t)m_arenas.size() && !allocated; arena++)
+        allocated = allocateFrom(arena, range, vertexCount, indexCount);
+
+    if (!allocated)
+    {
+        // only the main thread adds arenas, the index is still free once the lock is back
+        uint32_t index = (uint32_t)m_arenas.size();
+        // the render thread may be in endFrame waiting for the lock, so the GL objects are made without it
+        lock.unlock();
+        std::unique_ptr<Arena> arena;
+        RenderThread::getInstance().runSync([&arena, vertexCount, indexCount, index]() {
+            arena = createArena(std::max(vertexCount, VERTEX_CAPACITY), std::max(indexCount, INDEX_CAPACITY));
+            // the names the driver's messages (and a frame debugger) show
+            std::string label = "mesh arena " + std::to_string(index);
+            GLDebug::getInstance().label(GL_VERTEX_ARRAY, arena->vertexArray.get(), label);
+            GLDebug::getInstance().label(GL_BUFFER, arena->vertexBuffer.get(), label + " vertices");
+            GLDebug::getInstance().label(GL_BUFFER, arena->indexBuffer.get(), label + " indices");
+        });
+        lock.lock();
+
+        arena->memory.track(MemoryCategory::MESHES, "mesh arena " + std::to_string(index),
+            (size_t)arena->vertices.getCapacity() * sizeof(Vertex) + (size_t)arena->indices.getCapacity() * sizeof(unsigned int));
+        m_arenas.push_back(std::move(arena));
+        allocateFrom(index, range, vertexCount, indexCount);
+        LOG_INFO("ARENA: Created mesh arena {} ({} vertices, {} indices)", index, m_arenas[index]->vertices.getCapacity(), m_arenas[index]->indices.getCapacity());
+    }
+
+    // the blocks know their mesh, compaction has to find the range it moves
+    GpuMeshHandle handle = m_ranges.add(range);
+    Arena& arena = *m_arenas[range.arena];
+    arena.vertices.setOwner(range.vertexBlock, ownerOf(handle));
+    if (range.indexBlock != TlsfAllocator::INVALID)
+        arena.indices.setOwner(range.indexBlock, ownerOf(handle));
+    return handle;
+};
+
+void GpuBufferArenas::upload(const GpuMeshRange& range, const Vertex* vertices, const unsigned int* indices)
+{
+    // through the copy target, the element buffer binding belongs to whatever VAO is bound
+    glBindBuffer(GL_COPY_WRITE_BUFFER, range.vertexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)range.firstVertex * sizeof(Vertex), (GLsizeiptr)range.vertexCount * sizeof(Vertex), vertices);
+    if (range.indexCount > 0)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, range.indexBuffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)range.firstIndex * sizeof(unsigned int), (GLsizeiptr)range.indexCount * sizeof(unsigned int), indices);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+};
+
+void GpuBufferArenas::release(GpuMeshHandle handle)
+{
+    Retired retired[2];
+    size_t count = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const GpuMeshRange* range = m_ranges.get(handle);
+        if (!range)
+            return;
+        retired[count++] = { range->arena, false, range->vertexBlock };
+        if (range->indexBlock != TlsfAllocator::INVALID)
+            retired[count++] = { range->arena, true, range->indexBlock };
+        m_ranges.remove(handle);
+        // the arenas are gone
+        if (m_shutdown)
+            return;
+        // no owner keeps compaction from moving a block that is on its way out
+        for (size_t i = 0; i < count; i++)
+        {
+            Arena& arena = *m_arenas[retired[i].arena];
+            (retired[i].index ? arena.indices : arena.vertices).setOwner(retired[i].block, TlsfAllocator::NO_OWNER);
+        }
+    }
+    // through the render thread's queue, so frames recorded before this still find their vertices
+    RenderThread::getInstance().run([retired, count]() {
+        for (size_t i = 0; i < count; i++)
+            GpuBufferArenas::getInstance().retire(retired[i]);
+    });
+};
+
+void GpuBufferArenas::retire(const Retired& retired)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_shutdown)
+        m_retired.push_back(retired);
+};
+
+void GpuBufferArenas::free(const Retired& retired)
+{
+    Arena& arena = *m_arenas[retired.arena];
+    (retired.index ? arena.indices : arena.vertices).free(retired.block);
+};
+
+void GpuBufferArenas::endFrame()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_shutdown)
+        return;
+
+    if (!m_retired.empty())
+    {
+        FencedRetired fenced;
+        fenced.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        fenced.blocks.swap(m_retired);
+        m_fenced.push_back(std::move(fenced));
+    }
+
+    // the fences signal in order, stop at the first one that hasn't
+    while (!m_fenced.empty())
+    {
+        FencedRetired& oldest = m_fenced.front();
+        GLenum state = glClientWaitSync(oldest.fence, 0, 0);
+        if (state != GL_ALREADY_SIGNALED && state != GL_CONDITION_SATISFIED)
+            break;
+        glDeleteSync(oldest.fence);
+        for (const Retired& retired : oldest.blocks)
+            free(retired);
+        m_fenced.pop_front();
+    }
+};
+
+void GpuBufferArenas::collectMoves(uint32_t arena, bool index, size_t& bytes, Move* moves, size_t& moveCount)
+{
+    Arena& from = *m_arenas[arena];
+    TlsfAllocator& allocator = index ? from.indices : from.vertices;
+    if (allocator.isPacked())
+        return;
+    size_t elementSize = index ? sizeof(unsigned int) : sizeof(Vertex);
+    GLuint buffer = index ? from.indexBuffer.get() : from.vertexBuffer.get();
+
+    // the highest allocations first, each one into the lowest hole below it that fits
+    size_t candidates = 0;
+    for (uint32_t block = allocator.last(); block != TlsfAllocator::INVALID && candidates < COMPACTION_CANDIDATES && moveCount < MAX_MOVES; block = allocator.previous(block))
+    {
+        uint64_t owner = allocator.owner(block);
+        if (allocator.isFree(block) || owner == TlsfAllocator::NO_OWNER)
+            continue;
+        candidates++;
+        size_t blockBytes = allocator.size(block) * elementSize;
+        if (blockBytes > bytes)
+            continue;
+        uint32_t target = allocator.allocateBelow(allocator.size(block), allocator.offset(block), owner);
+        if (target == TlsfAllocator::INVALID)
+            continue;
+
+        GpuMeshRange* range = m_ranges.get(handleOf(owner));
+        if (index)
+        {
+            range->firstIndex = allocator.offset(target);
+            range->indexBlock = target;
+        }
+        else
+        {
+            range->firstVertex = allocator.offset(target);
+            range->vertexBlock = target;
+        }
+        allocator.setOwner(block, TlsfAllocator::NO_OWNER);
+        moves[moveCount++] = { buffer, allocator.offset(block) * elementSize, allocator.offset(target) * elementSize, blockBytes, { arena, index, block } };
+        bytes -= blockBytes;
+        m_moves++;
+        m_movedBytes += blockBytes;
+    }
+};
+
+void GpuBufferArenas::compact(size_t bytes)
+{
+    Move moves[MAX_MOVES];
+    size_t moveCount = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_shutdown)
+            return;
+        for (uint32_t arena = 0; arena < (uint32_t)m_arenas.size(); arena++)
+        {
+            collectMoves(arena, false, bytes, moves, moveCount);
+            collectMoves(arena, true, bytes, moves, moveCount);
+        }
+    }
+    if (moveCount == 0)
+        return;
+
+    // the ranges already point at the new place, the copies are queued in front of the next frame that uses them
+    // the old ranges don't overlap the new ones (they are below them), so a copy inside one buffer is fine
+    std::vector<Move> queued(moves, moves + moveCount);
+    RenderThread::getInstance().run([queued]() {
+        GpuBufferArenas& arenas = GpuBufferArenas::getInstance();
+        for (const Move& move : queued)
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, move.buffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, move.buffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr)move.from, (GLintptr)move.to, (GLsizeiptr)move.bytes);
+            arenas.retire(move.retired);
+        }
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    });
+};
+
+void GpuBufferArenas::shutdown()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_shutdown)
+        return;
+    for (FencedRetired& fenced : m_fenced)
+        glDeleteSync(fenced.fence);
+    m_fenced.clear();
+    m_retired.clear();
+    // their buffers go to the GLNamePool, which deletes them right after this
+    m_arenas.clear();
+    m_shutdown = true;
+};
+
+GpuBufferArenaStats GpuBufferArenas::getStats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    GpuBufferArenaStats stats;
+    stats.arenas = m_arenas.size();
+    stats.meshes = m_ranges.size();
+    stats.moves = m_moves;
+    stats.movedBytes = m_movedBytes;
+    stats.pendingFrees = m_retired.size();
+    for (const FencedRetired& fenced : m_fenced)
+        stats.pendingFrees += fenced.blocks.size();
+
+    size_t scatteredBytes = 0;
+    for (const std::unique_ptr<Arena>& arena : m_arenas)
+    {
+        TlsfStats vertices = arena->vertices.getStats();
+        TlsfStats indices = arena->indices.getStats();
+        stats.capacityBytes += (size_t)vertices.capacity * sizeof(Vertex) + (size_t)indices.capacity * sizeof(unsigned int);
+        stats.usedBytes += (size_t)vertices.used * sizeof(Vertex) + (size_t)indices.used * sizeof(unsigned int);
+        stats.freeBlocks += vertices.freeBlocks + indices.freeBlocks;
+        stats.largestFreeBytes = std::max(stats.largestFreeBytes, (size_t)vertices.largestFree * sizeof(Vertex));
+        scatteredBytes += (size_t)(vertices.capacity - vertices.used - vertices.largestFree) * sizeof(Vertex);
+        scatteredBytes += (size_t)(indices.capacity - indices.used - indices.largestFree) * sizeof(unsigned int);
+    }
+    stats.freeBytes = stats.capacityBytes - stats.usedBytes;
+    stats.fragmentation = stats.freeBytes > 0 ? (float)scatteredBytes / (float)stats.freeBytes : 0.0f;
+    return stats;
+};
+
+// GpuMeshAllocation
+// ------------------------------------------------------------------------------------------------
+
+void GpuMeshAllocation::allocate(uint32_t vertexCount, uint32_t indexCount)
+{
+    reset();
+    m_handle = GpuBufferArenas::getInstance().allocate(vertexCount, indexCount);
+};
+
+void GpuMeshAllocation::reset()
+{
+    if (!m_handle.valid())
+        return;
+    GpuBufferArenas::getInstance().release(m_handle);
+    m_handle = GpuMeshHandle();
+};
+
+const GpuMeshRange& GpuMeshAllocation::range() const
+{
+    static const GpuMeshRange empty;
+    const GpuMeshRange* range = GpuBufferArenas::getInstance().getRange(m_handle);
+    return range ? *range : empty;
+};
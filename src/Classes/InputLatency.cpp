@@ -0,0 +1,32 @@
+#include "UtilClasses/InputLatency.h"
+
+#include <algorithm>
+
+#include "UtilClasses/Logger.h"
+
+void InputLatency::record(double inputTime, double swapTime)
+{
+    if (inputTime < 0.0)
+        return;
+
+    double latencyMs = (swapTime - inputTime) * 1000.0;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.lastMs = latencyMs;
+    m_stats.minMs = m_stats.frames ? std::min(m_stats.minMs, latencyMs) : latencyMs;
+    m_stats.maxMs = m_stats.frames ? std::max(m_stats.maxMs, latencyMs) : latencyMs;
+    m_stats.totalMs += latencyMs;
+    m_stats.frames++;
+
+    if (m_stats.frames >= REPORT_FRAMES)
+    {
+        LOG_INFO("INPUT: Input to swap latency over {} frames: mean {} ms, min {} ms, max {} ms", m_stats.frames, m_stats.meanMs(), m_stats.minMs, m_stats.maxMs);
+        m_stats = InputLatencyStats();
+        m_stats.lastMs = latencyMs;
+    }
+};
+
+InputLatencyStats InputLatency::getStats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+};
@@ -0,0 +1,210 @@
+#include "UtilClasses/JobSystem.h"
+
+#include "UtilClasses/Logger.h"
+
+// the index of the calling thread's queue in m_queues (workers 0..n-1, the main thread n)
+static const size_t NO_QUEUE = (size_t)-1;
+static thread_local size_t t_queueIndex = NO_QUEUE;
+
+JobSystem& JobSystem::getInstance()
+{
+    static JobSystem instance;
+    return instance;
+};
+
+JobSystem::~JobSystem()
+{
+    stop();
+};
+
+void JobSystem::start(size_t workerCount)
+{
+    if (m_running)
+        return;
+
+    if (workerCount == DEFAULT_WORKERS)
+    {
+        size_t cores = std::thread::hardware_concurrency();
+        workerCount = cores > 1 ? cores - 1 : 0;
+    }
+
+    m_mainThread = std::this_thread::get_id();
+    m_queues.clear();
+    for (size_t i = 0; i < workerCount + 1; i++)
+    {
+        m_queues.push_back(std::make_unique<WorkQueue>());
+    }
+    t_queueIndex = workerCount;
+
+    m_running = true;
+    for (size_t i = 0; i < workerCount; i++)
+    {
+        m_workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+    LOG_INFO("JOBS: Started {} worker threads", workerCount);
+};
+
+void JobSystem::stop()
+{
+    if (!m_running)
+        return;
+
+    // whatever is still queued gets done first, nobody waits on a job that never runs
+    while (runPendingJob()) {}
+
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_running = false;
+    }
+    m_wakeUp.notify_all();
+    for (std::thread& worker : m_workers)
+    {
+        worker.join();
+    }
+    m_workers.clear();
+    m_queues.clear();
+    t_queueIndex = NO_QUEUE;
+};
+
+size_t JobSystem::threadIndex() const
+{
+    return t_queueIndex < m_workers.size() ? t_queueIndex : m_workers.size();
+};
+
+bool JobSystem::isPoolThread() const
+{
+    return t_queueIndex < m_queues.size();
+};
+
+JobSystem::WorkQueue* JobSystem::ownQueue()
+{
+    if (t_queueIndex < m_queues.size())
+        return m_queues[t_queueIndex].get();
+    return nullptr;
+};
+
+void JobSystem::push(Job& job)
+{
+    if (job.counter)
+        job.counter->remaining.fetch_add(1, std::memory_order_relaxed);
+
+    if (m_queues.empty())
+    {
+        // never started (or already stopped): behave like a single threaded engine
+        execute(job);
+        return;
+    }
+
+    // threads that are not part of the pool hand their jobs to the main thread's queue
+    WorkQueue* queue = ownQueue();
+    if (!queue)
+        queue = m_queues.back().get();
+    {
+        std::unique_lock<std::mutex> lock(queue->mutex);
+        if (queue->back - queue->front == WorkQueue::CAPACITY)
+        {
+            // growing the ring would allocate, the job runs right here instead
+            lock.unlock();
+            execute(job);
+            return;
+        }
+        // counted before it is visible, a thief may take it right after the push
+        m_queuedJobs.fetch_add(1, std::memory_order_release);
+        queue->jobs[queue->back % WorkQueue::CAPACITY] = job;
+        queue->back++;
+    }
+
+    // taking the lock (even for nothing) makes sure a worker that just found no jobs is either
+    // still before its check or already waiting, so this notification can't get lost
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_wakeUp.notify_one();
+};
+
+void JobSystem::wait(JobCounter& counter)
+{
+    while (counter.remaining.load(std::memory_order_acquire) > 0)
+    {
+        // help instead of blocking, the job we wait for may well be in our own queue
+        if (!runPendingJob())
+            std::this_thread::yield();
+    }
+};
+
+bool JobSystem::runPendingJob()
+{
+    WorkQueue* queue = ownQueue();
+    if (!queue)
+        return false;
+
+    Job job;
+    if (popOwn(*queue, job) || steal(t_queueIndex, job))
+    {
+        execute(job);
+        return true;
+    }
+    return false;
+};
+
+bool JobSystem::popOwn(WorkQueue& queue, Job& job)
+{
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.back == queue.front)
+        return false;
+    queue.back--;
+    job = queue.jobs[queue.back % WorkQueue::CAPACITY];
+    m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+};
+
+bool JobSystem::steal(size_t thiefIndex, Job& job)
+{
+    // start at the neighbour instead of always at queue 0, so the thieves spread out
+    size_t queueCount = m_queues.size();
+    for (size_t offset = 1; offset < queueCount + 1; offset++)
+    {
+        WorkQueue& victim = *m_queues[(thiefIndex + offset) % queueCount];
+        std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || victim.back == victim.front)
+            continue;
+        job = victim.jobs[victim.front % WorkQueue::CAPACITY];
+        victim.front++;
+        m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+};
+
+void JobSystem::execute(Job& job)
+{
+    job.invoke(job);
+    if (job.counter)
+        job.counter->remaining.fetch_sub(1, std::memory_order_release);
+};
+
+void JobSystem::workerLoop(size_t index)
+{
+    t_queueIndex = index;
+    while (true)
+    {
+        if (runPendingJob())
+            continue;
+
+        // nothing to steal right now, a short spin catches the next batch of a parallelFor
+        // without paying for a sleep/wake up, after that the worker really goes to sleep
+        bool found = false;
+        for (int spin = 0; spin < 64 && !found; spin++)
+        {
+            std::this_thread::yield();
+            found = m_queuedJobs.load(std::memory_order_acquire) > 0;
+        }
+        if (found)
+            continue;
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wakeUp.wait(lock, [this]() { return !m_running || m_queuedJobs.load(std::memory_order_acquire) > 0; });
+        if (!m_running)
+            return;
+    }
+};
@@ -0,0 +1,614 @@
+#include "UtilClasses/LogBackend.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "Defaults/config.h"
+#include "UtilClasses/LogFormat.h"
+
+static const char* levelNames[] = { "[TRACE]", "[DEBUG]", "[INFO]", "[SUCCES]", "[WARNING]", "[ERROR]" };
+
+// the only way flushFromSignal writes anything
+static void writeFromSignal(int descriptor, const char* data, size_t size)
+{
+#if defined(_WIN32)
+	_write(descriptor, data, (unsigned int)size);
+#else
+	while (size > 0)
+	{
+		ssize_t written = write(descriptor, data, size);
+		if (written <= 0)
+			return;
+		data += written;
+		size -= (size_t)written;
+	}
+#endif
+};
+
+static int descriptorOf(FILE* file)
+{
+	if (!file)
+		return -1;
+#if defined(_WIN32)
+	return _fileno(file);
+#else
+	return fileno(file);
+#endif
+};
+
+// ------------------------------------------------------------------------------------------------
+// LogRingBuffer
+// ------------------------------------------------------------------------------------------------
+
+static uint32_t alignRecord(size_t size)
+{
+	return (uint32_t)((size + 7) & ~(size_t)7);
+};
+
+LogRingBuffer::LogRingBuffer(size_t capacity)
+{
+	// the capacity has to be a power of two so a position maps to an offset with a mask
+	m_capacity = 64;
+	while (m_capacity < capacity)
+	{
+		m_capacity <<= 1;
+	}
+	// uint64_t storage guarantees the 8 byte alignment every header needs
+	m_storage.resize(m_capacity / sizeof(uint64_t));
+	m_buffer = reinterpret_cast<char*>(m_storage.data());
+};
+
+LogRecordHeader* LogRingBuffer::reserve(uint32_t size)
+{
+	uint64_t head = m_head.load(std::memory_order_relaxed);
+	uint64_t tail = m_tail.load(std::memory_order_acquire);
+	uint64_t offset = head & (m_capacity - 1);
+	uint64_t contiguous = m_capacity - offset;
+	// a record never wraps around, if it doesn't fit at the end we skip to the start of the ring
+	uint64_t needed = size <= contiguous ? size : contiguous + size;
+	if (m_capacity - (head - tail) < needed)
+	{
+		return nullptr;
+	}
+
+	if (size > contiguous)
+	{
+		LogRecordHeader* padding = reinterpret_cast<LogRecordHeader*>(m_buffer + offset);
+		padding->size = (uint32_t)contiguous;
+		padding->kind = LogRecordKind::Padding;
+		head += contiguous;
+		m_head.store(head, std::memory_order_release);
+		offset = 0;
+	}
+
+	LogRecordHeader* record = reinterpret_cast<LogRecordHeader*>(m_buffer + offset);
+	record->size = size;
+	return record;
+};
+
+void LogRingBuffer::commit(LogRecordHeader* record)
+{
+	// the release store makes the whole record visible to the consumer at once
+	m_head.store(m_head.load(std::memory_order_relaxed) + record->size, std::memory_order_release);
+};
+
+const LogRecordHeader* LogRingBuffer::recordAt(uint64_t position) const
+{
+	return reinterpret_cast<const LogRecordHeader*>(m_buffer + (position & (m_capacity - 1)));
+};
+
+// ------------------------------------------------------------------------------------------------
+// sinks
+// ------------------------------------------------------------------------------------------------
+
+ConsoleSink::ConsoleSink(bool colors)
+	: m_colors(colors), m_descriptor(descriptorOf(stdout))
+{
+};
+
+void ConsoleSink::write(const LogRecordHeader& record, const std::string& line)
+{
+	bool colored = m_colors && record.colorLength > 0;
+	if (colored)
+	{
+		std::fwrite(record.color, 1, record.colorLength, stdout);
+	}
+	std::fwrite(line.data(), 1, line.size(), stdout);
+	if (colored)
+	{
+		std::fputs(RESET_COLOR, stdout);
+	}
+	std::fputc('\n', stdout);
+};
+
+void ConsoleSink::flush()
+{
+	// one flush per batch instead of one std::endl per line
+	std::fflush(stdout);
+};
+
+RotatingFileSink::RotatingFileSink(std::string path, size_t maxBytes, int maxFiles)
+	: m_path(std::move(path)), m_maxBytes(maxBytes), m_maxFiles(std::max(maxFiles, 1))
+{
+	m_file = std::fopen(m_path.c_str(), "ab");
+	if (m_file)
+	{
+		std::fseek(m_file, 0, SEEK_END);
+		long size = std::ftell(m_file);
+		m_currentBytes = size > 0 ? (size_t)size : 0;
+	}
+	updateDescriptor();
+};
+
+void RotatingFileSink::updateDescriptor()
+{
+	m_descriptor.store(descriptorOf(m_file), std::memory_order_release);
+};
+
+RotatingFileSink::~RotatingFileSink()
+{
+	if (m_file)
+	{
+		std::fclose(m_file);
+	}
+};
+
+void RotatingFileSink::rotate()
+{
+	m_descriptor.store(-1, std::memory_order_release);
+	std::fclose(m_file);
+	// <path>.N-1 -> <path>.N , ... , <path> -> <path>.1 (the oldest file falls off)
+	std::remove((m_path + "." + std::to_string(m_maxFiles)).c_str());
+	for (int i = m_maxFiles - 1; i >= 1; i--)
+	{
+		std::rename((m_path + "." + std::to_string(i)).c_str(), (m_path + "." + std::to_string(i + 1)).c_str());
+	}
+	std::rename(m_path.c_str(), (m_path + ".1").c_str());
+	m_file = std::fopen(m_path.c_str(), "wb");
+	m_currentBytes = 0;
+	updateDescriptor();
+};
+
+void RotatingFileSink::write(const LogRecordHeader&, const std::string& line)
+{
+	if (!m_file)
+		return;
+	if (m_currentBytes + line.size() + 1 > m_maxBytes && m_currentBytes > 0)
+	{
+		rotate();
+		if (!m_file)
+			return;
+	}
+	std::fwrite(line.data(), 1, line.size(), m_file);
+	std::fputc('\n', m_file);
+	m_currentBytes += line.size() + 1;
+};
+
+void RotatingFileSink::flush()
+{
+	if (m_file)
+	{
+		std::fflush(m_file);
+	}
+};
+
+// ------------------------------------------------------------------------------------------------
+// LogBackend
+// ------------------------------------------------------------------------------------------------
+
+namespace {
+	// the ring of the current thread (a plain pointer so it's still usable during thread exit)
+	thread_local LogRingBuffer* t_ring = nullptr;
+	// set once the thread's ring was handed back to the backend
+	thread_local bool t_exiting = false;
+
+	// hands the ring back to the backend when the thread exits
+	struct ThreadRingOwner {
+		LogRingBuffer* ring = nullptr;
+		~ThreadRingOwner()
+		{
+			if (ring)
+			{
+				ring->m_producerAlive.store(false, std::memory_order_release);
+			}
+			t_ring = nullptr;
+			t_exiting = true;
+		};
+	};
+	thread_local ThreadRingOwner t_ringOwner;
+
+	// threads that log after their ring was released share this ring (and its lock)
+	std::mutex g_lateMutex;
+	LogRingBuffer* g_lateRing = nullptr;
+
+	// what flushFromSignal looks at, a crash handler must not construct the backend
+	std::atomic<LogBackend*> g_backend{ nullptr };
+}
+
+LogBackend& LogBackend::instance()
+{
+	// leaked on purpose, see the header
+	static LogBackend* backend = new LogBackend();
+	return *backend;
+};
+
+int64_t LogBackend::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+};
+
+LogBackend::LogBackend()
+{
+	int64_t wallTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	m_clockOffset = wallTime - now();
+	m_sinks.push_back(std::make_unique<ConsoleSink>(true));
+	g_lateRing = new LogRingBuffer(RING_CAPACITY);
+	start();
+	g_backend.store(this, std::memory_order_release);
+};
+
+void LogBackend::start()
+{
+	m_running.store(true);
+	m_thread = std::thread(&LogBackend::run, this);
+
+	std::atexit([]() { LogBackend::instance().shutdown(); });
+	// the crash handlers are the FlightRecorder's, they call flushFromSignal before dumping
+};
+
+void LogBackend::run()
+{
+	while (m_running.load(std::memory_order_acquire))
+	{
+		size_t written;
+		{
+			std::lock_guard<std::mutex> lock(m_drainMutex);
+			written = drain();
+		}
+		if (written == 0)
+		{
+			// producers never wait on us, so a short sleep is all the synchronisation we need
+			std::unique_lock<std::mutex> lock(m_wakeMutex);
+			m_wake.wait_for(lock, std::chrono::milliseconds(5));
+		}
+	}
+};
+
+LogRingBuffer* LogBackend::threadRing()
+{
+	if (t_ring)
+		return t_ring;
+	if (t_exiting)
+		return nullptr;
+
+	auto ring = std::make_unique<LogRingBuffer>(RING_CAPACITY);
+	t_ring = ring.get();
+	t_ringOwner.ring = t_ring;
+	std::lock_guard<std::mutex> lock(m_ringsMutex);
+	m_rings.push_back(std::move(ring));
+	return t_ring;
+};
+
+LogRecordHeader* LogBackend::reserve(uint32_t payloadSize)
+{
+	LogRingBuffer* ring = threadRing();
+	bool late = ring == nullptr;
+	if (late)
+	{
+		g_lateMutex.lock();
+		ring = g_lateRing;
+	}
+
+	// a single record may use at most half of a ring, longer messages are cut off
+	const uint32_t maxPayload = (uint32_t)(RING_CAPACITY / 2 - sizeof(LogRecordHeader));
+	payloadSize = std::min(payloadSize, maxPayload);
+	uint32_t size = alignRecord(sizeof(LogRecordHeader) + payloadSize);
+
+	LogRecordHeader* record = ring->reserve(size);
+	while (!record)
+	{
+		if (!late && m_policy.load(std::memory_order_relaxed) == LogOverflowPolicy::Drop)
+		{
+			m_dropped.fetch_add(1, std::memory_order_relaxed);
+			return nullptr;
+		}
+		if (m_running.load(std::memory_order_acquire) && !late)
+		{
+			m_wake.notify_one();
+			std::this_thread::yield();
+		}
+		else
+		{
+			flush();
+		}
+		record = ring->reserve(size);
+	}
+
+	record->kind = LogRecordKind::Message;
+	record->payloadSize = payloadSize;
+	record->colorLength = 0;
+	record->sequence = m_sequence.fetch_add(1, std::memory_order_relaxed);
+	return record;
+};
+
+void LogBackend::commit(LogRecordHeader* record)
+{
+	LogRingBuffer* ring = t_ring;
+	if (!ring)
+	{
+		g_lateRing->commit(record);
+		g_lateMutex.unlock();
+		flush();
+		return;
+	}
+
+	ring->commit(record);
+	if (!m_running.load(std::memory_order_acquire))
+	{
+		// nobody is left to write it for us (after shutdown)
+		flush();
+	}
+	else if (record->level == LogLevel::Error)
+	{
+		// errors are worth a wake-up, everything else waits for the next poll
+		m_wake.notify_one();
+	}
+};
+
+std::string LogBackend::format(const LogRecordHeader& record)
+{
+	if (record.kind == LogRecordKind::Raw)
+	{
+		return std::string(record.payload(), record.payloadSize);
+	}
+
+	std::string message;
+	const char* file = record.file;
+	uint32_t line = record.line;
+	if (record.kind == LogRecordKind::Format)
+	{
+		message = formatLogArguments(record.site->format, record.payload(), record.payloadSize);
+		file = record.site->file;
+		line = record.site->line;
+	}
+	else
+	{
+		message.assign(record.payload(), record.payloadSize);
+	}
+
+	// the time stamp is only turned into text here, on the logging thread
+	std::time_t seconds = (std::time_t)((record.timestamp + m_clockOffset) / 1000000000LL);
+	std::tm local{};
+#ifdef _WIN32
+	localtime_s(&local, &seconds);
+#else
+	localtime_r(&seconds, &local);
+#endif
+	char time[32];
+	std::strftime(time, sizeof(time), "%Y-%m-%d %H:%M:%S", &local);
+
+	std::string text;
+	text.reserve(64 + message.size());
+	text += levelNames[(int)record.level];
+	text += "[";
+	text += time;
+	text += "] ";
+	text += file ? file : "?";
+	text += ":";
+	text += std::to_string(line);
+	text += " ";
+	text += message;
+	return text;
+};
+
+size_t LogBackend::drain()
+{
+	std::vector<PendingRecord>& pending = m_pending;
+	std::vector<ConsumedRing>& consumed = m_consumed;
+	pending.clear();
+	consumed.clear();
+
+	{
+		std::lock_guard<std::mutex> lock(m_ringsMutex);
+		consumed.reserve(m_rings.size() + 1);
+		for (auto& ring : m_rings)
+		{
+			consumed.push_back({ ring.get(), 0 });
+		}
+	}
+	consumed.push_back({ g_lateRing, 0 });
+
+	for (ConsumedRing& entry : consumed)
+	{
+		uint64_t position = entry.ring->readPosition();
+		entry.end = entry.ring->writePosition();
+		while (position < entry.end)
+		{
+			const LogRecordHeader* record = entry.ring->recordAt(position);
+			if (record->kind != LogRecordKind::Padding)
+			{
+				pending.push_back({ record->sequence, record });
+			}
+			position += record->size;
+		}
+	}
+
+	// every thread wrote in order, but we want the order of the whole program
+	std::sort(pending.begin(), pending.end(), [](const PendingRecord& a, const PendingRecord& b) {
+		return a.sequence < b.sequence;
+	});
+
+	for (const PendingRecord& entry : pending)
+	{
+		std::string line = format(*entry.record);
+		for (auto& sink : m_sinks)
+		{
+			sink->write(*entry.record, line);
+		}
+	}
+
+	for (ConsumedRing& entry : consumed)
+	{
+		entry.ring->release(entry.end);
+	}
+
+	uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+	if (dropped != m_reportedDropped)
+	{
+		LogRecordHeader notice{};
+		notice.kind = LogRecordKind::Raw;
+		notice.level = LogLevel::Warning;
+		std::string line = "[WARNING] LOGGER: dropped " + std::to_string(dropped - m_reportedDropped) + " messages (ring buffers were full)";
+		for (auto& sink : m_sinks)
+		{
+			sink->write(notice, line);
+		}
+		m_reportedDropped = dropped;
+	}
+
+	if (!pending.empty())
+	{
+		for (auto& sink : m_sinks)
+		{
+			sink->flush();
+		}
+	}
+
+	// rings of threads that exited can go once they're empty
+	{
+		std::lock_guard<std::mutex> lock(m_ringsMutex);
+		m_rings.erase(std::remove_if(m_rings.begin(), m_rings.end(), [](const std::unique_ptr<LogRingBuffer>& ring) {
+			return !ring->m_producerAlive.load(std::memory_order_acquire) && ring->readPosition() == ring->writePosition();
+		}), m_rings.end());
+	}
+
+	return pending.size();
+};
+
+void LogBackend::flush()
+{
+	std::lock_guard<std::mutex> lock(m_drainMutex);
+	while (drain() > 0) {}
+	for (auto& sink : m_sinks)
+	{
+		sink->flush();
+	}
+};
+
+void LogBackend::shutdown()
+{
+	if (m_running.exchange(false))
+	{
+		m_wake.notify_one();
+		if (m_thread.joinable())
+		{
+			m_thread.join();
+		}
+	}
+	flush();
+};
+
+void LogBackend::flushFromSignal()
+{
+	LogBackend* backend = g_backend.load(std::memory_order_acquire);
+	if (!backend)
+		return;
+
+	// the crashed thread may hold the drain lock or be inside the allocator, so nothing here takes a lock,
+	// allocates or goes through stdio: the records still in the rings are merged by their sequence, formatted
+	// into m_signalLine one at a time (without the wall time, localtime isn't safe here) and written with write(2)
+	// the rings aren't released, a drain that was running when we crashed may have written some of them already
+	struct Cursor {
+		const LogRingBuffer* ring;
+		uint64_t position;
+		uint64_t end;
+	};
+	Cursor cursors[MAX_SIGNAL_RINGS + 1];
+	size_t ringCount = 0;
+	for (const auto& ring : backend->m_rings)
+	{
+		if (ringCount == MAX_SIGNAL_RINGS)
+			break;
+		cursors[ringCount++] = { ring.get(), ring->readPosition(), ring->writePosition() };
+	}
+	if (g_lateRing)
+		cursors[ringCount++] = { g_lateRing, g_lateRing->readPosition(), g_lateRing->writePosition() };
+
+	while (true)
+	{
+		// the oldest record over all rings
+		Cursor* next = nullptr;
+		for (size_t i = 0; i < ringCount; i++)
+		{
+			Cursor& cursor = cursors[i];
+			while (cursor.position < cursor.end && cursor.ring->recordAt(cursor.position)->kind == LogRecordKind::Padding)
+				cursor.position += cursor.ring->recordAt(cursor.position)->size;
+			if (cursor.position < cursor.end && (!next || cursor.ring->recordAt(cursor.position)->sequence < next->ring->recordAt(next->position)->sequence))
+				next = &cursor;
+		}
+		if (!next)
+			break;
+		const LogRecordHeader& record = *next->ring->recordAt(next->position);
+		next->position += record.size;
+
+		// the line minus its newline
+		const size_t capacity = SIGNAL_LINE_SIZE - 1;
+		size_t size = 0;
+		auto append = [backend, &size, capacity](const char* text, size_t length) {
+			for (size_t i = 0; i < length && size < capacity; i++)
+				backend->m_signalLine[size++] = text[i];
+		};
+		if (record.kind != LogRecordKind::Raw)
+		{
+			const char* level = levelNames[(int)record.level];
+			append(level, std::strlen(level));
+			append("[crash] ", 8);
+			const char* file = record.kind == LogRecordKind::Format ? record.site->file : record.file;
+			uint32_t line = record.kind == LogRecordKind::Format ? record.site->line : record.line;
+			if (file)
+				append(file, std::strlen(file));
+			char digits[12];
+			size_t count = 0;
+			do
+			{
+				digits[sizeof(digits) - 1 - count++] = (char)('0' + line % 10);
+				line /= 10;
+			} while (line > 0);
+			append(":", 1);
+			append(digits + sizeof(digits) - count, count);
+			append(" ", 1);
+		}
+		if (record.kind == LogRecordKind::Format)
+			size += formatLogArguments(backend->m_signalLine + size, capacity - size, record.site->format, record.payload(), record.payloadSize);
+		else
+			append(record.payload(), record.payloadSize);
+		backend->m_signalLine[size++] = '\n';
+
+		for (const auto& sink : backend->m_sinks)
+		{
+			int descriptor = sink->descriptor();
+			if (descriptor >= 0)
+				writeFromSignal(descriptor, backend->m_signalLine, size);
+		}
+	}
+};
+
+void LogBackend::addSink(std::unique_ptr<LogSink> sink)
+{
+	std::lock_guard<std::mutex> lock(m_drainMutex);
+	m_sinks.push_back(std::move(sink));
+};
+
+void LogBackend::setOverflowPolicy(LogOverflowPolicy policy)
+{
+	m_policy.store(policy);
+};
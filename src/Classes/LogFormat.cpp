@@ -0,0 +1,226 @@
+#include "UtilClasses/LogFormat.h"
+
+#include <cstddef>
+#include <cstdio>
+
+namespace {
+
+// the text the logging thread builds, numbers go through snprintf
+struct StringOutput {
+	std::string& text;
+
+	void append(const char* data, size_t size) { text.append(data, size); };
+	void append(char c) { text += c; };
+	void number(int64_t value) { char buffer[32]; std::snprintf(buffer, sizeof(buffer), "%lld", (long long)value); text += buffer; };
+	void number(uint64_t value) { char buffer[32]; std::snprintf(buffer, sizeof(buffer), "%llu", (unsigned long long)value); text += buffer; };
+	void real(double value) { char buffer[32]; std::snprintf(buffer, sizeof(buffer), "%g", value); text += buffer; };
+	void hex(uint64_t value) { char buffer[32]; std::snprintf(buffer, sizeof(buffer), "0x%llx", (unsigned long long)value); text += buffer; };
+};
+
+// a fixed buffer that a signal handler can fill, anything beyond its capacity is dropped
+struct FixedOutput {
+	char* out;
+	size_t capacity;
+	size_t size = 0;
+
+	void append(const char* data, size_t count) { for (size_t i = 0; i < count; i++) append(data[i]); };
+	void append(char c) { if (size < capacity) out[size++] = c; };
+	void number(uint64_t value)
+	{
+		char digits[20];
+		int count = 0;
+		do
+		{
+			digits[count++] = (char)('0' + value % 10);
+			value /= 10;
+		} while (value > 0);
+		while (count > 0)
+			append(digits[--count]);
+	};
+	void number(int64_t value)
+	{
+		if (value < 0)
+		{
+			append('-');
+			number((uint64_t)0 - (uint64_t)value);
+		}
+		else
+			number((uint64_t)value);
+	};
+	// three decimals, good enough for a crash report
+	void real(double value)
+	{
+		if (value != value)
+		{
+			append("nan", 3);
+			return;
+		}
+		if (value < 0.0)
+		{
+			append('-');
+			value = -value;
+		}
+		if (value >= 1e18)
+		{
+			append("inf", 3);
+			return;
+		}
+		uint64_t whole = (uint64_t)value;
+		uint64_t thousandths = (uint64_t)((value - (double)whole) * 1000.0 + 0.5);
+		if (thousandths == 1000)
+		{
+			whole++;
+			thousandths = 0;
+		}
+		number(whole);
+		append('.');
+		append((char)('0' + thousandths / 100));
+		append((char)('0' + thousandths / 10 % 10));
+		append((char)('0' + thousandths % 10));
+	};
+	void hex(uint64_t value)
+	{
+		append("0x", 2);
+		char digits[16];
+		int count = 0;
+		do
+		{
+			digits[count++] = "0123456789abcdef"[value & 0xF];
+			value >>= 4;
+		} while (value > 0);
+		while (count > 0)
+			append(digits[--count]);
+	};
+};
+
+// appends the next argument to "text", returns false once the arguments are used up
+// (or cut off, the flight recorder keeps only the start of a record)
+template<typename Output>
+bool appendArgument(Output& text, const char*& cursor, const char* end)
+{
+	if (cursor >= end)
+		return false;
+
+	LogArgType type = (LogArgType)*cursor++;
+	switch (type)
+	{
+	case LogArgType::Bool:
+		if (cursor >= end)
+			return false;
+		*cursor++ ? text.append("true", 4) : text.append("false", 5);
+		return true;
+	case LogArgType::Char:
+		if (cursor >= end)
+			return false;
+		text.append(*cursor++);
+		return true;
+	case LogArgType::String:
+	{
+		uint32_t length;
+		if (end - cursor < (std::ptrdiff_t)sizeof(length))
+		{
+			cursor = end;
+			return false;
+		}
+		std::memcpy(&length, cursor, sizeof(length));
+		cursor += sizeof(length);
+		// a cut off string shows what is left of it
+		if (end - cursor < (std::ptrdiff_t)length)
+			length = (uint32_t)(end - cursor);
+		text.append(cursor, length);
+		cursor += length;
+		return true;
+	}
+	default:
+		break;
+	}
+
+	// every other type is 8 bytes
+	uint64_t bits;
+	if (end - cursor < (std::ptrdiff_t)sizeof(bits))
+	{
+		cursor = end;
+		return false;
+	}
+	std::memcpy(&bits, cursor, sizeof(bits));
+	cursor += sizeof(bits);
+	switch (type)
+	{
+	case LogArgType::Int64:
+	{
+		int64_t value;
+		std::memcpy(&value, &bits, sizeof(value));
+		text.number(value);
+		break;
+	}
+	case LogArgType::UInt64:
+		text.number(bits);
+		break;
+	case LogArgType::Double:
+	{
+		double value;
+		std::memcpy(&value, &bits, sizeof(value));
+		text.real(value);
+		break;
+	}
+	case LogArgType::Pointer:
+		text.hex(bits);
+		break;
+	default:
+		// unknown tag, the rest of the record can't be trusted
+		cursor = end;
+		return false;
+	}
+	return true;
+};
+
+template<typename Output>
+void formatInto(Output& text, const char* format, const char* arguments, uint32_t size)
+{
+	const char* cursor = arguments;
+	const char* end = arguments + size;
+
+	for (const char* c = format; *c; c++)
+	{
+		if (c[0] == '{' && c[1] == '{')
+		{
+			text.append('{');
+			c++;
+		}
+		else if (c[0] == '}' && c[1] == '}')
+		{
+			text.append('}');
+			c++;
+		}
+		else if (c[0] == '{' && c[1] == '}')
+		{
+			// a missing argument stays visible as "{}" instead of silently disappearing
+			if (!appendArgument(text, cursor, end))
+			{
+				text.append("{}", 2);
+			}
+			c++;
+		}
+		else
+		{
+			text.append(*c);
+		}
+	}
+};
+
+}
+
+std::string formatLogArguments(const char* format, const char* arguments, uint32_t size)
+{
+	std::string text;
+	StringOutput output{ text };
+	formatInto(output, format, arguments, size);
+	return text;
+};
+
+size_t formatLogArguments(char* out, size_t capacity, const char* format, const char* arguments, uint32_t size)
+{
+	FixedOutput output{ out, capacity };
+	formatInto(output, format, arguments, size);
+	return output.size;
+};
@@ -1,44 +1,83 @@
 #include "UtilClasses/Logger.h"
+#include "UtilClasses/FlightRecorder.h"
+
+#include <algorithm>
+#include <cstring>
 
 Logger::Logger() {};
 
 void Logger::info(LoggerMessage message, std::string color)
 {
-    debugMessage("[INFO]" + message.m_message, color);
+    debugMessage(LogLevel::Info, message, color);
 };
 
 void Logger::warning(LoggerMessage message, std::string color)
 {
-    debugMessage("[WARNING]" + message.m_message, color);
+    debugMessage(LogLevel::Warning, message, color);
 };
 
 void Logger::succes(LoggerMessage message, std::string color)
 {
-    debugMessage("[SUCCES]" + message.m_message, color);
+    debugMessage(LogLevel::Succes, message, color);
 };
 
 void Logger::error(LoggerMessage message, std::string color)
 {
-    debugMessage("[ERROR]" + message.m_message, color);
+    debugMessage(LogLevel::Error, message, color);
 };
 
-void Logger::debugMessage(std::string message, std::string color)
+void Logger::debugMessage(LogLevel level, const LoggerMessage& message, const std::string& color)
 {
+    if (!isEnabled(level))
+        return;
+
+    // the caller only copies the message into its own ring buffer,
+    // formatting and writing happens on the logging thread (see LogBackend)
+    LogRecordHeader* record = LogBackend::instance().reserve((uint32_t)message.m_message.size());
+    if (!record)
+        return;
+
+    record->level = level;
+    record->file = message.m_file;
+    record->line = (uint32_t)message.m_line;
+    record->timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(message.m_time.time_since_epoch()).count();
     if (m_colorsAvailable)
     {
-        print(color + message + RESET_COLOR);
-    }
-    else
-    {
-        print(message);
+        record->colorLength = (uint16_t)std::min(color.size(), sizeof(record->color));
+        std::memcpy(record->color, color.data(), record->colorLength);
     }
+    std::memcpy(record->payload(), message.m_message.data(), record->payloadSize);
+    LogBackend::instance().commit(record);
+    if (level >= LogLevel::Warning)
+        FlightRecorder::record(level == LogLevel::Error ? FlightEventType::ERROR_MESSAGE : FlightEventType::WARNING_MESSAGE, message.m_message);
 };
 
 void Logger::print(std::string message)
 {
-    std::cout << message << std::endl;
-};
+    LogRecordHeader* record = LogBackend::instance().reserve((uint32_t)message.size());
+    if (!record)
+        return;
 
+    record->kind = LogRecordKind::Raw;
+    record->level = LogLevel::Info;
+    record->file = nullptr;
+    record->line = 0;
+    record->timestamp = 0;
+    std::memcpy(record->payload(), message.data(), record->payloadSize);
+    LogBackend::instance().commit(record);
+};
 
+void Logger::flush()
+{
+    LogBackend::instance().flush();
+};
 
+void Logger::addFileSink(std::string path, size_t maxBytes, int maxFiles)
+{
+    LogBackend::instance().addSink(std::make_unique<RotatingFileSink>(path, maxBytes, maxFiles));
+};
 
+void Logger::setOverflowPolicy(LogOverflowPolicy policy)
+{
+    LogBackend::instance().setOverflowPolicy(policy);
+};
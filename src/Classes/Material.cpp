@@ -1,5 +1,11 @@
 #include "ResourceClasses/Material.h"
 
+ObjectPool& Material::getPool()
+{
+	static ObjectPool pool("Material");
+	return pool;
+};
+
 Material::Material(Shader* shader)
 {
 	m_shader = shader;
@@ -12,7 +18,7 @@ void Material::addTexture(const std::string& name, Texture2D* texture)
 
 void Material::setVec3(const std::string& name, const glm::vec3& value)
 {
-	int location = glGetUniformLocation(m_shader->ID, name.c_str());
+	int location = m_shader->getUniformLocation(StringID(name));
 	glUniform3f(location, value.x, value.y, value.z);
 };
 
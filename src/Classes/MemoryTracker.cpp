@@ -0,0 +1,315 @@
+#include "UtilClasses/MemoryTracker.h"
+#include "UtilClasses/Logger.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+static const size_t MEGABYTE = 1024 * 1024;
+
+MemoryTracker& MemoryTracker::getInstance()
+{
+    // never destroyed: the records belong to objects that may be static themselves (the ObjectPools,
+    // the FrameArena, the ResourceManager's pools) and those are destroyed in an order we don't control
+    static MemoryTracker* instance = new MemoryTracker();
+    return *instance;
+};
+
+const char* MemoryTracker::categoryName(MemoryCategory category)
+{
+    switch (category)
+    {
+    case MemoryCategory::MESHES: return "meshes";
+    case MemoryCategory::TEXTURES: return "textures";
+    case MemoryCategory::PROGRAMS: return "programs";
+    case MemoryCategory::OBJECT_POOLS: return "object-pools";
+    case MemoryCategory::FRAME_ARENA: return "frame-arena";
+    default: return "other";
+    }
+};
+
+bool MemoryTracker::isGpu(MemoryCategory category)
+{
+    return category == MemoryCategory::MESHES || category == MemoryCategory::TEXTURES || category == MemoryCategory::PROGRAMS;
+};
+
+MemoryHandle MemoryTracker::track(MemoryCategory category, std::string label, size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    MemoryRecord record;
+    record.category = category;
+    record.label = std::move(label);
+    record.bytes = bytes;
+    MemoryHandle handle = m_records.add(std::move(record));
+    m_recordCount[(size_t)category]++;
+    add(category, bytes);
+    return handle;
+};
+
+void MemoryTracker::resize(MemoryHandle handle, size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    MemoryRecord* record = m_records.get(handle);
+    if (!record || record->bytes == bytes)
+        return;
+    remove(record->category, record->bytes);
+    record->bytes = bytes;
+    add(record->category, bytes);
+};
+
+void MemoryTracker::rename(MemoryHandle handle, std::string label)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (MemoryRecord* record = m_records.get(handle))
+        record->label = std::move(label);
+};
+
+void MemoryTracker::untrack(MemoryHandle handle)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    MemoryRecord* record = m_records.get(handle);
+    if (!record)
+        return;
+    remove(record->category, record->bytes);
+    m_recordCount[(size_t)record->category]--;
+    m_records.remove(handle);
+};
+
+void MemoryTracker::add(MemoryCategory category, size_t bytes)
+{
+    size_t index = (size_t)category;
+    m_bytes[index] += bytes;
+    m_peakBytes[index] = std::max(m_peakBytes[index], m_bytes[index]);
+    checkBudgets(category);
+};
+
+void MemoryTracker::remove(MemoryCategory category, size_t bytes)
+{
+    size_t index = (size_t)category;
+    m_bytes[index] -= std::min(m_bytes[index], bytes);
+    checkBudgets(category);
+};
+
+void MemoryTracker::checkBudgets(MemoryCategory category)
+{
+    // a warning when a budget is crossed, not for every allocation while it stays crossed
+    size_t index = (size_t)category;
+    bool over = m_budgets[index] > 0 && m_bytes[index] > m_budgets[index];
+    if (over && !m_overBudget[index])
+        LOG_WARNING("MEMORY: {} use {} MB, over their budget of {} MB", categoryName(category), m_bytes[index] / (double)MEGABYTE, m_budgets[index] / (double)MEGABYTE);
+    m_overBudget[index] = over;
+
+    bool gpu = isGpu(category);
+    size_t total = 0;
+    for (size_t c = 0; c < (size_t)MemoryCategory::COUNT; c++)
+    {
+        if (isGpu((MemoryCategory)c) == gpu)
+            total += m_bytes[c];
+    }
+    size_t budget = gpu ? m_gpuBudget : m_cpuBudget;
+    bool& wasOver = gpu ? m_gpuOverBudget : m_cpuOverBudget;
+    over = budget > 0 && total > budget;
+    if (over && !wasOver)
+        LOG_WARNING("MEMORY: {} memory is {} MB, over its budget of {} MB", gpu ? "GPU" : "CPU", total / (double)MEGABYTE, budget / (double)MEGABYTE);
+    wasOver = over;
+};
+
+void MemoryTracker::setBudget(MemoryCategory category, size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_budgets[(size_t)category] = bytes;
+    checkBudgets(category);
+};
+
+void MemoryTracker::setGpuBudget(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_gpuBudget = bytes;
+    checkBudgets(MemoryCategory::MESHES);
+};
+
+void MemoryTracker::setCpuBudget(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cpuBudget = bytes;
+    checkBudgets(MemoryCategory::OTHER);
+};
+
+bool MemoryTracker::parseBudget(const std::string& budget)
+{
+    size_t split = budget.find(':');
+    if (split == std::string::npos)
+        return false;
+    std::string name = budget.substr(0, split);
+    size_t bytes = (size_t)(std::atof(budget.substr(split + 1).c_str()) * MEGABYTE);
+    if (name == "gpu")
+    {
+        setGpuBudget(bytes);
+        return true;
+    }
+    if (name == "cpu")
+    {
+        setCpuBudget(bytes);
+        return true;
+    }
+    for (size_t c = 0; c < (size_t)MemoryCategory::COUNT; c++)
+    {
+        if (name == categoryName((MemoryCategory)c))
+        {
+            setBudget((MemoryCategory)c, bytes);
+            return true;
+        }
+    }
+    return false;
+};
+
+MemoryCategoryStats MemoryTracker::getStats(MemoryCategory category)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t index = (size_t)category;
+    MemoryCategoryStats stats;
+    stats.name = categoryName(category);
+    stats.gpu = isGpu(category);
+    stats.bytes = m_bytes[index];
+    stats.peakBytes = m_peakBytes[index];
+    stats.records = m_recordCount[index];
+    stats.budgetBytes = m_budgets[index];
+    return stats;
+};
+
+size_t MemoryTracker::getGpuBytes()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t total = 0;
+    for (size_t c = 0; c < (size_t)MemoryCategory::COUNT; c++)
+    {
+        if (isGpu((MemoryCategory)c))
+            total += m_bytes[c];
+    }
+    return total;
+};
+
+size_t MemoryTracker::getCpuBytes()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t total = 0;
+    for (size_t c = 0; c < (size_t)MemoryCategory::COUNT; c++)
+    {
+        if (!isGpu((MemoryCategory)c))
+            total += m_bytes[c];
+    }
+    return total;
+};
+
+size_t MemoryTracker::getGpuBudget()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_gpuBudget;
+};
+
+size_t MemoryTracker::getCpuBudget()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_cpuBudget;
+};
+
+void MemoryTracker::forEachRecord(const std::function<void(const MemoryRecord&)>& function)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_records.forEach([&function](MemoryHandle, MemoryRecord& record) {
+        function(record);
+    });
+};
+
+// labels are our own names and file names, only quotes and backslashes need escaping
+static std::string escapeJson(const std::string& text)
+{
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+};
+
+std::string MemoryTracker::toJson(size_t recordsPerCategory)
+{
+    std::vector<MemoryRecord> records;
+    forEachRecord([&records](const MemoryRecord& record) {
+        records.push_back(record);
+    });
+    std::sort(records.begin(), records.end(), [](const MemoryRecord& a, const MemoryRecord& b) { return a.bytes > b.bytes; });
+
+    std::ostringstream json;
+    json << "{\n";
+    json << "  \"gpu_bytes\": " << getGpuBytes() << ",\n";
+    json << "  \"gpu_budget\": " << getGpuBudget() << ",\n";
+    json << "  \"cpu_bytes\": " << getCpuBytes() << ",\n";
+    json << "  \"cpu_budget\": " << getCpuBudget() << ",\n";
+    json << "  \"categories\": {\n";
+    for (size_t c = 0; c < (size_t)MemoryCategory::COUNT; c++)
+    {
+        MemoryCategoryStats stats = getStats((MemoryCategory)c);
+        json << "    \"" << stats.name << "\": {\n";
+        json << "      \"gpu\": " << (stats.gpu ? "true" : "false") << ",\n";
+        json << "      \"bytes\": " << stats.bytes << ",\n";
+        json << "      \"peak_bytes\": " << stats.peakBytes << ",\n";
+        json << "      \"budget\": " << stats.budgetBytes << ",\n";
+        json << "      \"count\": " << stats.records << ",\n";
+        json << "      \"largest\": [";
+        size_t listed = 0;
+        for (const MemoryRecord& record : records)
+        {
+            if (record.category != (MemoryCategory)c || listed == recordsPerCategory)
+                continue;
+            json << (listed > 0 ? ",\n" : "\n") << "        { \"label\": \"" << escapeJson(record.label) << "\", \"bytes\": " << record.bytes << " }";
+            listed++;
+        }
+        json << (listed > 0 ? "\n      ]\n" : "]\n");
+        json << "    }" << (c + 1 < (size_t)MemoryCategory::COUNT ? "," : "") << "\n";
+    }
+    json << "  }\n";
+    json << "}\n";
+    return json.str();
+};
+
+bool MemoryTracker::writeJson(const std::string& path)
+{
+    std::ofstream output(path, std::ios::out | std::ios::trunc);
+    if (!output.good())
+    {
+        LOG_ERROR("MEMORY: Could not write report to {}", path);
+        return false;
+    }
+    output << toJson();
+    LOG_SUCCES("MEMORY: Report written to {}", path);
+    return true;
+};
+
+void TrackedMemory::track(MemoryCategory category, std::string label, size_t bytes)
+{
+    MemoryTracker& tracker = MemoryTracker::getInstance();
+    if (m_handle.valid())
+        tracker.resize(m_handle, bytes);
+    else
+        m_handle = tracker.track(category, std::move(label), bytes);
+};
+
+void TrackedMemory::setLabel(std::string label)
+{
+    if (m_handle.valid())
+        MemoryTracker::getInstance().rename(m_handle, std::move(label));
+};
+
+void TrackedMemory::reset()
+{
+    if (!m_handle.valid())
+        return;
+    MemoryTracker::getInstance().untrack(m_handle);
+    m_handle = MemoryHandle();
+};
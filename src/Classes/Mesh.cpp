@@ -1,4 +1,15 @@
 #include "ResourceClasses/Mesh.h"
+#include "UtilClasses/RenderStats.h"
+#include "UtilClasses/RenderThread.h"
+
+#include <algorithm>
+#include <string>
+
+ObjectPool& Mesh::getPool()
+{
+	static ObjectPool pool("Mesh");
+	return pool;
+};
 
 Mesh::Mesh() {};
 
@@ -18,29 +29,27 @@ Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>&
 			m_isIndexed = false;
 			m_vertexCount = vertices.size();
 		}
-		setupMesh(vertices,indices);
+		computeBounds(vertices);
+		// the range comes from a shared arena (see GpuBufferArenas), only the copy needs the context
+		m_allocation.allocate((uint32_t)vertices.size(), (uint32_t)indices.size());
+		// with a render thread the data is copied over there, the vertices have to stay alive until then
+		RenderThread::getInstance().runSync([&]() {
+			setupMesh(vertices, indices);
+		});
+		RenderStats::recordUpload(vertices.size() * sizeof(Vertex) + indices.size() * sizeof(unsigned int));
 
 	}
 	catch (const std::exception& e)
 	{
-		Logger::error(
-			MESSAGE("MESH: Failed to read shader files")
-		);
+		LOG_ERROR("MESH: Failed to read shader files");
 	}
 };
 
-Mesh::~Mesh()
-{
-	freeResources();
-};
-
 void Mesh::freeResources()
 {
-	glDeleteVertexArrays(1, &m_VAO_ID);
-	glDeleteBuffers(1, &m_VBO_ID);
-	if (m_isIndexed) {
-		glDeleteBuffers(1, &m_EBO_ID);
-	}
+	// a frame that is still queued on the render thread (or still on the GPU) may draw these,
+	// the arena only reuses the range once those frames are done (the destructor does the same)
+	m_allocation.reset();
 }
 
 void Mesh::bind() const
@@ -48,7 +57,7 @@ void Mesh::bind() const
 	// once we specify what VAO we want to use to draw something then all the buffer pointers (that are pointing to VBO)
 	// are called and passed trough the shaders that we have actived for this specific frame
 	// remember that the transformation matrices are "uniform" variables defined inside the shader
-	glBindVertexArray(m_VAO_ID);
+	glBindVertexArray(getVertexArray());
 };
 
 void Mesh::unbind() const
@@ -58,33 +67,48 @@ void Mesh::unbind() const
 
 void Mesh::draw(bool drawTriangles) const
 {
-	bind();
+	const GpuMeshRange& range = m_allocation.range();
+	glBindVertexArray(range.vertexArray);
+	drawRange((unsigned int)getDrawCount(), m_isIndexed, range.firstIndex, (int)range.firstVertex, drawTriangles);
+	glBindVertexArray(0);
+	RenderStats::recordVertexArrayBind();
+	RenderStats::recordDraw(drawTriangles ? GL_TRIANGLES : GL_LINES, getDrawCount());
+};
 
-	if (m_isIndexed)
+void Mesh::drawRange(unsigned int count, bool indexed, unsigned int firstIndex, int baseVertex, bool drawTriangles)
+{
+	GLenum mode = drawTriangles ? GL_TRIANGLES : GL_LINES;
+	if (indexed)
 	{
-		if (drawTriangles) {
-			glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, 0);
-		}
-		else {
-			glDrawElements(GL_LINES, m_indexCount, GL_UNSIGNED_INT, 0);
-		}
+		// the indices are the mesh's own (0 based), the base vertex is added to every one of them
+		glDrawElementsBaseVertex(mode, count, GL_UNSIGNED_INT, (void*)((size_t)firstIndex * sizeof(unsigned int)), baseVertex);
 	}
 	else
 	{
-		if (drawTriangles) {
-			glDrawArrays(GL_TRIANGLES, 0, m_vertexCount);
-		}
-		else {
-			glDrawArrays(GL_LINES, 0, m_vertexCount);
-		}
+		glDrawArrays(mode, baseVertex, count);
 	}
-
-	unbind();
 };
 
 void Mesh::updateVertices(const std::vector<Vertex>& newVertices)
 {
+	computeBounds(newVertices);
+};
+
+void Mesh::computeBounds(const std::vector<Vertex>& vertices)
+{
+	if (vertices.empty())
+		return;
 
+	m_boundsMin = vertices[0].m_position;
+	m_boundsMax = vertices[0].m_position;
+	for (const Vertex& vertex : vertices)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			m_boundsMin[axis] = std::min(m_boundsMin[axis], vertex.m_position[axis]);
+			m_boundsMax[axis] = std::max(m_boundsMax[axis], vertex.m_position[axis]);
+		}
+	}
 };
 
 void Mesh::setupMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
@@ -94,67 +118,32 @@ void Mesh::setupMesh(const std::vector<Vertex>& vertices, const std::vector<unsi
 	// The advantage of using those buffer objects is that we can send large batches of data all at once to the graphics card, 
 	// and keep it there if there's enough memory left, without having to send data one vertex at a time.
 
-	// first we generate the buffers
-	glGenVertexArrays(1, &m_VAO_ID);
-	glGenBuffers(1, &m_VBO_ID);
-	if (m_isIndexed)
-	{
-		glGenBuffers(1, &m_EBO_ID);
-	}
-
-	// next we bind the newly created buffers
-	// bind the Vertex Array Object first
-	glBindVertexArray(m_VAO_ID);
-
-	// then we copy our data to the buffer
-	// The fourth parameter specifies how we want the graphics card to manage the given data. This can take 3 forms:
+	// the buffers themselves belong to an arena (GpuBufferArenas) that holds the vertices and indices of many meshes,
+	// the mesh only got a range of each, so instead of glBufferData (which would make a new buffer store)
+	// we copy our data into that range with glBufferSubData
+	// the arena made its buffers with GL_STATIC_DRAW, the fourth parameter of glBufferData can take 3 forms:
 	// 1) GL_STREAM_DRAW	: the data is set only once and used by the GPU at most a few times
 	// 2) GL_STATIC_DRAW	: the data is set only once and used many times
 	// 3) GL_DYNAMIC_DRAW	: the data is changed a lot and used many times
-	glBindBuffer(GL_ARRAY_BUFFER, m_VBO_ID);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
-
-	if (m_isIndexed)
-	{
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO_ID);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-	}
-
-	// we sent the input vertex data to the GPU 
-	// instructed the GPU how it should process the vertex data within a vertex and fragment shader however...
-	// OpenGL does not yet know how it should interpret the vertex data in memory  (floats , ints, doubles , 2 or 3 or 4 values)
-	// and how it should connect the vertex data to the vertex shader's attributes
-
-	// we can tell OpenGL how it should interpret the vertex data (per vertex attribute(positions , normals, etc...)) using
-	// this following line basically says :
+	const GpuMeshRange& range = m_allocation.range();
+	if (!range.vertexArray)
+		return;
+	GpuBufferArenas::upload(range, vertices.data(), m_isIndexed ? indices.data() : nullptr);
+
+	// OpenGL also has to know how it should interpret the vertex data in memory (floats , ints, doubles , 2 or 3 or 4 values)
+	// and how it should connect the vertex data to the vertex shader's attributes, the arena's VAO was told that once
+	// for all of its meshes (see GpuBufferArenas::createArena):
 	// at location "0" of the buffer (VBO)
 	// you'll find vertices with "3" "float" components
 	// which should "not" be normalized (not clamped/cliped between -1.0 and 1.0)(they already are)
 	// with a stride (byte offset) of "6" "of size" "float"
 	// this data starts at offset "0"
-
-	// Position attribute at location 0 has 3 floats 
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex,m_position));
-	glEnableVertexAttribArray(0);
-
-	// color attribute
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_normal));
-	glEnableVertexAttribArray(1);
+	// a mesh starts at its range's first vertex, which every draw passes as the "base vertex"
 
 	// VOB memory layout (all floats):
 	// | ----- Vertex 1 ----- | ----- Vertex 2 ----- | ----- Vertex 2 ----- | ----- etc... ----- |
 	//   X , Y , Z , R , G , B, X , Y , Z , R , G , B, X , Y , Z , R , G , B , etc...
 
-	// you don't have to specify the "layout" of you're data you can query for the attribute locations in the OpenGL code 
-	// however this way saves OpenGL and us as a programmer some work 
-
-	// binding to 0 resets it to NULL
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
-	// do NOT unbind the EBO while a VAO is active
-	// the EBO buffer object IS stored in the VAO
-	// glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
 	// what is a VAO ?
 	// what we did so far :
 	// --------------------
@@ -180,6 +169,7 @@ void Mesh::setupMesh(const std::vector<Vertex>& vertices, const std::vector<unsi
 
 	// VBO -> contains the raw data (can be reused for multiple processes e.g.: drawing 50 of the same trees or 10 of the same road blocks)
 	// VAO -> contains the configuration for how to use that data
+	// (an arena's VAO holds it for every mesh in its buffers, drawing many meshes binds it only once)
 };
 
 
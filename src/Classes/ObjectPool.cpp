@@ -0,0 +1,145 @@
+#include "UtilClasses/ObjectPool.h"
+
+#include <algorithm>
+#include <new>
+
+static constexpr size_t SLOT_ALIGNMENT = alignof(std::max_align_t);
+
+// FixedSizePool
+// ------------------------------------------------------------------------------------------------
+
+FixedSizePool::FixedSizePool(size_t slotSize, size_t slotsPerChunk)
+    : m_slotSize(std::max(slotSize, sizeof(FreeSlot))), m_slotsPerChunk(slotsPerChunk)
+{
+};
+
+FixedSizePool::~FixedSizePool()
+{
+    for (std::byte* chunk : m_chunks)
+        ::operator delete(chunk, std::align_val_t(SLOT_ALIGNMENT));
+};
+
+void FixedSizePool::addChunk()
+{
+    std::byte* chunk = static_cast<std::byte*>(::operator new(m_slotSize * m_slotsPerChunk, std::align_val_t(SLOT_ALIGNMENT)));
+    m_chunks.push_back(chunk);
+    // thread the new slots onto the free list, the first slot ends up on top
+    for (size_t i = m_slotsPerChunk; i-- > 0;)
+    {
+        FreeSlot* slot = reinterpret_cast<FreeSlot*>(chunk + i * m_slotSize);
+        slot->next = m_free;
+        m_free = slot;
+    }
+};
+
+void* FixedSizePool::allocate()
+{
+    if (!m_free)
+        addChunk();
+    FreeSlot* slot = m_free;
+    m_free = slot->next;
+    m_live++;
+    m_highWater = std::max(m_highWater, m_live);
+    return slot;
+};
+
+void FixedSizePool::deallocate(void* slot)
+{
+    FreeSlot* freed = static_cast<FreeSlot*>(slot);
+    freed->next = m_free;
+    m_free = freed;
+    m_live--;
+};
+
+// ObjectPool
+// ------------------------------------------------------------------------------------------------
+
+static std::mutex& registryMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+static std::vector<ObjectPool*>& registry()
+{
+    static std::vector<ObjectPool*> pools;
+    return pools;
+}
+
+ObjectPool::ObjectPool(std::string name)
+    : m_name(std::move(name))
+{
+    m_memory.track(MemoryCategory::OBJECT_POOLS, m_name, 0);
+    std::lock_guard<std::mutex> lock(registryMutex());
+    registry().push_back(this);
+};
+
+ObjectPool::~ObjectPool()
+{
+    std::lock_guard<std::mutex> lock(registryMutex());
+    auto& pools = registry();
+    pools.erase(std::remove(pools.begin(), pools.end(), this), pools.end());
+};
+
+FixedSizePool& ObjectPool::poolFor(size_t size)
+{
+    size_t slotSize = (size + SLOT_ALIGNMENT - 1) & ~(SLOT_ALIGNMENT - 1);
+    for (auto& entry : m_sizes)
+    {
+        if (entry.first == slotSize)
+            return *entry.second;
+    }
+    size_t slotsPerChunk = std::max<size_t>(CHUNK_BYTES / slotSize, 16);
+    m_sizes.emplace_back(slotSize, std::make_unique<FixedSizePool>(slotSize, slotsPerChunk));
+    return *m_sizes.back().second;
+};
+
+void* ObjectPool::allocate(size_t size)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    FixedSizePool& pool = poolFor(size);
+    size_t bytesBefore = pool.bytes();
+    void* object = pool.allocate();
+    if (pool.bytes() != bytesBefore)
+    {
+        // a new chunk
+        m_chunkBytes += pool.bytes() - bytesBefore;
+        m_memory.track(MemoryCategory::OBJECT_POOLS, m_name, m_chunkBytes);
+    }
+    m_allocations++;
+    m_live++;
+    m_highWater = std::max(m_highWater, m_live);
+    return object;
+};
+
+void ObjectPool::deallocate(void* object, size_t size)
+{
+    if (!object)
+        return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    poolFor(size).deallocate(object);
+    m_live--;
+};
+
+ObjectPoolStats ObjectPool::getStats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ObjectPoolStats stats;
+    stats.name = m_name;
+    stats.live = m_live;
+    stats.highWater = m_highWater;
+    stats.allocations = m_allocations;
+    for (auto& entry : m_sizes)
+    {
+        stats.capacity += entry.second->capacity();
+        stats.chunks += entry.second->chunks();
+    }
+    return stats;
+};
+
+void ObjectPool::forEachPool(const std::function<void(ObjectPool&)>& function)
+{
+    std::lock_guard<std::mutex> lock(registryMutex());
+    for (ObjectPool* pool : registry())
+        function(*pool);
+};
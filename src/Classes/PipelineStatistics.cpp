@@ -0,0 +1,120 @@
+#include "UtilClasses/PipelineStatistics.h"
+
+#include <cstring>
+
+#include "UtilClasses/Logger.h"
+
+// in the order of the fields of PipelineStatisticsCounts
+static const GLenum TARGETS[PipelineStatistics::COUNTERS] = {
+    GL_VERTICES_SUBMITTED,
+    GL_PRIMITIVES_SUBMITTED,
+    GL_VERTEX_SHADER_INVOCATIONS,
+    GL_FRAGMENT_SHADER_INVOCATIONS,
+    GL_CLIPPING_INPUT_PRIMITIVES,
+    GL_CLIPPING_OUTPUT_PRIMITIVES,
+};
+
+PipelineStatistics& PipelineStatistics::getInstance()
+{
+    static PipelineStatistics instance;
+    return instance;
+};
+
+void PipelineStatistics::init()
+{
+    // the extension uses the same enums as 4.6 (only with an _ARB at the end)
+    m_supported = GLAD_GL_VERSION_4_6;
+    if (!m_supported && GLAD_GL_VERSION_3_0)
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count && !m_supported; i++)
+        {
+            const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            m_supported = extension && std::strcmp(extension, "GL_ARB_pipeline_statistics_query") == 0;
+        }
+    }
+    if (m_supported)
+        LOG_INFO("PIPELINE: Pipeline statistics queries available");
+    else
+        LOG_INFO("PIPELINE: No pipeline statistics queries, only the CPU side render counters are shown");
+};
+
+void PipelineStatistics::frameBoundary()
+{
+    if (!m_supported)
+        return;
+
+    if (m_active)
+    {
+        for (size_t i = 0; i < COUNTERS; i++)
+            glEndQuery(TARGETS[i]);
+        m_frames[m_current].pending = true;
+        m_current = (m_current + 1) % FRAMES;
+        m_active = false;
+    }
+
+    // oldest first, m_current is the oldest frame once the ring went around
+    for (size_t age = 0; age < FRAMES; age++)
+    {
+        Frame& frame = m_frames[(m_current + age) % FRAMES];
+        if (!frame.pending)
+            continue;
+        // the queries of a frame finish together, the last one tells
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(frame.queries[COUNTERS - 1].get(), GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            break;
+
+        GLuint64 values[COUNTERS];
+        for (size_t i = 0; i < COUNTERS; i++)
+            glGetQueryObjectui64v(frame.queries[i].get(), GL_QUERY_RESULT, &values[i]);
+        frame.pending = false;
+
+        PipelineStatisticsCounts counts;
+        counts.available = true;
+        counts.verticesSubmitted = values[0];
+        counts.primitivesSubmitted = values[1];
+        counts.vertexShaderInvocations = values[2];
+        counts.fragmentShaderInvocations = values[3];
+        counts.clippingInputPrimitives = values[4];
+        counts.clippingOutputPrimitives = values[5];
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_latest = counts;
+    }
+
+    // the GPU is FRAMES behind, rather skip measuring a frame than wait for it
+    Frame& next = m_frames[m_current];
+    if (next.pending)
+        return;
+    for (size_t i = 0; i < COUNTERS; i++)
+    {
+        if (!next.queries[i])
+            next.queries[i] = GLQuery::create();
+        glBeginQuery(TARGETS[i], next.queries[i].get());
+    }
+    m_active = true;
+};
+
+PipelineStatisticsCounts PipelineStatistics::latest()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_latest;
+};
+
+void PipelineStatistics::shutdown()
+{
+    if (m_active)
+    {
+        for (size_t i = 0; i < COUNTERS; i++)
+            glEndQuery(TARGETS[i]);
+        m_active = false;
+    }
+    for (Frame& frame : m_frames)
+    {
+        for (GLQuery& query : frame.queries)
+            query.reset();
+        frame.pending = false;
+    }
+    m_supported = false;
+};
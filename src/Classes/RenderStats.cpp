@@ -0,0 +1,94 @@
+#include "UtilClasses/RenderStats.h"
+
+FrameRenderStats RenderStats::m_current;
+FrameRenderStats RenderStats::m_last;
+
+void RenderStats::beginFrame()
+{
+	m_last = m_current;
+	m_current = FrameRenderStats();
+	// the queries only get a new result every now and then, until then the last one stays
+	m_current.pipeline = m_last.pipeline;
+};
+
+void RenderStats::recordDraw(GLenum mode, uint64_t count, uint64_t instances)
+{
+	m_current.drawCalls++;
+	m_current.instances += instances;
+	m_current.vertices += count * instances;
+	// lines and points don't rasterize any triangles
+	if (mode == GL_TRIANGLES)
+	{
+		m_current.triangles += count / 3 * instances;
+	}
+};
+
+void RenderStats::recordTransformUpdate(uint64_t count, double milliseconds)
+{
+	m_current.transformsUpdated += count;
+	m_current.transformUpdateMs += milliseconds;
+};
+
+void RenderStats::recordAllocations(uint64_t count, uint64_t bytes)
+{
+	m_current.allocations = count;
+	m_current.allocatedBytes = bytes;
+};
+
+const FrameRenderStats& RenderStats::current()
+{
+	return m_current;
+};
+
+const FrameRenderStats& RenderStats::last()
+{
+	return m_last;
+};
+
+const char* RenderStats::counterName(RenderCounter counter)
+{
+	switch (counter)
+	{
+	case RenderCounter::DRAW_CALLS: return "draw_calls";
+	case RenderCounter::INSTANCES: return "instances";
+	case RenderCounter::TRIANGLES: return "triangles";
+	case RenderCounter::VERTICES: return "vertices";
+	case RenderCounter::PROGRAM_BINDS: return "program_binds";
+	case RenderCounter::VERTEX_ARRAY_BINDS: return "vertex_array_binds";
+	case RenderCounter::TEXTURE_BINDS: return "texture_binds";
+	case RenderCounter::UNIFORM_UPLOADS: return "uniform_uploads";
+	case RenderCounter::UPLOAD_BYTES: return "upload_bytes";
+	case RenderCounter::CULLED_OBJECTS: return "culled_objects";
+	case RenderCounter::VERTICES_SUBMITTED: return "gpu_vertices_submitted";
+	case RenderCounter::PRIMITIVES_SUBMITTED: return "gpu_primitives_submitted";
+	case RenderCounter::VERTEX_SHADER_INVOCATIONS: return "gpu_vertex_shader_invocations";
+	case RenderCounter::FRAGMENT_SHADER_INVOCATIONS: return "gpu_fragment_shader_invocations";
+	case RenderCounter::CLIPPING_INPUT_PRIMITIVES: return "gpu_clipping_input_primitives";
+	case RenderCounter::CLIPPING_OUTPUT_PRIMITIVES: return "gpu_clipping_output_primitives";
+	default: return "unknown";
+	}
+};
+
+uint64_t RenderStats::counterValue(const FrameRenderStats& stats, RenderCounter counter)
+{
+	switch (counter)
+	{
+	case RenderCounter::DRAW_CALLS: return stats.drawCalls;
+	case RenderCounter::INSTANCES: return stats.instances;
+	case RenderCounter::TRIANGLES: return stats.triangles;
+	case RenderCounter::VERTICES: return stats.vertices;
+	case RenderCounter::PROGRAM_BINDS: return stats.programBinds;
+	case RenderCounter::VERTEX_ARRAY_BINDS: return stats.vertexArrayBinds;
+	case RenderCounter::TEXTURE_BINDS: return stats.textureBinds;
+	case RenderCounter::UNIFORM_UPLOADS: return stats.uniformUploads;
+	case RenderCounter::UPLOAD_BYTES: return stats.uploadBytes;
+	case RenderCounter::CULLED_OBJECTS: return stats.culledObjects;
+	case RenderCounter::VERTICES_SUBMITTED: return stats.pipeline.verticesSubmitted;
+	case RenderCounter::PRIMITIVES_SUBMITTED: return stats.pipeline.primitivesSubmitted;
+	case RenderCounter::VERTEX_SHADER_INVOCATIONS: return stats.pipeline.vertexShaderInvocations;
+	case RenderCounter::FRAGMENT_SHADER_INVOCATIONS: return stats.pipeline.fragmentShaderInvocations;
+	case RenderCounter::CLIPPING_INPUT_PRIMITIVES: return stats.pipeline.clippingInputPrimitives;
+	case RenderCounter::CLIPPING_OUTPUT_PRIMITIVES: return stats.pipeline.clippingOutputPrimitives;
+	default: return 0;
+	}
+};
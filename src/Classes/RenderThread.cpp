@@ -0,0 +1,236 @@
+#include "UtilClasses/RenderThread.h"
+
+#include <chrono>
+#include <future>
+
+#include "imgui_impl_opengl3.h"
+
+#include "ResourceClasses/Mesh.h"
+#include "UtilClasses/Logger.h"
+#include "UtilClasses/AllocationTracker.h"
+
+static thread_local bool t_isRenderThread = false;
+
+SceneCommands& FrameCommands::addScene()
+{
+    if (sceneCount == scenes.size())
+        scenes.emplace_back();
+    SceneCommands& scene = scenes[sceneCount++];
+    scene.packets.clear();
+    return scene;
+};
+
+void FrameCommands::copyUI(const ImDrawData* drawData)
+{
+    if (!drawData || !drawData->Valid)
+        return;
+
+    // the copy shares nothing with ImGui's own lists (they are reset by the next ImGui::NewFrame)
+    ui = *drawData;
+    for (int i = 0; i < ui.CmdLists.Size; i++)
+    {
+        ui.CmdLists[i] = drawData->CmdLists[i]->CloneOutput();
+    }
+    hasUI = true;
+};
+
+void FrameCommands::clear()
+{
+    sceneCount = 0;
+    inputTime = -1.0;
+    if (hasUI)
+    {
+        for (int i = 0; i < ui.CmdLists.Size; i++)
+        {
+            IM_DELETE(ui.CmdLists[i]);
+        }
+        ui.CmdLists.clear();
+    }
+    hasUI = false;
+};
+
+RenderThread& RenderThread::getInstance()
+{
+    static RenderThread instance;
+    return instance;
+};
+
+RenderThread::~RenderThread()
+{
+    stop();
+};
+
+bool RenderThread::isRenderThread() const
+{
+    return t_isRenderThread;
+};
+
+void RenderThread::start(GLFWwindow* window)
+{
+    if (m_running)
+        return;
+
+    m_window = window;
+    m_stopping = false;
+    m_recording = 0;
+    // a context can only be current on one thread at a time
+    glfwMakeContextCurrent(nullptr);
+    m_running = true;
+    m_thread = std::thread(&RenderThread::loop, this);
+    LOG_INFO("RENDER THREAD: Owns the GL context now");
+};
+
+void RenderThread::stop()
+{
+    if (!m_running)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_commandQueued.notify_one();
+    m_thread.join();
+    m_running = false;
+
+    glfwMakeContextCurrent(m_window);
+    for (FrameCommands& frame : m_frames)
+    {
+        frame.clear();
+    }
+    LOG_INFO("RENDER THREAD: Stopped after {} frames", m_framesReplayed.load());
+};
+
+void RenderThread::loop()
+{
+    t_isRenderThread = true;
+    glfwMakeContextCurrent(m_window);
+
+    while (true)
+    {
+        std::function<void()> command;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_commandQueued.wait(lock, [this]() { return m_stopping || !m_commands.empty(); });
+            // stopping only once the queue is empty, a deleted mesh still frees its buffers
+            if (m_commands.empty())
+                break;
+            command = std::move(m_commands.front());
+            m_commands.pop_front();
+        }
+        command();
+    }
+
+    glfwMakeContextCurrent(nullptr);
+    t_isRenderThread = false;
+};
+
+void RenderThread::run(std::function<void()> command)
+{
+    if (!m_running || isRenderThread())
+    {
+        command();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_commands.push_back(std::move(command));
+    }
+    m_commandQueued.notify_one();
+};
+
+void RenderThread::runSync(std::function<void()> command)
+{
+    if (!m_running || isRenderThread())
+    {
+        command();
+        return;
+    }
+
+    std::promise<void> done;
+    std::future<void> finished = done.get_future();
+    run([&command, &done]() {
+        command();
+        done.set_value();
+    });
+    finished.wait();
+};
+
+FrameCommands& RenderThread::beginFrame()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_frameReplayed.wait(lock, [this]() { return !m_frameBusy[m_recording]; });
+    FrameCommands& frame = m_frames[m_recording];
+    frame.clear();
+    return frame;
+};
+
+void RenderThread::submitFrame()
+{
+    int index = m_recording;
+    m_recording = 1 - m_recording;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_frameBusy[index] = true;
+        m_commands.push_back([this, index]() {
+            replay(m_frames[index]);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_frameBusy[index] = false;
+            }
+            m_frameReplayed.notify_one();
+        });
+    }
+    m_commandQueued.notify_one();
+};
+
+void RenderThread::replay(FrameCommands& frame)
+{
+    PROFILE_ZONE("replay");
+    auto start = std::chrono::steady_clock::now();
+
+    glClearColor(frame.clearColor.x, frame.clearColor.y, frame.clearColor.z, frame.clearColor.w);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // the same state changes as Scene::drawMeshes, the packets are still grouped by material
+    for (size_t s = 0; s < frame.sceneCount; s++)
+    {
+        const SceneCommands& scene = frame.scenes[s];
+        Shader* currentShader = nullptr;
+        unsigned int currentVertexArray = 0;
+        for (const DrawPacket& packet : scene.packets)
+        {
+            if (packet.shader != currentShader)
+            {
+                currentShader = &packet.shader->Use();
+                currentShader->SetMatrix4("view"_sid, scene.view);
+                currentShader->SetMatrix4("projection"_sid, scene.projection);
+            }
+            currentShader->SetMatrix4("model"_sid, packet.model);
+            if (packet.vertexArray != currentVertexArray)
+            {
+                currentVertexArray = packet.vertexArray;
+                glBindVertexArray(currentVertexArray);
+            }
+            Mesh::drawRange(packet.count, packet.indexed, packet.firstIndex, packet.baseVertex, packet.drawTriangles);
+        }
+    }
+    glBindVertexArray(0);
+
+    // ImGui's GL backend creates its objects in NewFrame, so that half of StartFrame happens here
+    if (frame.hasUI)
+    {
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplOpenGL3_RenderDrawData(&frame.ui);
+    }
+
+    // without a GL context on the main thread the swap has to happen here as well
+    glfwSwapBuffers(m_window);
+    if (m_onSwap)
+        m_onSwap(frame.inputTime);
+
+    m_lastReplayMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    m_framesReplayed++;
+};
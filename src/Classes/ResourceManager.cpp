@@ -1,48 +1,99 @@
 #include "ResourceClasses/ResourceManager.h"
+#include "UtilClasses/RenderThread.h"
+#include "UtilClasses/TextureResidency.h"
+#include "UtilClasses/RenderStats.h"
+#include "UtilClasses/GLDebug.h"
+#include "UtilClasses/FlightRecorder.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
 // Instantiate static variables
-std::map<std::string, Texture2D>    ResourceManager::Textures;
-std::map<std::string, Shader>       ResourceManager::Shaders;
+HandlePool<Texture2D>                   ResourceManager::Textures;
+HandlePool<Shader>                      ResourceManager::Shaders;
+std::unordered_map<StringID, TextureHandle> ResourceManager::TextureIds;
+std::unordered_map<StringID, ShaderHandle>  ResourceManager::ShaderIds;
+std::map<std::string, TextureHandle>    ResourceManager::TextureNames;
+std::map<std::string, ShaderHandle>     ResourceManager::ShaderNames;
 
 void checkFileExists(std::string);
 
-Shader ResourceManager::LoadShader(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile, std::string name)
+ShaderHandle ResourceManager::LoadShader(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile, std::string name)
 {
-    Shaders[name] = loadShaderFromFile(vShaderFile, fShaderFile, gShaderFile);
-    return Shaders[name];
+    StringID id = StringID::intern(name);
+    ShaderHandle handle = FindShader(id);
+    // compiling needs the context, and a render thread may be drawing with this shader right now
+    // (replacing it over there means it's never half replaced while a frame uses it)
+    RenderThread::getInstance().runSync([&]() {
+        Shader shader = loadShaderFromFile(vShaderFile, fShaderFile, gShaderFile);
+        shader.m_memory.setLabel(name);
+        GLDebug::getInstance().label(GL_PROGRAM, shader.getID(), name);
+        if (Shader* existing = Shaders.get(handle))
+        {
+            // a reload, the old program is deleted once the frames that use it are done (see GLNamePool)
+            *existing = std::move(shader);
+        }
+        else
+        {
+            handle = Shaders.add(std::move(shader));
+        }
+    });
+    ShaderIds[id] = handle;
+    ShaderNames[name] = handle;
+    FlightRecorder::record(FlightEventType::RESOURCE_LOAD, name);
+    return handle;
 }
 
-Shader * ResourceManager::GetShader(std::string name)
+ShaderHandle ResourceManager::FindShader(StringID name)
 {
-    return &Shaders[name];
+    auto it = ShaderIds.find(name);
+    return it != ShaderIds.end() ? it->second : ShaderHandle();
 }
 
-Texture2D ResourceManager::LoadTexture(const char* file, bool alpha, std::string name)
+TextureHandle ResourceManager::LoadTexture(const char* file, bool alpha, std::string name)
 {
-    Textures[name] = loadTextureFromFile(file, alpha);
-    return Textures[name];
+    StringID id = StringID::intern(name);
+    TextureHandle handle = FindTexture(id);
+    bool streamed = false;
+    RenderThread::getInstance().runSync([&]() {
+        Texture2D texture = loadTextureFromFile(file, alpha);
+        texture.m_memory.setLabel(name);
+        GLDebug::getInstance().label(GL_TEXTURE, texture.getID(), name);
+        streamed = texture.Levels > 1;
+        if (Texture2D* existing = Textures.get(handle))
+        {
+            *existing = std::move(texture);
+        }
+        else
+        {
+            handle = Textures.add(std::move(texture));
+        }
+    });
+    TextureIds[id] = handle;
+    TextureNames[name] = handle;
+    FlightRecorder::record(FlightEventType::RESOURCE_LOAD, name);
+    // only the small levels were loaded, the rest is streamed in when something needs them
+    if (streamed)
+        TextureResidency::getInstance().add(handle, file, alpha);
+    return handle;
 }
 
-Texture2D * ResourceManager::GetTexture(std::string name)
+TextureHandle ResourceManager::FindTexture(StringID name)
 {
-    return &Textures[name];
+    auto it = TextureIds.find(name);
+    return it != TextureIds.end() ? it->second : TextureHandle();
 }
 
 void ResourceManager::Clear()
 {
-    // (properly) delete all shaders	
-    for (auto iter : Shaders)
-    {
-        glDeleteProgram(iter.second.ID);
-    }
-    // (properly) delete all textures
-    for (auto iter : Textures)
-    {
-        glDeleteTextures(1, &iter.second.ID);
-    }
+    // the shaders and textures own their GL objects, removing them hands those to the GLNamePool
+    // every handle is stale from here on
+    Shaders.clear();
+    Textures.clear();
+    ShaderIds.clear();
+    TextureIds.clear();
+    ShaderNames.clear();
+    TextureNames.clear();
 }
 
 Shader ResourceManager::loadShaderFromFile(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile)
@@ -110,16 +161,10 @@ Shader ResourceManager::loadShaderFromFile(const char* vShaderFile, const char*
     }
     catch (const std::exception e)
     {
-        std::string errorMsg(e.what());
-        Logger::error(
-            MESSAGE("SHADER: Failed to read shader files " + errorMsg)
-        );
+        LOG_ERROR("SHADER: Failed to read shader files {}", e.what());
     }
     catch (std::ifstream::failure& e) {
-        std::string errorMsg(e.what());
-        Logger::error(
-            MESSAGE("SHADER: Failed to open files")
-        );
+        LOG_ERROR("SHADER: Failed to open files {}", e.what());
     }
     return shader;
 }
@@ -133,11 +178,23 @@ Texture2D ResourceManager::loadTextureFromFile(const char* file, bool alpha)
         texture.Internal_Format = GL_RGBA;
         texture.Image_Format = GL_RGBA;
     }
-    // load image
+    // load image (with the channels the formats above expect, whatever the file has)
     int width, height, nrChannels;
-    unsigned char* data = stbi_load(file, &width, &height, &nrChannels, 0);
-    // now generate texture
-    texture.Generate(width, height, data);
+    int channels = alpha ? 4 : 3;
+    unsigned char* data = stbi_load(file, &width, &height, &nrChannels, channels);
+    if (!data)
+    {
+        LOG_ERROR("TEXTURE: Failed to load {}", file);
+        texture.Generate(0, 0, nullptr);
+        return texture;
+    }
+    // now generate texture, only with the levels up to TextureResidency::START_SIZE
+    // the more detailed ones are streamed in by the TextureResidency once an object gets close enough
+    texture.Filter_Min = GL_LINEAR_MIPMAP_LINEAR;
+    unsigned int levels = Texture2D::LevelCount(width, height);
+    MipLevels mips = TextureResidency::buildLevels(data, width, height, channels, TextureResidency::startLevel(width, height), levels);
+    texture.GenerateLevels(width, height, mips.firstLevel, mips.levels);
+    RenderStats::recordUpload(mips.bytes());
     // and finally free image data
     stbi_image_free(data);
     return texture;
@@ -148,12 +205,12 @@ std::vector<std::string> ResourceManager::showResources()
     
     std::vector<std::string> resourceNames;
     
-    resourceNames.reserve(Shaders.size() + Textures.size());
-    for (auto iter : Shaders)
+    resourceNames.reserve(ShaderNames.size() + TextureNames.size());
+    for (auto iter : ShaderNames)
     {
        resourceNames.push_back(iter.first.c_str());
     }
-    for (auto iter : Textures)
+    for (auto iter : TextureNames)
     {
         resourceNames.push_back(iter.first.c_str());
     }
@@ -169,8 +226,6 @@ void checkFileExists(std::string pathToFile)
     }
     else
     {
-        Logger::succes(
-            MESSAGE(std::string("file exists : ") + pathToFile)
-        );
+        LOG_SUCCES("file exists : {}", pathToFile);
     }
 };
@@ -1,4 +1,6 @@
 #include "Scene.h"
+#include "RenderStats.h"
+#include "TextureResidency.h"
 
 Scene::Scene() 
 {
@@ -11,12 +13,83 @@ Scene::Scene(Camera * newCamera)
     isActive = true;
 };
 
+Scene::~Scene()
+{
+    // the objects may outlive the scene, they shouldn't try to leave it later on
+    for (auto& gameObject : m_gameObjects)
+    {
+        gameObject.second->m_scene = nullptr;
+        gameObject.second->m_entity = Entity();
+    }
+};
+
 void Scene::addGameObject(std::string gObjName,GameObject * gObj)
 {
+    auto existing = m_gameObjects.find(gObjName);
+    if (existing != m_gameObjects.end() && existing->second != gObj)
+    {
+        removeGameObject(existing->second);
+    }
+    if (gObj->m_scene)
+    {
+        gObj->m_scene->removeGameObject(gObj);
+    }
+
     m_gameObjects[gObjName] = gObj;
-    Logger::succes(
-        MESSAGE("Added new GameObject to scene:" + gObjName)
+    gObj->m_scene = this;
+    gObj->m_entity = m_world.create(
+        NameComponent{ gObjName },
+        TransformComponent{ gObj->getTransformId() },
+        MeshRenderer{},
+        BoundsComponent{}
     );
+    updateRenderer(gObj->m_entity, gObj->getMesh(), gObj->getMaterial(), gObj->getDrawTriangles());
+    LOG_DEBUG("Added new GameObject to scene:{}", gObjName);
+};
+
+void Scene::removeGameObject(GameObject* gObj)
+{
+    if (gObj->m_scene != this)
+        return;
+
+    NameComponent* name = m_world.get<NameComponent>(gObj->m_entity);
+    if (name)
+    {
+        m_gameObjects.erase(name->value);
+    }
+    m_world.destroy(gObj->m_entity);
+    gObj->m_scene = nullptr;
+    gObj->m_entity = Entity();
+};
+
+void Scene::destroyGameObject(GameObject* gObj)
+{
+    if (!gObj)
+        return;
+    removeGameObject(gObj);
+    delete gObj;
+};
+
+void Scene::updateRenderer(Entity entity, Mesh* mesh, Material* material, bool drawTriangles)
+{
+    MeshRenderer* renderer = m_world.get<MeshRenderer>(entity);
+    if (!renderer)
+        return;
+
+    renderer->mesh = mesh;
+    renderer->material = material;
+    renderer->drawTriangles = drawTriangles;
+    if (material && !m_materialIndices.count(material))
+    {
+        m_materialIndices[material] = (uint32_t)m_materials.size();
+        m_materials.push_back(material);
+    }
+    if (mesh && !m_meshIndices.count(mesh))
+    {
+        m_meshIndices[mesh] = (uint32_t)m_meshIndices.size();
+    }
+    renderer->materialIndex = material ? m_materialIndices[material] : 0;
+    renderer->meshIndex = mesh ? m_meshIndices[mesh] : 0;
 };
 
 std::map<std::string, GameObject*> * Scene::getGameObjects()
@@ -36,11 +109,192 @@ Camera * Scene::getCamera()
 
 void Scene::renderScene()
 {
-    for (auto iter : m_gameObjects)
+    cull();
+    buildDrawList();
+    submit();
+};
+
+void Scene::cull(const TransformSnapshot* snapshot)
+{
+    // the camera input was already applied (Game::latchInput runs before "cull"), this is the frame's real frustum
+    Frustum frustum = Frustum::fromMatrix(m_camera->getProjection() * m_camera->getView());
+    if (snapshot)
+        cullBounds(*snapshot, frustum);
+    else
+        cullBounds(TransformStorage::getInstance(), frustum);
+};
+
+void Scene::buildDrawList(const TransformSnapshot* snapshot)
+{
+    JobSystem& jobs = JobSystem::getInstance();
+    m_drawLists.resize(jobs.threadCount());
+    for (DrawCommandList& drawList : m_drawLists)
+    {
+        drawList.clear();
+    }
+
+    // 1) record: every thread packs the visible objects of its chunks into its own list
+    if (snapshot)
+        recordDrawLists(*snapshot);
+    else
+        recordDrawLists(TransformStorage::getInstance());
+
+    // 2) sort every list on its own thread, 3) merge them into the order submit replays
+    jobs.parallelFor(m_drawLists.size(), 1, [this](size_t begin, size_t end) {
+        for (size_t l = begin; l < end; l++)
+        {
+            m_drawLists[l].sort();
+        }
+    });
+    DrawCommandList::merge(m_drawLists, m_submitOrder);
+};
+
+template<typename Transforms>
+void Scene::recordDrawLists(const Transforms& transforms)
+{
+    JobSystem& jobs = JobSystem::getInstance();
+    TextureResidency& residency = TextureResidency::getInstance();
+    const glm::vec3 cameraPosition = m_camera->getCameraPosition();
+    // an object of size s at distance d is s / d * projection[1][1] * height / 2 pixels tall
+    const float pixelsPerUnit = m_camera->getProjection()[1][1] * residency.getViewportHeight() * 0.5f;
+    m_world.eachChunkParallel<TransformComponent, MeshRenderer, BoundsComponent>([&](size_t count, TransformComponent* transform, MeshRenderer* renderer, BoundsComponent* bounds) {
+        DrawCommandList& drawList = m_drawLists[jobs.threadIndex()];
+        for (size_t i = 0; i < count; i++)
+        {
+            if (!bounds[i].visible || !renderer[i].mesh || !renderer[i].material)
+                continue;
+
+            const glm::mat4& model = transforms.getModel(transform[i].id);
+            glm::vec3 offset = glm::vec3(model[3].x, model[3].y, model[3].z) - cameraPosition;
+            uint64_t key = DrawCommandList::makeSortKey(renderer[i].drawTriangles, renderer[i].materialIndex, renderer[i].meshIndex, glm::dot(offset, offset));
+            drawList.add(key, { model, renderer[i].mesh, renderer[i].materialIndex, renderer[i].drawTriangles });
+
+            // the mip level its textures need at this size on screen (see TextureResidency)
+            const std::map<std::string, Texture2D*>& textures = renderer[i].material->getTextures();
+            if (!textures.empty())
+            {
+                float size = glm::length(bounds[i].world.max - bounds[i].world.min);
+                float pixels = size / std::max(std::sqrt(glm::dot(offset, offset)), 0.001f) * pixelsPerUnit;
+                for (const auto& texture : textures)
+                {
+                    if (texture.second)
+                        residency.request(*texture.second, pixels);
+                }
+            }
+        }
+    });
+};
+
+void Scene::submit()
+{
+    drawMeshes(
+        m_camera->getView(),
+        m_camera->getProjection()
+    );
+};
+
+void Scene::record(SceneCommands& commands)
+{
+    commands.view = m_camera->getView();
+    commands.projection = m_camera->getProjection();
+    commands.packets.resize(m_submitOrder.size());
+    JobSystem::getInstance().parallelFor(m_submitOrder.size(), 4096, [this, &commands](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            const DrawCommandRef& ref = m_submitOrder[i];
+            const DrawCommand& command = m_drawLists[ref.list].command(ref.index);
+            DrawPacket& packet = commands.packets[i];
+            packet.model = command.model;
+            packet.shader = m_materials[command.materialIndex]->getShader();
+            packet.vertexArray = command.mesh->getVertexArray();
+            packet.firstIndex = command.mesh->getFirstIndex();
+            packet.baseVertex = command.mesh->getBaseVertex();
+            packet.count = (unsigned int)command.mesh->getDrawCount();
+            packet.indexed = command.mesh->isIndexed();
+            packet.drawTriangles = command.drawTriangles;
+        }
+    });
+
+    // the draws are counted when they are recorded, the render thread never touches the RenderStats
+    // so the binds and uniforms are counted the way RenderThread::replay will issue them
+    Shader* currentShader = nullptr;
+    unsigned int currentVertexArray = 0;
+    for (const DrawPacket& packet : commands.packets)
+    {
+        if (packet.shader != currentShader)
+        {
+            currentShader = packet.shader;
+            RenderStats::recordProgramBind();
+            RenderStats::recordUniformUploads(2);
+        }
+        RenderStats::recordUniformUploads(1);
+        if (packet.vertexArray != currentVertexArray)
+        {
+            currentVertexArray = packet.vertexArray;
+            RenderStats::recordVertexArrayBind();
+        }
+        RenderStats::recordDraw(packet.drawTriangles ? GL_TRIANGLES : GL_LINES, packet.count);
+    }
+};
+
+template<typename Transforms>
+void Scene::cullBounds(const Transforms& transforms, const Frustum& frustum)
+{
+    // copying the bounds and testing them in the same pass reads every chunk only once
+    std::atomic<uint64_t> culled{ 0 };
+    m_world.eachChunkParallel<TransformComponent, BoundsComponent>([&transforms, &frustum, &culled](size_t count, TransformComponent* transform, BoundsComponent* bounds) {
+        uint64_t chunkCulled = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            // an object created after the simulation's last snapshot shows up next frame
+            if (!transforms.contains(transform[i].id))
+            {
+                bounds[i].visible = false;
+                chunkCulled++;
+                continue;
+            }
+            bounds[i].world = transforms.getWorldBounds(transform[i].id);
+            bounds[i].visible = frustum.intersects(bounds[i].world);
+            if (!bounds[i].visible)
+                chunkCulled++;
+        }
+        culled.fetch_add(chunkCulled, std::memory_order_relaxed);
+    });
+    // the cull task is the only one counting while it runs
+    RenderStats::recordCulled(culled.load(std::memory_order_relaxed));
+};
+
+void Scene::drawMeshes(const glm::mat4& view, const glm::mat4& projection)
+{
+    // the commands arrive grouped by material, so the program and the camera matrices
+    // only change when the material does, everything else is one uniform and one draw
+    // the meshes of one arena share its VAO, it is only bound again when the arena changes
+    uint32_t currentMaterial = 0xFFFFFFFF;
+    Shader* currentShader = nullptr;
+    unsigned int currentVertexArray = 0;
+    for (const DrawCommandRef& ref : m_submitOrder)
     {
-        iter.second->draw(
-            m_camera->getView(),
-            m_camera->getProjection()
-        );
+        const DrawCommand& command = m_drawLists[ref.list].command(ref.index);
+        if (command.materialIndex != currentMaterial)
+        {
+            currentMaterial = command.materialIndex;
+            currentShader = &m_materials[currentMaterial]->use();
+            currentShader->SetMatrix4("view"_sid, view);
+            currentShader->SetMatrix4("projection"_sid, projection);
+            RenderStats::recordProgramBind();
+            RenderStats::recordUniformUploads(2);
+        }
+        currentShader->SetMatrix4("model"_sid, command.model);
+        RenderStats::recordUniformUploads(1);
+        const Mesh& mesh = *command.mesh;
+        if (mesh.getVertexArray() != currentVertexArray)
+        {
+            currentVertexArray = mesh.getVertexArray();
+            glBindVertexArray(currentVertexArray);
+            RenderStats::recordVertexArrayBind();
+        }
+        Mesh::drawRange((unsigned int)mesh.getDrawCount(), mesh.isIndexed(), mesh.getFirstIndex(), mesh.getBaseVertex(), command.drawTriangles);
+        RenderStats::recordDraw(command.drawTriangles ? GL_TRIANGLES : GL_LINES, mesh.getDrawCount());
     }
+    glBindVertexArray(0);
 };
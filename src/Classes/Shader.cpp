@@ -1,15 +1,16 @@
 #include "ResourceClasses/Shader.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
 Shader::Shader()
 {
-    ID = 0;
 };
 
 Shader& Shader::Use()
 {
-    glUseProgram(ID);
+    glUseProgram(m_program.get());
     return *this;
 }
 
@@ -49,9 +50,7 @@ void Shader::setGeometrySource(const char* geometrySourceFile)
     if (geometrySourceFile != nullptr)
     {
         m_gShaderFile = std::string(geometrySourceFile);
-        Logger::info(
-            MESSAGE("Saved filename: " + m_gShaderFile)
-        );
+        LOG_DEBUG("Saved filename: {}", m_gShaderFile);
     }
 }
 
@@ -88,7 +87,8 @@ void Shader::Compile(const char* vertexSource, const char* fragmentSource, const
     }
     
     // shader program (linking of the shaders)
-    ID = glCreateProgram();
+    m_program = GLProgram::create();
+    GLuint ID = m_program.get();
     glAttachShader(ID, sVertex);
     glAttachShader(ID, sFragment);
     if (geometrySource != nullptr)
@@ -97,6 +97,15 @@ void Shader::Compile(const char* vertexSource, const char* fragmentSource, const
     }
     glLinkProgram(ID);
     checkCompileErrors(ID, "PROGRAM");
+    cacheUniformLocations();
+
+    // the driver's binary is the best size we can get (GL 4.1), before that the sources are what we know it keeps
+    GLint binaryLength = 0;
+    if (GLAD_GL_VERSION_4_1)
+        glGetProgramiv(ID, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+    if (binaryLength <= 0)
+        binaryLength = (GLint)(strlen(vertexSource) + strlen(fragmentSource) + (geometrySource ? strlen(geometrySource) : 0));
+    m_memory.track(MemoryCategory::PROGRAMS, "program", (size_t)binaryLength);
 
     // delete the shaders as they're linked into our program now and no longer necessary
     glDeleteShader(sVertex);
@@ -107,61 +116,105 @@ void Shader::Compile(const char* vertexSource, const char* fragmentSource, const
     }
 }
 
-void Shader::SetFloat(const char* name, float value, bool useShader)
+void Shader::SetFloat(StringID name, float value, bool useShader)
 {
     if (useShader)
         Use();
-    glUniform1f(glGetUniformLocation(ID, name), value);
+    glUniform1f(getUniformLocation(name), value);
 }
-void Shader::SetInteger(const char* name, int value, bool useShader)
+void Shader::SetInteger(StringID name, int value, bool useShader)
 {
     if (useShader)
         Use();
-    glUniform1i(glGetUniformLocation(ID, name), value);
+    glUniform1i(getUniformLocation(name), value);
 }
-void Shader::SetVector2f(const char* name, float x, float y, bool useShader)
+void Shader::SetVector2f(StringID name, float x, float y, bool useShader)
 {
     if (useShader)
         Use();
-    glUniform2f(glGetUniformLocation(ID, name), x, y);
+    glUniform2f(getUniformLocation(name), x, y);
 }
-void Shader::SetVector2f(const char* name, const glm::vec2& value, bool useShader)
+void Shader::SetVector2f(StringID name, const glm::vec2& value, bool useShader)
 {
     if (useShader)
         Use();
-    glUniform2f(glGetUniformLocation(ID, name), value.x, value.y);
+    glUniform2f(getUniformLocation(name), value.x, value.y);
 }
-void Shader::SetVector3f(const char* name, float x, float y, float z, bool useShader)
+void Shader::SetVector3f(StringID name, float x, float y, float z, bool useShader)
 {
     if (useShader)
         Use();
-    glUniform3f(glGetUniformLocation(ID, name), x, y, z);
+    glUniform3f(getUniformLocation(name), x, y, z);
 }
-void Shader::SetVector3f(const char* name, const glm::vec3& value, bool useShader)
+void Shader::SetVector3f(StringID name, const glm::vec3& value, bool useShader)
 {
     if (useShader)
         Use();
-    glUniform3f(glGetUniformLocation(ID, name), value.x, value.y, value.z);
+    glUniform3f(getUniformLocation(name), value.x, value.y, value.z);
 }
-void Shader::SetVector4f(const char* name, float x, float y, float z, float w, bool useShader)
+void Shader::SetVector4f(StringID name, float x, float y, float z, float w, bool useShader)
 {
     if (useShader)
         Use();
-    glUniform4f(glGetUniformLocation(ID, name), x, y, z, w);
+    glUniform4f(getUniformLocation(name), x, y, z, w);
 }
-void Shader::SetVector4f(const char* name, const glm::vec4& value, bool useShader)
+void Shader::SetVector4f(StringID name, const glm::vec4& value, bool useShader)
 {
     if (useShader)
         Use();
-    glUniform4f(glGetUniformLocation(ID, name), value.x, value.y, value.z, value.w);
+    glUniform4f(getUniformLocation(name), value.x, value.y, value.z, value.w);
 }
-void Shader::SetMatrix4(const char* name, const glm::mat4& matrix, bool useShader)
+void Shader::SetMatrix4(StringID name, const glm::mat4& matrix, bool useShader)
 {
     if (useShader)
         Use();
-    glUniformMatrix4fv(glGetUniformLocation(ID, name), 1, false, glm::value_ptr(matrix));
+    glUniformMatrix4fv(getUniformLocation(name), 1, false, glm::value_ptr(matrix));
+}
+
+
+GLint Shader::getUniformLocation(StringID name) const
+{
+    auto it = std::lower_bound(m_uniformLocations.begin(), m_uniformLocations.end(), name,
+        [](const std::pair<StringID, GLint>& entry, StringID id) { return entry.first < id; });
+    return (it != m_uniformLocations.end() && it->first == name) ? it->second : -1;
 }
 
+void Shader::cacheUniformLocations()
+{
+    m_uniformLocations.clear();
+    GLint count = 0;
+    GLuint ID = m_program.get();
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    char name[256];
+    for (GLint i = 0; i < count; i++)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(ID, (GLuint)i, sizeof(name), &length, &size, &type, name);
+        GLint location = glGetUniformLocation(ID, name);
+        // members of uniform blocks have no location of their own
+        if (location < 0)
+            continue;
+
+        std::string uniformName(name, length);
+        m_uniformLocations.emplace_back(StringID::intern(uniformName), location);
+        // arrays are reported as "name[0]", every element gets its own entry and the bare name means element 0
+        size_t bracket = uniformName.find('[');
+        if (bracket != std::string::npos)
+        {
+            std::string baseName = uniformName.substr(0, bracket);
+            m_uniformLocations.emplace_back(StringID::intern(baseName), location);
+            for (GLint element = 1; element < size; element++)
+            {
+                std::string elementName = baseName + "[" + std::to_string(element) + "]";
+                m_uniformLocations.emplace_back(StringID::intern(elementName), glGetUniformLocation(ID, elementName.c_str()));
+            }
+        }
+    }
+    std::sort(m_uniformLocations.begin(), m_uniformLocations.end(),
+        [](const std::pair<StringID, GLint>& a, const std::pair<StringID, GLint>& b) { return a.first < b.first; });
+}
 
 void Shader::checkCompileErrors(unsigned int object, std::string type)
 {
@@ -173,9 +226,7 @@ void Shader::checkCompileErrors(unsigned int object, std::string type)
         if (!success)
         {
             glGetShaderInfoLog(object, 1024, NULL, infoLog);
-            Logger::error(
-                MESSAGE("SHADER: Compile-time error: Type: " + type + "\n" + infoLog + "\n -- --------------------------------------------------- -- ")
-            );
+            LOG_ERROR("SHADER: Compile-time error: Type: {}\n{}\n -- --------------------------------------------------- -- ", type, infoLog);
         }
     }
     else
@@ -184,9 +235,7 @@ void Shader::checkCompileErrors(unsigned int object, std::string type)
         if (!success)
         {
             glGetProgramInfoLog(object, 1024, NULL, infoLog);
-            Logger::error(
-                MESSAGE("SHADER: Link-time error: Type: " + type + "\n" + infoLog + "\n -- --------------------------------------------------- -- ")
-            );
+            LOG_ERROR("SHADER: Link-time error: Type: {}\n{}\n -- --------------------------------------------------- -- ", type, infoLog);
         }
     }
 }
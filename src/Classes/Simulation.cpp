@@ -0,0 +1,240 @@
+#include "UtilClasses/Simulation.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "UtilClasses/JobSystem.h"
+#include "UtilClasses/Logger.h"
+#include "UtilClasses/AllocationTracker.h"
+
+// a simulation that falls further behind than this stops trying to catch up
+// (otherwise every slow tick makes the next frame run even more ticks, the "spiral of death")
+static const int MAX_TICKS_BEHIND = 5;
+
+Simulation::~Simulation()
+{
+    stop();
+};
+
+void Simulation::setTickRate(float ticksPerSecond)
+{
+    m_tickSeconds = 1.0f / std::max(ticksPerSecond, 1.0f);
+};
+
+void Simulation::addSystem(std::function<void(float dt, double time)> system)
+{
+    auto lock = lockWorld();
+    m_systems.push_back(std::move(system));
+};
+
+double Simulation::secondsSinceStart() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+};
+
+void Simulation::start()
+{
+    if (m_running)
+        return;
+
+    m_startTime = std::chrono::steady_clock::now();
+    m_tick = 0;
+    m_droppedTicks = 0;
+    m_previous = -1;
+    m_newest = -1;
+    // the first tick runs right here, so there is a snapshot before the first frame asks for one
+    tick(0.0);
+    interpolate();
+
+    m_running = true;
+    m_thread = std::thread(&Simulation::run, this);
+    LOG_INFO("SIMULATION: Running at {} ticks per second", getTickRate());
+};
+
+void Simulation::stop()
+{
+    if (!m_running)
+        return;
+
+    m_running = false;
+    m_thread.join();
+    LOG_INFO("SIMULATION: Stopped after {} ticks ({} dropped)", m_tick.load(), m_droppedTicks.load());
+};
+
+void Simulation::run()
+{
+    double next = m_tickSeconds;
+    while (m_running)
+    {
+        std::this_thread::sleep_until(m_startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(next)));
+        if (!m_running)
+            break;
+
+        tick(next);
+        next += m_tickSeconds;
+
+        double behind = secondsSinceStart() - next;
+        if (behind > MAX_TICKS_BEHIND * m_tickSeconds)
+        {
+            uint64_t skipped = (uint64_t)(behind / m_tickSeconds);
+            m_droppedTicks += skipped;
+            next += skipped * m_tickSeconds;
+            LOG_WARNING("SIMULATION: {} ticks behind, skipped them", skipped);
+        }
+    }
+};
+
+void Simulation::tick(double scheduledTime)
+{
+    PROFILE_ZONE("simulation tick");
+    {
+        auto lock = lockWorld();
+        double time = m_tick * (double)m_tickSeconds;
+        for (auto& system : m_systems)
+        {
+            system(m_tickSeconds, time);
+        }
+
+        TransformStorage& transforms = TransformStorage::getInstance();
+        transforms.updateModelMatrices();
+        TransformSnapshot& snapshot = acquireWriteSnapshot();
+        transforms.copyTo(snapshot);
+        snapshot.tick = m_tick;
+        snapshot.time = scheduledTime;
+    }
+    publish();
+    m_tick++;
+};
+
+TransformSnapshot& Simulation::acquireWriteSnapshot()
+{
+    std::unique_lock<std::mutex> lock(m_snapshotMutex);
+    // with 3 snapshots there is always one that is neither the newest nor the previous one
+    for (int i = 0; i < 3; i++)
+    {
+        if (i != m_previous && i != m_newest)
+        {
+            m_writing = i;
+            break;
+        }
+    }
+    // the renderer may still be blending it (it was the "previous" snapshot until the last publish)
+    m_snapshotReleased.wait(lock, [this]() { return m_pinned[0] != m_writing && m_pinned[1] != m_writing; });
+    return m_snapshots[m_writing];
+};
+
+void Simulation::publish()
+{
+    std::lock_guard<std::mutex> lock(m_snapshotMutex);
+    m_previous = m_newest;
+    m_newest = m_writing;
+};
+
+// blends 2 affine matrices: the translation is interpolated linearly and so are the axes,
+// but every axis keeps the interpolated length of the 2 originals (a plain lerp of 2 rotations
+// would shrink the object halfway through), cheap and close enough to a slerp for 1 tick apart
+static void blendMatrix(const glm::mat4& from, const glm::mat4& to, float t, glm::mat4& result)
+{
+    for (int column = 0; column < 3; column++)
+    {
+        float fromLength = 0.0f, toLength = 0.0f, length = 0.0f;
+        for (int row = 0; row < 3; row++)
+        {
+            float value = from[column][row] + (to[column][row] - from[column][row]) * t;
+            result[column][row] = value;
+            fromLength += from[column][row] * from[column][row];
+            toLength += to[column][row] * to[column][row];
+            length += value * value;
+        }
+        float wanted = std::sqrt(fromLength) + (std::sqrt(toLength) - std::sqrt(fromLength)) * t;
+        float scale = length > 0.0f ? wanted / std::sqrt(length) : 0.0f;
+        for (int row = 0; row < 3; row++)
+        {
+            result[column][row] *= scale;
+        }
+        result[column][3] = 0.0f;
+    }
+    for (int row = 0; row < 3; row++)
+    {
+        result[3][row] = from[3][row] + (to[3][row] - from[3][row]) * t;
+    }
+    result[3][3] = 1.0f;
+};
+
+const TransformSnapshot& Simulation::interpolate()
+{
+    int previous, newest;
+    {
+        std::lock_guard<std::mutex> lock(m_snapshotMutex);
+        previous = m_previous;
+        newest = m_newest;
+        m_pinned[0] = previous;
+        m_pinned[1] = newest;
+    }
+
+    const TransformSnapshot& to = m_snapshots[newest];
+    m_render.world.resize(to.world.size());
+    m_render.worldBounds.resize(to.worldBounds.size());
+    m_render.idToSlot = to.idToSlot;
+    m_render.slotToId = to.slotToId;
+    m_render.idGeneration = to.idGeneration;
+    m_render.tick = to.tick;
+
+    // the frame shows the simulation one tick in the past, that way there is (almost) always
+    // a newer snapshot to blend towards instead of having to guess where things will be
+    double renderTime = secondsSinceStart() - m_tickSeconds;
+    float t = 1.0f;
+    if (previous >= 0 && to.time > m_snapshots[previous].time)
+    {
+        t = (float)std::min(std::max((renderTime - m_snapshots[previous].time) / (to.time - m_snapshots[previous].time), 0.0), 1.0);
+    }
+    m_render.time = renderTime;
+
+    if (previous < 0 || t >= 1.0f)
+    {
+        m_render.world = to.world;
+        m_render.worldBounds = to.worldBounds;
+    }
+    else
+    {
+        const TransformSnapshot& from = m_snapshots[previous];
+        JobSystem::getInstance().parallelFor(to.world.size(), 4096, [&](size_t begin, size_t end) {
+            for (size_t slot = begin; slot < end; slot++)
+            {
+                TransformId id = to.slotToId[slot];
+                // a transform that didn't exist yet (or was a different one) one tick ago just appears
+                if (!from.contains(id) || from.idGeneration[id] != to.idGeneration[id])
+                {
+                    m_render.world[slot] = to.world[slot];
+                    m_render.worldBounds[slot] = to.worldBounds[slot];
+                    continue;
+                }
+
+                uint32_t fromSlot = from.idToSlot[id];
+                blendMatrix(from.world[fromSlot], to.world[slot], t, m_render.world[slot]);
+                // both boxes together, culling has to keep everything that could be anywhere in between
+                const TransformBounds& a = from.worldBounds[fromSlot];
+                const TransformBounds& b = to.worldBounds[slot];
+                TransformBounds& bounds = m_render.worldBounds[slot];
+                if (!a.valid() || !b.valid())
+                {
+                    bounds = b;
+                    continue;
+                }
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    bounds.min[axis] = std::min(a.min[axis], b.min[axis]);
+                    bounds.max[axis] = std::max(a.max[axis], b.max[axis]);
+                }
+            }
+        });
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_snapshotMutex);
+        m_pinned[0] = -1;
+        m_pinned[1] = -1;
+    }
+    m_snapshotReleased.notify_all();
+    return m_render;
+};
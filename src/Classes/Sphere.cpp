@@ -81,8 +81,8 @@ Sphere::Sphere(int radius, int longitudes, int latitudes)
         }
     }
 
-	GameObject::setMesh(new Mesh(vertices, indices));
-	GameObject::setMaterial(new Material(ResourceManager::GetShader(STD_SHADER)));
+	setOwnedMesh(new Mesh(vertices, indices));
+	setOwnedMaterial(new Material(ResourceManager::GetShader(ResourceManager::FindShader(StringID(STD_SHADER)))));
 };
 
 Sphere::Sphere(int radius, int longitudes, int latitudes,glm::vec3& cubePosition)
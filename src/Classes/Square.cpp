@@ -15,8 +15,8 @@ Square::Square()
 		1, 2, 3    // second triangle
 	};
 
-	GameObject::setMesh(new Mesh(vertices, indices));
-	GameObject::setMaterial(new Material(ResourceManager::GetShader(STD_SHADER)));
+	setOwnedMesh(new Mesh(vertices, indices));
+	setOwnedMaterial(new Material(ResourceManager::GetShader(ResourceManager::FindShader(StringID(STD_SHADER)))));
 };
 
 Square::Square(glm::vec3& cubePosition)
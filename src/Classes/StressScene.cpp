@@ -0,0 +1,651 @@
+#include "UtilClasses/StressScene.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <glm/gtc/quaternion.hpp>
+
+#include "Game.h"
+#include "Sphere.h"
+#include "Cube.h"
+#include "Axis.h"
+#include "RenderStats.h"
+#include "TransformStorage.h"
+#include "Logger.h"
+
+// ------------------------------------------------------------------------------------------------
+// StressSceneConfig
+// ------------------------------------------------------------------------------------------------
+
+static MotionPattern parseMotion(const std::string& value)
+{
+	if (value == "static") return MotionPattern::STATIC;
+	if (value == "bob") return MotionPattern::BOB;
+	if (value == "spin") return MotionPattern::SPIN;
+	return MotionPattern::ORBIT;
+};
+
+static const char* motionName(MotionPattern motion)
+{
+	switch (motion)
+	{
+	case MotionPattern::STATIC: return "static";
+	case MotionPattern::BOB: return "bob";
+	case MotionPattern::SPIN: return "spin";
+	default: return "orbit";
+	}
+};
+
+static CameraPath parseCameraPath(const std::string& value)
+{
+	if (value == "static") return CameraPath::STATIC;
+	if (value == "flythrough") return CameraPath::FLYTHROUGH;
+	return CameraPath::ORBIT;
+};
+
+static const char* cameraPathName(CameraPath path)
+{
+	switch (path)
+	{
+	case CameraPath::STATIC: return "static";
+	case CameraPath::FLYTHROUGH: return "flythrough";
+	default: return "orbit";
+	}
+};
+
+bool StressSceneConfig::requested(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--stress") == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+};
+
+StressSceneConfig StressSceneConfig::fromArgs(int argc, char** argv)
+{
+	StressSceneConfig config;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument(argv[i]);
+		if (argument == "--stress")
+			continue;
+
+		size_t split = argument.find('=');
+		if (argument.rfind("--", 0) != 0 || split == std::string::npos)
+		{
+			LOG_WARNING("STRESS: Ignored argument {}", argument);
+			continue;
+		}
+		std::string key = argument.substr(2, split - 2);
+		std::string value = argument.substr(split + 1);
+
+		if (key == "seed") config.seed = (uint32_t)std::strtoul(value.c_str(), nullptr, 10);
+		else if (key == "spheres") config.sphereCount = std::atoi(value.c_str());
+		else if (key == "cubes") config.cubeCount = std::atoi(value.c_str());
+		else if (key == "axes") config.axisCount = std::atoi(value.c_str());
+		else if (key == "longitudes") config.sphereLongitudes = std::atoi(value.c_str());
+		else if (key == "latitudes") config.sphereLatitudes = std::atoi(value.c_str());
+		else if (key == "extent") config.spawnExtent = (float)std::atof(value.c_str());
+		else if (key == "depth") config.hierarchyDepth = std::max(1, std::atoi(value.c_str()));
+		else if (key == "motion") config.motion = parseMotion(value);
+		else if (key == "motion-speed") config.motionSpeed = (float)std::atof(value.c_str());
+		else if (key == "camera") config.cameraPath = parseCameraPath(value);
+		else if (key == "camera-radius") config.cameraRadius = (float)std::atof(value.c_str());
+		else if (key == "camera-speed") config.cameraSpeed = (float)std::atof(value.c_str());
+		else if (key == "warmup") config.warmupFrames = std::atoi(value.c_str());
+		else if (key == "frames") config.frameCount = std::atoi(value.c_str());
+		else if (key == "gpu-sync") config.gpuSync = value != "0";
+		else if (key == "out") config.outputPath = value;
+		else if (key == "baseline") config.baselinePath = value;
+		else if (key == "tolerance") config.regressionTolerance = std::atof(value.c_str());
+		else if (key == "sim-rate") config.simulationRate = (float)std::atof(value.c_str());
+		else if (key == "alloc-check") config.allocCheck = value != "0";
+		else if (key == "log-file" || key == "log-level" || key == "jobs" || key == "render-thread" || key == "fps" || key == "latency"
+			|| key == "memory-budget" || key == "memory-report" || key == "gl-debug"
+			|| key == "flight-recorder") continue; // handled by main
+		else LOG_WARNING("STRESS: Unknown option --{}", key);
+	}
+	return config;
+};
+
+// ------------------------------------------------------------------------------------------------
+// StressSceneGenerator
+// ------------------------------------------------------------------------------------------------
+
+StressSceneGenerator::StressSceneGenerator(const StressSceneConfig& config)
+	: m_config(config), m_random(config.seed)
+{
+};
+
+float StressSceneGenerator::random01()
+{
+	// 24 random bits is exactly what fits in a float mantissa
+	return (float)(m_random() >> 8) * (1.0f / 16777216.0f);
+};
+
+float StressSceneGenerator::randomRange(float min, float max)
+{
+	return min + (max - min) * random01();
+};
+
+void StressSceneGenerator::populate(Scene& scene, Camera& camera)
+{
+	m_camera = &camera;
+	scene.setCamera(&camera);
+	// the camera paths stay within 1.5 radii of the center, the farthest object is the cube's corner beyond that
+	camera.setClipPlanes(0.1f, 1.5f * m_config.cameraRadius + 1.75f * m_config.spawnExtent + 10.0f);
+
+	// with --depth=N every N consecutive objects form a chain (an "arm"), every link sits a bit above
+	// the previous one and moves relative to it, so the motion of the first link carries all the others
+	GameObject* chainTail = nullptr;
+	int chainLength = 0;
+	auto spawn = [this, &scene, &chainTail, &chainLength](const std::string& name, GameObject* object) {
+		glm::vec3 origin;
+		if (chainTail && chainLength < m_config.hierarchyDepth)
+		{
+			origin = glm::vec3(randomRange(-1.0f, 1.0f), 3.0f, randomRange(-1.0f, 1.0f));
+			object->setParent(chainTail);
+			chainLength++;
+		}
+		else
+		{
+			origin = glm::vec3(
+				randomRange(-m_config.spawnExtent, m_config.spawnExtent),
+				randomRange(-m_config.spawnExtent, m_config.spawnExtent),
+				randomRange(-m_config.spawnExtent, m_config.spawnExtent)
+			);
+			chainLength = 1;
+		}
+		chainTail = object;
+		object->setPosition(origin);
+		m_objects.push_back({ object, origin, randomRange(0.0f, 6.2831853f), randomRange(0.5f, 1.5f) });
+		scene.addGameObject(name, object);
+	};
+
+	// zero padded names keep the std::map (used by the UI) sorted the same way on every run,
+	// the draw order follows the order in which the objects are created
+	char name[32];
+	for (int i = 0; i < m_config.sphereCount; i++)
+	{
+		std::snprintf(name, sizeof(name), "StressSphere_%06d", i);
+		spawn(name, new Sphere(1, m_config.sphereLongitudes, m_config.sphereLatitudes));
+	}
+	for (int i = 0; i < m_config.cubeCount; i++)
+	{
+		std::snprintf(name, sizeof(name), "StressCube_%06d", i);
+		spawn(name, new Cube());
+	}
+	for (int i = 0; i < m_config.axisCount; i++)
+	{
+		std::snprintf(name, sizeof(name), "StressAxis_%06d", i);
+		spawn(name, new Axis(2.0f));
+	}
+
+	animate(0.0f);
+};
+
+void StressSceneGenerator::clear(Scene& scene)
+{
+	for (Animated& animated : m_objects)
+	{
+		scene.destroyGameObject(animated.object);
+	}
+	m_objects.clear();
+};
+
+void StressSceneGenerator::animate(float time)
+{
+	animateObjects(time);
+	animateCamera(time);
+};
+
+void StressSceneGenerator::animateObjects(float time)
+{
+	if (m_config.motion != MotionPattern::STATIC)
+	{
+		for (Animated& animated : m_objects)
+		{
+			float t = time * m_config.motionSpeed * animated.speed + animated.phase;
+			switch (m_config.motion)
+			{
+			case MotionPattern::ORBIT:
+			{
+				// rotate the spawn position around the world Y-axis
+				float c = cosf(t), s = sinf(t);
+				glm::vec3 position(
+					animated.origin.x * c - animated.origin.z * s,
+					animated.origin.y,
+					animated.origin.x * s + animated.origin.z * c
+				);
+				animated.object->setPosition(position);
+				break;
+			}
+			case MotionPattern::BOB:
+				animated.object->setPosition(animated.origin + glm::vec3(0.0f, 2.0f * sinf(t), 0.0f));
+				break;
+			case MotionPattern::SPIN:
+				animated.object->setRotation(glm::angleAxis(t, glm::vec3(0.0f, 1.0f, 0.0f)));
+				break;
+			default:
+				break;
+			}
+		}
+	}
+};
+
+void StressSceneGenerator::animateCamera(float time)
+{
+	if (m_camera)
+	{
+		float t = time * m_config.cameraSpeed;
+		float r = m_config.cameraRadius;
+		glm::vec3 target(0.0f);
+		switch (m_config.cameraPath)
+		{
+		case CameraPath::STATIC:
+			m_camera->lookAt(glm::vec3(0.0f, 0.0f, r), target);
+			break;
+		case CameraPath::ORBIT:
+			m_camera->lookAt(glm::vec3(r * cosf(t), 0.25f * r, r * sinf(t)), target);
+			break;
+		case CameraPath::FLYTHROUGH:
+			// a lissajous curve passes through the scene instead of around it
+			m_camera->lookAt(
+				glm::vec3(r * sinf(t), 0.3f * r * sinf(2.0f * t), r * cosf(3.0f * t)),
+				glm::vec3(0.5f * r * sinf(t + 0.5f), 0.0f, 0.5f * r * cosf(3.0f * t + 0.5f))
+			);
+			break;
+		}
+	}
+};
+
+// ------------------------------------------------------------------------------------------------
+// FrameTimeReport
+// ------------------------------------------------------------------------------------------------
+
+// nearest-rank percentile on an already sorted array
+static double percentile(const std::vector<double>& sorted, double p)
+{
+	if (sorted.empty())
+		return 0.0;
+	size_t rank = (size_t)std::ceil(p / 100.0 * sorted.size());
+	rank = std::min(std::max(rank, (size_t)1), sorted.size());
+	return sorted[rank - 1];
+};
+
+FrameTimeReport FrameTimeReport::fromSamples(std::vector<double> frameTimesMs, double drawCalls, double triangles)
+{
+	FrameTimeReport report;
+	report.frames = (int)frameTimesMs.size();
+	report.drawCallsPerFrame = drawCalls;
+	report.trianglesPerFrame = triangles;
+	if (frameTimesMs.empty())
+		return report;
+
+	std::sort(frameTimesMs.begin(), frameTimesMs.end());
+	double sum = 0.0;
+	for (double sample : frameTimesMs)
+	{
+		sum += sample;
+	}
+	report.minMs = frameTimesMs.front();
+	report.maxMs = frameTimesMs.back();
+	report.meanMs = sum / frameTimesMs.size();
+	report.p50Ms = percentile(frameTimesMs, 50.0);
+	report.p95Ms = percentile(frameTimesMs, 95.0);
+	report.p99Ms = percentile(frameTimesMs, 99.0);
+	return report;
+};
+
+std::string FrameTimeReport::toJson(const StressSceneConfig& config) const
+{
+	std::ostringstream json;
+	json.setf(std::ios::fixed);
+	json.precision(4);
+	json << "{\n";
+	json << "  \"config\": {\n";
+	json << "    \"seed\": " << config.seed << ",\n";
+	json << "    \"spheres\": " << config.sphereCount << ",\n";
+	json << "    \"cubes\": " << config.cubeCount << ",\n";
+	json << "    \"axes\": " << config.axisCount << ",\n";
+	json << "    \"depth\": " << config.hierarchyDepth << ",\n";
+	json << "    \"longitudes\": " << config.sphereLongitudes << ",\n";
+	json << "    \"latitudes\": " << config.sphereLatitudes << ",\n";
+	json << "    \"motion\": \"" << motionName(config.motion) << "\",\n";
+	json << "    \"camera\": \"" << cameraPathName(config.cameraPath) << "\",\n";
+	json << "    \"warmup\": " << config.warmupFrames << ",\n";
+	json << "    \"threads\": " << JobSystem::getInstance().threadCount() << ",\n";
+	json << "    \"sim_rate\": " << config.simulationRate << ",\n";
+	json << "    \"render_thread\": " << (RenderThread::getInstance().isRunning() ? "true" : "false") << ",\n";
+	json << "    \"gpu_sync\": " << (config.gpuSync ? "true" : "false") << ",\n";
+	json << "    \"alloc_check\": " << (config.allocCheck ? "true" : "false") << "\n";
+	json << "  },\n";
+	json << "  \"frames\": " << frames << ",\n";
+	json << "  \"frame_time_ms\": {\n";
+	json << "    \"min\": " << minMs << ",\n";
+	json << "    \"mean\": " << meanMs << ",\n";
+	json << "    \"p50\": " << p50Ms << ",\n";
+	json << "    \"p95\": " << p95Ms << ",\n";
+	json << "    \"p99\": " << p99Ms << ",\n";
+	json << "    \"max\": " << maxMs << "\n";
+	json << "  },\n";
+	json << "  \"draw_calls\": " << drawCallsPerFrame << ",\n";
+	json << "  \"triangles\": " << trianglesPerFrame << ",\n";
+	json << "  \"transforms\": {\n";
+	json << "    \"kernel\": \"" << TransformStorage::kernelName() << "\",\n";
+	json << "    \"updated_per_frame\": " << transformsPerFrame << ",\n";
+	json << "    \"update_ms\": " << transformUpdateMs << "\n";
+	json << "  },\n";
+	json << "  \"simulation\": {\n";
+	json << "    \"ticks\": " << simulationTicks << ",\n";
+	json << "    \"dropped_ticks\": " << droppedTicks << "\n";
+	json << "  },\n";
+	json << "  \"pools\": {\n";
+	for (size_t i = 0; i < pools.size(); i++)
+	{
+		const ObjectPoolStats& pool = pools[i];
+		json << "    \"" << pool.name << "\": { \"live\": " << pool.live << ", \"high_water\": " << pool.highWater
+			<< ", \"capacity\": " << pool.capacity << ", \"allocations\": " << pool.allocations << " }" << (i + 1 < pools.size() ? "," : "") << "\n";
+	}
+	json << "  },\n";
+	json << "  \"memory\": {\n";
+	for (size_t i = 0; i < memory.size(); i++)
+	{
+		const MemoryCategoryStats& category = memory[i];
+		json << "    \"" << category.name << "\": { \"gpu\": " << (category.gpu ? "true" : "false") << ", \"bytes\": " << category.bytes
+			<< ", \"peak_bytes\": " << category.peakBytes << ", \"count\": " << category.records << " }" << (i + 1 < memory.size() ? "," : "") << "\n";
+	}
+	json << "  },\n";
+	json << "  \"mesh_arenas\": {\n";
+	json << "    \"arenas\": " << meshArenas.arenas << ",\n";
+	json << "    \"meshes\": " << meshArenas.meshes << ",\n";
+	json << "    \"capacity_bytes\": " << meshArenas.capacityBytes << ",\n";
+	json << "    \"used_bytes\": " << meshArenas.usedBytes << ",\n";
+	json << "    \"largest_free_bytes\": " << meshArenas.largestFreeBytes << ",\n";
+	json << "    \"free_blocks\": " << meshArenas.freeBlocks << ",\n";
+	json << "    \"fragmentation\": " << meshArenas.fragmentation << ",\n";
+	json << "    \"moves\": " << meshArenas.moves << ",\n";
+	json << "    \"moved_bytes\": " << meshArenas.movedBytes << "\n";
+	json << "  },\n";
+	// per frame, the gpu_ ones are left out when the driver had no pipeline statistics queries
+	json << "  \"counters\": {\n";
+	size_t counterCount = pipelineStatistics ? (size_t)RenderCounter::COUNT : (size_t)RenderCounter::VERTICES_SUBMITTED;
+	for (size_t c = 0; c < counterCount; c++)
+		json << "    \"" << RenderStats::counterName((RenderCounter)c) << "\": " << counters[c] << (c + 1 < counterCount ? "," : "") << "\n";
+	json << "  }";
+	if (allocationsTracked)
+	{
+		json << ",\n";
+		json << "  \"heap\": {\n";
+		json << "    \"allocating_frames\": " << allocatingFrames << ",\n";
+		json << "    \"max_per_frame\": " << maxAllocationsPerFrame << ",\n";
+		json << "    \"zones\": {\n";
+		for (size_t i = 0; i < allocationZones.size(); i++)
+		{
+			const AllocationZoneStats& zone = allocationZones[i];
+			json << "      \"" << zone.name << "\": { \"allocations\": " << zone.totalAllocations << ", \"bytes\": " << zone.totalBytes
+				<< " }" << (i + 1 < allocationZones.size() ? "," : "") << "\n";
+		}
+		json << "    }\n";
+		json << "  }";
+	}
+	json << "\n";
+	json << "}\n";
+	return json.str();
+};
+
+// ------------------------------------------------------------------------------------------------
+// StressHarness
+// ------------------------------------------------------------------------------------------------
+
+StressHarness::StressHarness(const StressSceneConfig& config)
+	: m_config(config)
+{
+};
+
+int StressHarness::run(Game& game, Scene& scene, Camera& camera)
+{
+	if (m_config.frameCount <= 0)
+	{
+		LOG_ERROR("STRESS: --frames has to be larger than 0");
+		return 2;
+	}
+	if (m_config.allocCheck && !AllocationTracker::isEnabled())
+	{
+		LOG_ERROR("STRESS: --alloc-check needs the AllocationTracker, it is enabled by --alloc-check=1 on the command line");
+		return 2;
+	}
+
+	StressSceneGenerator generator(m_config);
+	generator.populate(scene, camera);
+	game.loadResources();
+
+	LOG_INFO("STRESS: Running {} warm-up and {} measured frames", m_config.warmupFrames, m_config.frameCount);
+
+	// animation time advances with a fixed step so every run renders the exact same frames
+	const float animationStep = 1.0f / 60.0f;
+	const int totalFrames = m_config.warmupFrames + m_config.frameCount;
+
+	std::vector<double> frameTimesMs;
+	frameTimesMs.reserve(m_config.frameCount);
+	double drawCalls = 0.0;
+	double triangles = 0.0;
+	double transformsUpdated = 0.0;
+	double transformUpdateMs = 0.0;
+	double counters[(size_t)RenderCounter::COUNT] = {};
+	int pipelineFrames = 0;
+	int allocatingFrames = 0;
+	uint64_t maxAllocationsPerFrame = 0;
+
+	// with a simulation thread the objects move in its ticks, only the camera stays tied to the frames
+	Simulation& simulation = game.getSimulation();
+	if (m_config.simulationRate > 0.0f)
+	{
+		simulation.setTickRate(m_config.simulationRate);
+		simulation.addSystem([&generator](float, double time) {
+			generator.animateObjects((float)time);
+		});
+		simulation.start();
+	}
+
+	for (int frame = 0; frame < totalFrames && !glfwWindowShouldClose(game.m_gameWindow); frame++)
+	{
+		if (m_config.allocCheck && frame == m_config.warmupFrames)
+		{
+			// the warm-up frames may grow their buffers, only what allocates after that is reported
+			AllocationTracker::reset();
+			AllocationTracker::setCaptureCallSites(true);
+		}
+		auto start = std::chrono::steady_clock::now();
+
+		if (simulation.isRunning())
+			generator.animateCamera(frame * animationStep);
+		else
+			generator.animate(frame * animationStep);
+		game.Frame(animationStep);
+		if (m_config.gpuSync)
+		{
+			// behind the frame in the render thread's queue, so this also waits for the replay
+			RenderThread::getInstance().runSync([]() {
+				glFinish();
+			});
+		}
+
+		auto end = std::chrono::steady_clock::now();
+		if (frame >= m_config.warmupFrames)
+		{
+			frameTimesMs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+			drawCalls += (double)RenderStats::current().drawCalls;
+			triangles += (double)RenderStats::current().triangles;
+			transformsUpdated += (double)RenderStats::current().transformsUpdated;
+			transformUpdateMs += RenderStats::current().transformUpdateMs;
+			uint64_t allocations = RenderStats::current().allocations;
+			if (allocations > 0)
+				allocatingFrames++;
+			maxAllocationsPerFrame = std::max(maxAllocationsPerFrame, allocations);
+			const FrameRenderStats& stats = RenderStats::current();
+			for (size_t c = 0; c < (size_t)RenderCounter::COUNT; c++)
+			{
+				if (!RenderStats::isPipelineCounter((RenderCounter)c) || stats.pipeline.available)
+					counters[c] += (double)RenderStats::counterValue(stats, (RenderCounter)c);
+			}
+			if (stats.pipeline.available)
+				pipelineFrames++;
+		}
+	}
+	AllocationTracker::setCaptureCallSites(false);
+	std::vector<MemoryCategoryStats> memory;
+	for (size_t c = 0; c < (size_t)MemoryCategory::COUNT; c++)
+		memory.push_back(MemoryTracker::getInstance().getStats((MemoryCategory)c));
+	GpuBufferArenaStats meshArenas = GpuBufferArenas::getInstance().getStats();
+	std::vector<AllocationZoneStats> allocationZones;
+	if (m_config.allocCheck)
+	{
+		AllocationTracker::forEachZone([&allocationZones](const AllocationZoneStats& zone) {
+			allocationZones.push_back(zone);
+		});
+	}
+
+	// the generator's objects are animated by the simulation, it can't keep running after this function
+	uint64_t simulationTicks = simulation.getTickCount();
+	uint64_t droppedTicks = simulation.getDroppedTicks();
+	simulation.stop();
+	// after the measured frames, a cleared scene shows whether everything went back to the pools
+	generator.clear(scene);
+
+	if (frameTimesMs.empty())
+	{
+		LOG_ERROR("STRESS: No frames were measured");
+		return 2;
+	}
+
+	FrameTimeReport report = FrameTimeReport::fromSamples(
+		frameTimesMs,
+		drawCalls / frameTimesMs.size(),
+		triangles / frameTimesMs.size()
+	);
+	report.transformsPerFrame = transformsUpdated / frameTimesMs.size();
+	report.transformUpdateMs = transformUpdateMs / frameTimesMs.size();
+	report.simulationTicks = simulationTicks;
+	report.droppedTicks = droppedTicks;
+	report.memory = memory;
+	report.meshArenas = meshArenas;
+	for (size_t c = 0; c < (size_t)RenderCounter::COUNT; c++)
+	{
+		// the pipeline statistics arrive a few frames late, they are averaged over the frames that had them
+		if (RenderStats::isPipelineCounter((RenderCounter)c))
+			report.counters[c] = pipelineFrames > 0 ? counters[c] / pipelineFrames : 0.0;
+		else
+			report.counters[c] = counters[c] / frameTimesMs.size();
+	}
+	report.pipelineStatistics = pipelineFrames > 0;
+	ObjectPool::forEachPool([&report](ObjectPool& pool) {
+		report.pools.push_back(pool.getStats());
+	});
+	if (m_config.allocCheck)
+	{
+		report.allocationsTracked = true;
+		report.allocatingFrames = allocatingFrames;
+		report.maxAllocationsPerFrame = maxAllocationsPerFrame;
+		report.allocationZones = allocationZones;
+	}
+	std::string json = report.toJson(m_config);
+	// the report goes to stdout as well, don't let it interleave with pending log lines
+	Logger::flush();
+	std::cout << json;
+
+	if (!m_config.outputPath.empty())
+	{
+		std::ofstream output(m_config.outputPath, std::ios::out | std::ios::trunc);
+		if (!output.good())
+		{
+			LOG_ERROR("STRESS: Could not write report to {}", m_config.outputPath);
+			return 2;
+		}
+		output << json;
+		LOG_SUCCES("STRESS: Report written to {}", m_config.outputPath);
+	}
+
+	if (!m_config.baselinePath.empty() && compareWithBaseline(report))
+	{
+		return 1;
+	}
+	if (m_config.allocCheck && allocatingFrames > 0)
+	{
+		LOG_ERROR("STRESS: {} of {} measured frames allocated (up to {} allocations), the stacks that did:", allocatingFrames, report.frames, maxAllocationsPerFrame);
+		AllocationTracker::logCallSites(10);
+		Logger::flush();
+		return 3;
+	}
+	return 0;
+};
+
+// finds "key": <number> inside a JSON document written by FrameTimeReport::toJson
+// (we only ever read our own reports, so a full JSON parser would be overkill)
+static bool readJsonNumber(const std::string& json, const std::string& key, double& value)
+{
+	size_t position = json.find("\"" + key + "\"");
+	if (position == std::string::npos)
+		return false;
+	position = json.find(':', position);
+	if (position == std::string::npos)
+		return false;
+	char* end = nullptr;
+	value = std::strtod(json.c_str() + position + 1, &end);
+	return end != json.c_str() + position + 1;
+};
+
+bool StressHarness::compareWithBaseline(const FrameTimeReport& report)
+{
+	std::ifstream baselineFile(m_config.baselinePath, std::ios::in);
+	if (!baselineFile.good())
+	{
+		LOG_WARNING("STRESS: No baseline found at {}, skipping comparison", m_config.baselinePath);
+		return false;
+	}
+	std::stringstream buffer;
+	buffer << baselineFile.rdbuf();
+	std::string baseline = buffer.str();
+
+	struct Metric { const char* key; double current; };
+	const Metric metrics[] = {
+		{ "mean", report.meanMs },
+		{ "p50", report.p50Ms },
+		{ "p95", report.p95Ms },
+		{ "p99", report.p99Ms },
+	};
+
+	bool regressed = false;
+	for (const Metric& metric : metrics)
+	{
+		double reference = 0.0;
+		if (!readJsonNumber(baseline, metric.key, reference) || reference <= 0.0)
+		{
+			LOG_WARNING("STRESS: Baseline has no value for {}", metric.key);
+			continue;
+		}
+		double limit = reference * (1.0 + m_config.regressionTolerance);
+		std::string line = std::string(metric.key) + ": " + std::to_string(metric.current) + " ms (baseline " + std::to_string(reference) + " ms)";
+		if (metric.current > limit)
+		{
+			regressed = true;
+			LOG_ERROR("STRESS: Regression {}", line);
+		}
+		else
+		{
+			LOG_SUCCES("STRESS: {}", line);
+		}
+	}
+	return regressed;
+};
@@ -0,0 +1,47 @@
+#include "UtilClasses/StringID.h"
+#include "UtilClasses/Logger.h"
+
+#ifndef NDEBUG
+#include <mutex>
+#include <unordered_map>
+
+// id -> name, interned from any thread (workers build names for their log lines and UI)
+static std::mutex& registryMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+static std::unordered_map<uint64_t, std::string>& registry()
+{
+    static std::unordered_map<uint64_t, std::string> names;
+    return names;
+}
+#endif
+
+StringID StringID::intern(std::string_view name)
+{
+    StringID id(name);
+#ifndef NDEBUG
+    std::lock_guard<std::mutex> lock(registryMutex());
+    auto inserted = registry().emplace(id.value(), std::string(name));
+    if (!inserted.second && inserted.first->second != name)
+    {
+        LOG_ERROR("STRINGID: \"{}\" and \"{}\" have the same id {}", inserted.first->second, std::string(name), id.value());
+    }
+#endif
+    return id;
+}
+
+std::string StringID::lookup(StringID id)
+{
+#ifndef NDEBUG
+    {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        auto it = registry().find(id.value());
+        if (it != registry().end())
+            return it->second;
+    }
+#endif
+    return "#" + std::to_string(id.value());
+}
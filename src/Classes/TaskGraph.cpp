@@ -0,0 +1,97 @@
+#include "UtilClasses/TaskGraph.h"
+
+#include <cassert>
+#include <chrono>
+#include <thread>
+
+#include "UtilClasses/JobSystem.h"
+#include "UtilClasses/AllocationTracker.h"
+
+TaskId TaskGraph::add(std::string name, std::function<void()> function, std::initializer_list<TaskId> dependsOn, TaskAffinity affinity)
+{
+    TaskId id = (TaskId)m_tasks.size();
+    auto task = std::make_unique<Task>();
+    task->name = std::move(name);
+    task->function = std::move(function);
+    task->affinity = affinity;
+    task->zone = AllocationTracker::registerZone(task->name.c_str());
+    task->dependencyCount = (uint32_t)dependsOn.size();
+    for (TaskId dependency : dependsOn)
+    {
+        // only tasks that already exist can be depended on, so the graph can't contain a cycle
+        assert(dependency < id && "a task can only depend on tasks added before it");
+        m_tasks[dependency]->dependents.push_back(id);
+    }
+    m_tasks.push_back(std::move(task));
+    return id;
+};
+
+void TaskGraph::clear()
+{
+    m_tasks.clear();
+};
+
+void TaskGraph::execute()
+{
+    JobSystem& jobs = JobSystem::getInstance();
+    assert((jobs.workerCount() == 0 || jobs.isMainThread()) && "TaskGraph::execute has to run on the main thread");
+
+    m_unfinished = (uint32_t)m_tasks.size();
+    for (auto& task : m_tasks)
+    {
+        task->waitingFor = task->dependencyCount;
+    }
+    for (TaskId id = 0; id < m_tasks.size(); id++)
+    {
+        if (m_tasks[id]->dependencyCount == 0)
+            schedule(id);
+    }
+
+    while (m_unfinished.load(std::memory_order_acquire) > 0)
+    {
+        TaskId ready = (TaskId)-1;
+        {
+            std::lock_guard<std::mutex> lock(m_mainThreadMutex);
+            if (!m_mainThreadReady.empty())
+            {
+                ready = m_mainThreadReady.back();
+                m_mainThreadReady.pop_back();
+            }
+        }
+        if (ready != (TaskId)-1)
+            runTask(ready);
+        // no GL work to do yet, help the workers instead of idling
+        else if (!jobs.runPendingJob())
+            std::this_thread::yield();
+    }
+};
+
+void TaskGraph::schedule(TaskId id)
+{
+    if (m_tasks[id]->affinity == TaskAffinity::MAIN_THREAD)
+    {
+        std::lock_guard<std::mutex> lock(m_mainThreadMutex);
+        m_mainThreadReady.push_back(id);
+        return;
+    }
+    JobSystem::getInstance().run([this, id]() { runTask(id); });
+};
+
+void TaskGraph::runTask(TaskId id)
+{
+    Task& task = *m_tasks[id];
+    auto start = std::chrono::steady_clock::now();
+    {
+        ProfileZone zone(task.zone);
+        task.function();
+    }
+    task.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    for (TaskId dependent : task.dependents)
+    {
+        // the last dependency to finish starts the task
+        if (m_tasks[dependent]->waitingFor.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            schedule(dependent);
+    }
+    m_unfinished.fetch_sub(1, std::memory_order_release);
+};
@@ -1,20 +1,37 @@
 #include "ResourceClasses/Texture2D.h"
+#include "UtilClasses/RenderStats.h"
 
 
 #include <iostream>
+#include <string>
+
+// bytes per texel of the internal formats we create textures with
+static size_t bytesPerTexel(unsigned int internalFormat)
+{
+    switch (internalFormat)
+    {
+    case GL_RED: return 1;
+    case GL_RG: return 2;
+    case GL_RGB: return 3;
+    default: return 4;
+    }
+}
 
 Texture2D::Texture2D()
-    : Width(0), Height(0), Internal_Format(GL_RGB), Image_Format(GL_RGB), Wrap_S(GL_REPEAT), Wrap_T(GL_REPEAT), Filter_Min(GL_LINEAR), Filter_Max(GL_LINEAR)
+    : Width(0), Height(0), Internal_Format(GL_RGB), Image_Format(GL_RGB), Wrap_S(GL_REPEAT), Wrap_T(GL_REPEAT), Filter_Min(GL_LINEAR), Filter_Max(GL_LINEAR), Levels(1), BaseLevel(0), ResidencyId(-1)
 {
-    glGenTextures(1, &this->ID);
 }
 
 void Texture2D::Generate(unsigned int width, unsigned int height, unsigned char* data)
 {
     this->Width = width;
     this->Height = height;
+    this->Levels = 1;
+    this->BaseLevel = 0;
     // create Texture
-    glBindTexture(GL_TEXTURE_2D, this->ID);
+    if (!m_texture)
+        m_texture = GLTexture::create();
+    glBindTexture(GL_TEXTURE_2D, m_texture.get());
     glTexImage2D(GL_TEXTURE_2D, 0, this->Internal_Format, width, height, 0, this->Image_Format, GL_UNSIGNED_BYTE, data);
     // set Texture wrap and filter modes
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, this->Wrap_S);
@@ -23,9 +40,87 @@ void Texture2D::Generate(unsigned int width, unsigned int height, unsigned char*
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, this->Filter_Max);
     // unbind texture
     glBindTexture(GL_TEXTURE_2D, 0);
+    m_memory.track(MemoryCategory::TEXTURES, "texture " + std::to_string(width) + "x" + std::to_string(height), (size_t)width * height * bytesPerTexel(this->Internal_Format));
 }
 
 void Texture2D::Bind() const
 {
-    glBindTexture(GL_TEXTURE_2D, this->ID);
-}
\ No newline at end of file
+    glBindTexture(GL_TEXTURE_2D, m_texture.get());
+    RenderStats::recordTextureBind();
+}
+unsigned int Texture2D::LevelCount(unsigned int width, unsigned int height)
+{
+    // halved until both sides are 1 pixel
+    unsigned int levels = 1;
+    for (unsigned int size = width > height ? width : height; size > 1; size >>= 1)
+        levels++;
+    return levels;
+}
+
+size_t Texture2D::LevelBytes(unsigned int level) const
+{
+    size_t width = (this->Width >> level) > 0 ? (this->Width >> level) : 1;
+    size_t height = (this->Height >> level) > 0 ? (this->Height >> level) : 1;
+    return width * height * bytesPerTexel(this->Internal_Format);
+}
+
+size_t Texture2D::ResidentBytes() const
+{
+    size_t bytes = 0;
+    for (unsigned int level = this->BaseLevel; level < this->Levels; level++)
+        bytes += LevelBytes(level);
+    return bytes;
+}
+
+void Texture2D::GenerateLevels(unsigned int width, unsigned int height, unsigned int firstLevel, const std::vector<std::vector<unsigned char>>& levels)
+{
+    this->Width = width;
+    this->Height = height;
+    this->Levels = LevelCount(width, height);
+    this->BaseLevel = this->Levels;
+    if (!m_texture)
+        m_texture = GLTexture::create();
+    glBindTexture(GL_TEXTURE_2D, m_texture.get());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, this->Wrap_S);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, this->Wrap_T);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, this->Filter_Min);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, this->Filter_Max);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, this->Levels - 1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    UploadLevels(firstLevel, levels);
+}
+
+void Texture2D::UploadLevels(unsigned int firstLevel, const std::vector<std::vector<unsigned char>>& levels)
+{
+    if (firstLevel >= this->BaseLevel)
+        return;
+    glBindTexture(GL_TEXTURE_2D, m_texture.get());
+    // the rows of the small levels are not 4 byte aligned (RGB, 1 pixel wide, ...)
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (unsigned int level = firstLevel; level < this->BaseLevel && level - firstLevel < levels.size(); level++)
+    {
+        GLsizei width = (this->Width >> level) > 0 ? (this->Width >> level) : 1;
+        GLsizei height = (this->Height >> level) > 0 ? (this->Height >> level) : 1;
+        glTexImage2D(GL_TEXTURE_2D, level, this->Internal_Format, width, height, 0, this->Image_Format, GL_UNSIGNED_BYTE, levels[level - firstLevel].data());
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    // the texture is complete from the base level down, the levels above it are not looked at
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, firstLevel);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    this->BaseLevel = firstLevel;
+    m_memory.track(MemoryCategory::TEXTURES, "texture " + std::to_string(this->Width) + "x" + std::to_string(this->Height), ResidentBytes());
+}
+
+void Texture2D::DropLevels(unsigned int baseLevel)
+{
+    if (baseLevel <= this->BaseLevel || baseLevel >= this->Levels)
+        return;
+    glBindTexture(GL_TEXTURE_2D, m_texture.get());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, baseLevel);
+    // a level re-specified as 0x0 has no storage anymore
+    for (unsigned int level = this->BaseLevel; level < baseLevel; level++)
+        glTexImage2D(GL_TEXTURE_2D, level, this->Internal_Format, 0, 0, 0, this->Image_Format, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    this->BaseLevel = baseLevel;
+    m_memory.track(MemoryCategory::TEXTURES, "texture " + std::to_string(this->Width) + "x" + std::to_string(this->Height), ResidentBytes());
+}
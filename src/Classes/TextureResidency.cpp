@@ -0,0 +1,359 @@
+#include "UtilClasses/TextureResidency.h"
+#include "UtilClasses/MemoryTracker.h"
+#include "UtilClasses/RenderThread.h"
+#include "UtilClasses/RenderStats.h"
+#include "UtilClasses/FlightRecorder.h"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cmath>
+
+TextureResidency& TextureResidency::getInstance()
+{
+    static TextureResidency instance;
+    return instance;
+};
+
+unsigned int TextureResidency::startLevel(unsigned int width, unsigned int height)
+{
+    unsigned int level = 0;
+    for (unsigned int size = std::max(width, height); size > START_SIZE; size >>= 1)
+        level++;
+    return level;
+};
+
+MipLevels TextureResidency::buildLevels(const unsigned char* pixels, unsigned int width, unsigned int height, unsigned int channels,
+    unsigned int firstLevel, unsigned int endLevel)
+{
+    MipLevels result;
+    result.firstLevel = firstLevel;
+    std::vector<unsigned char> current(pixels, pixels + (size_t)width * height * channels);
+    std::vector<unsigned char> next;
+    for (unsigned int level = 0; level < endLevel; level++)
+    {
+        if (level >= firstLevel)
+            result.levels.push_back(current);
+        if (level + 1 == endLevel)
+            break;
+
+        // every pixel of the next level is the average of the (up to) 2x2 pixels it covers
+        unsigned int nextWidth = std::max(width / 2, 1u);
+        unsigned int nextHeight = std::max(height / 2, 1u);
+        next.resize((size_t)nextWidth * nextHeight * channels);
+        for (unsigned int y = 0; y < nextHeight; y++)
+        {
+            unsigned int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+            for (unsigned int x = 0; x < nextWidth; x++)
+            {
+                unsigned int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+                for (unsigned int c = 0; c < channels; c++)
+                {
+                    unsigned int sum = current[((size_t)y0 * width + x0) * channels + c] + current[((size_t)y0 * width + x1) * channels + c]
+                        + current[((size_t)y1 * width + x0) * channels + c] + current[((size_t)y1 * width + x1) * channels + c];
+                    next[((size_t)y * nextWidth + x) * channels + c] = (unsigned char)((sum + 2) / 4);
+                }
+            }
+        }
+        current.swap(next);
+        width = nextWidth;
+        height = nextHeight;
+    }
+    return result;
+};
+
+void TextureResidency::add(TextureHandle handle, const std::string& file, bool alpha)
+{
+    Texture2D* texture = ResourceManager::GetTexture(handle);
+    if (!texture)
+        return;
+
+    // a reload keeps the entry, its loads in flight are for the old file
+    Entry* entry = nullptr;
+    for (size_t i = 0; i < m_entries.size() && !entry; i++)
+    {
+        if (m_entries[i]->handle == handle)
+        {
+            entry = m_entries[i].get();
+            entry->version++;
+            texture->ResidencyId = (int)i;
+        }
+    }
+    if (!entry)
+    {
+        texture->ResidencyId = (int)m_entries.size();
+        m_entries.push_back(std::make_unique<Entry>());
+        entry = m_entries.back().get();
+        entry->handle = handle;
+    }
+    entry->file = file;
+    entry->alpha = alpha;
+    entry->startLevel = texture->BaseLevel;
+    entry->residentLevel = texture->BaseLevel;
+    entry->wanted = NO_REQUEST;
+    entry->lastUsedFrame = m_frame;
+    entry->failed = false;
+};
+
+void TextureResidency::request(const Texture2D& texture, float screenPixels)
+{
+    if (texture.ResidencyId < 0 || (size_t)texture.ResidencyId >= m_entries.size())
+        return;
+    // one texel per pixel: every level halves the texture, so the level is how many times it is bigger than the object
+    float size = (float)std::max(texture.Width, texture.Height);
+    uint32_t level = 0;
+    if (screenPixels < size)
+        level = (uint32_t)std::floor(std::log2(size / std::max(screenPixels, 1.0f)));
+    level = std::min<uint32_t>(level, texture.Levels - 1);
+
+    std::atomic<uint32_t>& requested = m_entries[texture.ResidencyId]->requested;
+    uint32_t current = requested.load(std::memory_order_relaxed);
+    while (level < current && !requested.compare_exchange_weak(current, level, std::memory_order_relaxed))
+    {
+    }
+};
+
+size_t TextureResidency::levelBytes(const Entry& entry, unsigned int firstLevel, unsigned int endLevel)
+{
+    const Texture2D* texture = ResourceManager::GetTexture(entry.handle);
+    size_t bytes = 0;
+    for (unsigned int level = firstLevel; texture && level < endLevel; level++)
+        bytes += texture->LevelBytes(level);
+    return bytes;
+};
+
+size_t TextureResidency::residentBytes()
+{
+    size_t bytes = 0;
+    for (const std::unique_ptr<Entry>& entry : m_entries)
+    {
+        const Texture2D* texture = ResourceManager::GetTexture(entry->handle);
+        if (texture)
+            bytes += levelBytes(*entry, entry->residentLevel, texture->Levels);
+    }
+    return bytes;
+};
+
+void TextureResidency::dropLevels(Entry& entry, unsigned int baseLevel)
+{
+    Texture2D* texture = ResourceManager::GetTexture(entry.handle);
+    if (!texture || baseLevel <= entry.residentLevel)
+        return;
+    m_evicted += baseLevel - entry.residentLevel;
+    entry.residentLevel = baseLevel;
+    // behind the frames that are already queued, they may still sample the dropped levels
+    RenderThread::getInstance().run([texture, baseLevel]() {
+        texture->DropLevels(baseLevel);
+    });
+};
+
+bool TextureResidency::evictOne(uint32_t keepEntry)
+{
+    // the least recently used texture with a level above its start levels, a texture that was used this frame
+    // only gives up levels more detailed than the one it asked for
+    Entry* victim = nullptr;
+    for (uint32_t i = 0; i < (uint32_t)m_entries.size(); i++)
+    {
+        Entry& entry = *m_entries[i];
+        if (i == keepEntry || entry.loading || entry.residentLevel >= entry.startLevel)
+            continue;
+        if (entry.lastUsedFrame == m_frame && entry.residentLevel >= entry.wanted)
+            continue;
+        if (!victim || entry.lastUsedFrame < victim->lastUsedFrame)
+            victim = &entry;
+    }
+    if (!victim)
+        return false;
+    dropLevels(*victim, victim->residentLevel + 1);
+    return true;
+};
+
+void TextureResidency::applyLoads()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_loadMutex);
+        m_applying.swap(m_finishedLoads);
+    }
+    for (Load& load : m_applying)
+    {
+        m_inFlight--;
+        Entry& entry = *m_entries[load.entry];
+        m_pendingBytes -= std::min(m_pendingBytes, levelBytes(entry, load.firstLevel, load.endLevel));
+        // only one load per texture is in flight, even when it was for a version that got reloaded since
+        entry.loading = false;
+        if (load.version != entry.version)
+            continue;
+        if (load.levels.levels.empty())
+        {
+            LOG_WARNING("TEXTURE: Could not stream {} in again", load.file);
+            entry.failed = true;
+            continue;
+        }
+        // the levels right below the new ones were evicted while it loaded, the texture would have a gap
+        Texture2D* texture = ResourceManager::GetTexture(entry.handle);
+        if (!texture || entry.residentLevel != load.endLevel)
+            continue;
+
+        m_streamedIn += load.endLevel - load.firstLevel;
+        entry.residentLevel = load.firstLevel;
+        RenderStats::recordUpload(load.levels.bytes());
+        FlightRecorder::record(FlightEventType::RESOURCE_LOAD, load.file, (double)(load.endLevel - load.firstLevel));
+        std::shared_ptr<MipLevels> levels = std::make_shared<MipLevels>(std::move(load.levels));
+        RenderThread::getInstance().run([texture, levels]() {
+            texture->UploadLevels(levels->firstLevel, levels->levels);
+        });
+    }
+    m_applying.clear();
+};
+
+void TextureResidency::startLoads(size_t budget)
+{
+    while (m_inFlight < MAX_LOADS_IN_FLIGHT)
+    {
+        // the texture used most recently that misses the most levels
+        uint32_t best = NO_REQUEST;
+        for (uint32_t i = 0; i < (uint32_t)m_entries.size(); i++)
+        {
+            const Entry& entry = *m_entries[i];
+            if (entry.loading || entry.failed || entry.wanted >= entry.residentLevel)
+                continue;
+            if (best == NO_REQUEST)
+            {
+                best = i;
+                continue;
+            }
+            const Entry& other = *m_entries[best];
+            if (entry.lastUsedFrame > other.lastUsedFrame
+                || (entry.lastUsedFrame == other.lastUsedFrame && entry.residentLevel - entry.wanted > other.residentLevel - other.wanted))
+                best = i;
+        }
+        if (best == NO_REQUEST)
+            return;
+
+        Entry& entry = *m_entries[best];
+        unsigned int firstLevel = entry.wanted;
+        if (budget > 0)
+        {
+            // room is made by evicting other textures, what doesn't fit anyway is loaded a few levels smaller
+            while (residentBytes() + m_pendingBytes + levelBytes(entry, firstLevel, entry.residentLevel) > budget && evictOne(best))
+            {
+            }
+            while (firstLevel < entry.residentLevel && residentBytes() + m_pendingBytes + levelBytes(entry, firstLevel, entry.residentLevel) > budget)
+                firstLevel++;
+            if (firstLevel == entry.residentLevel)
+            {
+                // it wants more than fits, it only asks again once something changes
+                entry.wanted = entry.residentLevel;
+                continue;
+            }
+        }
+
+        Load load;
+        load.entry = best;
+        load.version = entry.version;
+        load.file = entry.file;
+        load.alpha = entry.alpha;
+        load.firstLevel = firstLevel;
+        load.endLevel = entry.residentLevel;
+        entry.loading = true;
+        m_inFlight++;
+        m_pendingBytes += levelBytes(entry, firstLevel, entry.residentLevel);
+        {
+            std::lock_guard<std::mutex> lock(m_loadMutex);
+            if (!m_loader.joinable())
+            {
+                m_stopLoader = false;
+                m_loader = std::thread(&TextureResidency::loaderLoop, this);
+            }
+            m_queuedLoads.push_back(std::move(load));
+        }
+        m_loadQueued.notify_one();
+    }
+};
+
+void TextureResidency::update()
+{
+    m_frame++;
+    applyLoads();
+
+    for (std::unique_ptr<Entry>& pointer : m_entries)
+    {
+        Entry& entry = *pointer;
+        uint32_t requested = entry.requested.exchange(NO_REQUEST, std::memory_order_relaxed);
+        if (requested != NO_REQUEST)
+        {
+            entry.wanted = requested;
+            entry.lastUsedFrame = m_frame;
+        }
+        else if (m_frame - entry.lastUsedFrame > STREAM_OUT_FRAMES && entry.residentLevel < entry.startLevel && !entry.loading)
+        {
+            // nobody looked at it in a while, it goes back to the levels it was loaded with
+            entry.wanted = NO_REQUEST;
+            dropLevels(entry, entry.startLevel);
+        }
+    }
+
+    // a lowered budget (or levels that were already there) are evicted right away
+    size_t budget = MemoryTracker::getInstance().getStats(MemoryCategory::TEXTURES).budgetBytes;
+    while (budget > 0 && residentBytes() + m_pendingBytes > budget && evictOne(NO_REQUEST))
+    {
+    }
+    startLoads(budget);
+};
+
+void TextureResidency::loaderLoop()
+{
+    while (true)
+    {
+        Load load;
+        {
+            std::unique_lock<std::mutex> lock(m_loadMutex);
+            m_loadQueued.wait(lock, [this]() { return m_stopLoader || !m_queuedLoads.empty(); });
+            if (m_stopLoader)
+                return;
+            load = std::move(m_queuedLoads.front());
+            m_queuedLoads.pop_front();
+        }
+
+        // the whole file is decoded again, the levels we need are built from its full size
+        int width, height, channels;
+        int wantedChannels = load.alpha ? 4 : 3;
+        unsigned char* data = stbi_load(load.file.c_str(), &width, &height, &channels, wantedChannels);
+        if (data)
+        {
+            load.levels = buildLevels(data, (unsigned int)width, (unsigned int)height, (unsigned int)wantedChannels, load.firstLevel, load.endLevel);
+            stbi_image_free(data);
+        }
+
+        std::lock_guard<std::mutex> lock(m_loadMutex);
+        m_finishedLoads.push_back(std::move(load));
+    }
+};
+
+void TextureResidency::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_loadMutex);
+        m_stopLoader = true;
+        m_queuedLoads.clear();
+    }
+    m_loadQueued.notify_one();
+    if (m_loader.joinable())
+        m_loader.join();
+    m_finishedLoads.clear();
+    m_entries.clear();
+    m_inFlight = 0;
+    m_pendingBytes = 0;
+};
+
+TextureResidencyStats TextureResidency::getStats()
+{
+    TextureResidencyStats stats;
+    stats.textures = m_entries.size();
+    stats.residentBytes = residentBytes();
+    stats.budgetBytes = MemoryTracker::getInstance().getStats(MemoryCategory::TEXTURES).budgetBytes;
+    stats.streamedIn = m_streamedIn;
+    stats.evicted = m_evicted;
+    stats.loading = m_inFlight;
+    return stats;
+};
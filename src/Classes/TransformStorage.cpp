@@ -0,0 +1,672 @@
+#include "UtilClasses/TransformStorage.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include "UtilClasses/JobSystem.h"
+
+// the widest instruction set the compiler is allowed to use decides the kernel
+// (MSVC: /arch:AVX2, gcc/clang: -mavx2, see ENGINE_ENABLE_AVX2 in CMakeLists.txt)
+#if defined(__AVX2__)
+#define TRANSFORM_KERNEL_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRANSFORM_KERNEL_SSE
+#include <xmmintrin.h>
+#endif
+
+// raw pointers into the SoA arrays, the kernels only ever see these
+struct TransformArrays {
+    const float* px; const float* py; const float* pz;
+    const float* qx; const float* qy; const float* qz; const float* qw;
+    const float* sx; const float* sy; const float* sz;
+    float* model; // 16 floats per transform, column major like glm::mat4
+};
+
+// model = T * R * S written out per component
+// R is the rotation matrix of the quaternion (the same one glm::mat4_cast builds),
+// multiplying by S on the right scales the columns of R, T only fills in the last column:
+//     | r00*sx  r01*sy  r02*sz  px |
+//     | r10*sx  r11*sy  r12*sz  py |
+//     | r20*sx  r21*sy  r22*sz  pz |
+//     |   0       0       0     1  |
+static void buildMatricesScalar(const TransformArrays& a, size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; i++)
+    {
+        float x = a.qx[i], y = a.qy[i], z = a.qz[i], w = a.qw[i];
+        float xx = x * x, yy = y * y, zz = z * z;
+        float xy = x * y, xz = x * z, yz = y * z;
+        float wx = w * x, wy = w * y, wz = w * z;
+
+        float* m = a.model + i * 16;
+        m[0]  = (1.0f - 2.0f * (yy + zz)) * a.sx[i];
+        m[1]  = (2.0f * (xy + wz)) * a.sx[i];
+        m[2]  = (2.0f * (xz - wy)) * a.sx[i];
+        m[3]  = 0.0f;
+        m[4]  = (2.0f * (xy - wz)) * a.sy[i];
+        m[5]  = (1.0f - 2.0f * (xx + zz)) * a.sy[i];
+        m[6]  = (2.0f * (yz + wx)) * a.sy[i];
+        m[7]  = 0.0f;
+        m[8]  = (2.0f * (xz + wy)) * a.sz[i];
+        m[9]  = (2.0f * (yz - wx)) * a.sz[i];
+        m[10] = (1.0f - 2.0f * (xx + yy)) * a.sz[i];
+        m[11] = 0.0f;
+        m[12] = a.px[i];
+        m[13] = a.py[i];
+        m[14] = a.pz[i];
+        m[15] = 1.0f;
+    }
+};
+
+#if defined(TRANSFORM_KERNEL_SSE)
+// the same math as the scalar version but on 4 transforms at once, each __m128 holds
+// one matrix component of 4 consecutive transforms, a 4x4 transpose turns that back into columns
+static void buildMatrices4(const TransformArrays& a, size_t i)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    __m128 x = _mm_loadu_ps(a.qx + i), y = _mm_loadu_ps(a.qy + i), z = _mm_loadu_ps(a.qz + i), w = _mm_loadu_ps(a.qw + i);
+    __m128 sx = _mm_loadu_ps(a.sx + i), sy = _mm_loadu_ps(a.sy + i), sz = _mm_loadu_ps(a.sz + i);
+
+    __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+    __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+    __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+    __m128 c0[4] = {
+        _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx),
+        _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx),
+        _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx),
+        _mm_setzero_ps(),
+    };
+    __m128 c1[4] = {
+        _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy),
+        _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy),
+        _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy),
+        _mm_setzero_ps(),
+    };
+    __m128 c2[4] = {
+        _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz),
+        _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz),
+        _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz),
+        _mm_setzero_ps(),
+    };
+    __m128 c3[4] = { _mm_loadu_ps(a.px + i), _mm_loadu_ps(a.py + i), _mm_loadu_ps(a.pz + i), one };
+
+    __m128* columns[4] = { c0, c1, c2, c3 };
+    for (int column = 0; column < 4; column++)
+    {
+        __m128* c = columns[column];
+        // after the transpose c[k] holds this column of transform i + k
+        _MM_TRANSPOSE4_PS(c[0], c[1], c[2], c[3]);
+        for (int k = 0; k < 4; k++)
+        {
+            _mm_storeu_ps(a.model + (i + k) * 16 + column * 4, c[k]);
+        }
+    }
+};
+#endif
+
+#if defined(TRANSFORM_KERNEL_AVX2)
+// 8 transforms at once, the transpose works per 128 bit lane: the low halves end up
+// with transforms i..i+3 and the high halves with i+4..i+7
+static void storeColumns8(float* model, size_t i, int column, __m256 a, __m256 b, __m256 c, __m256 d)
+{
+    __m256 t0 = _mm256_unpacklo_ps(a, b);
+    __m256 t1 = _mm256_unpackhi_ps(a, b);
+    __m256 t2 = _mm256_unpacklo_ps(c, d);
+    __m256 t3 = _mm256_unpackhi_ps(c, d);
+    __m256 u[4] = {
+        _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)),
+        _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)),
+        _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)),
+        _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2)),
+    };
+    for (int k = 0; k < 4; k++)
+    {
+        _mm_storeu_ps(model + (i + k) * 16 + column * 4, _mm256_castps256_ps128(u[k]));
+        _mm_storeu_ps(model + (i + k + 4) * 16 + column * 4, _mm256_extractf128_ps(u[k], 1));
+    }
+};
+
+static void buildMatrices8(const TransformArrays& a, size_t i)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 x = _mm256_loadu_ps(a.qx + i), y = _mm256_loadu_ps(a.qy + i), z = _mm256_loadu_ps(a.qz + i), w = _mm256_loadu_ps(a.qw + i);
+    __m256 sx = _mm256_loadu_ps(a.sx + i), sy = _mm256_loadu_ps(a.sy + i), sz = _mm256_loadu_ps(a.sz + i);
+
+    __m256 x2 = _mm256_mul_ps(two, x), y2 = _mm256_mul_ps(two, y), z2 = _mm256_mul_ps(two, z);
+    __m256 xx = _mm256_mul_ps(x2, x), yy = _mm256_mul_ps(y2, y), zz = _mm256_mul_ps(z2, z);
+    __m256 xy = _mm256_mul_ps(x2, y), xz = _mm256_mul_ps(x2, z), yz = _mm256_mul_ps(y2, z);
+    __m256 wx = _mm256_mul_ps(x2, w), wy = _mm256_mul_ps(y2, w), wz = _mm256_mul_ps(z2, w);
+
+    storeColumns8(a.model, i, 0,
+        _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(yy, zz)), sx),
+        _mm256_mul_ps(_mm256_add_ps(xy, wz), sx),
+        _mm256_mul_ps(_mm256_sub_ps(xz, wy), sx),
+        zero);
+    storeColumns8(a.model, i, 1,
+        _mm256_mul_ps(_mm256_sub_ps(xy, wz), sy),
+        _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, zz)), sy),
+        _mm256_mul_ps(_mm256_add_ps(yz, wx), sy),
+        zero);
+    storeColumns8(a.model, i, 2,
+        _mm256_mul_ps(_mm256_add_ps(xz, wy), sz),
+        _mm256_mul_ps(_mm256_sub_ps(yz, wx), sz),
+        _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, yy)), sz),
+        zero);
+    storeColumns8(a.model, i, 3,
+        _mm256_loadu_ps(a.px + i), _mm256_loadu_ps(a.py + i), _mm256_loadu_ps(a.pz + i), one);
+};
+#endif
+
+// both matrices are affine (last row 0 0 0 1), so a quarter of the full 4x4 product can be skipped
+static void multiplyAffine(const glm::mat4& parent, const glm::mat4& local, glm::mat4& out)
+{
+    for (int column = 0; column < 4; column++)
+    {
+        float x = local[column][0], y = local[column][1], z = local[column][2];
+        float w = column == 3 ? 1.0f : 0.0f;
+        for (int row = 0; row < 3; row++)
+        {
+            out[column][row] = parent[0][row] * x + parent[1][row] * y + parent[2][row] * z + parent[3][row] * w;
+        }
+        out[column][3] = w;
+    }
+};
+
+TransformStorage& TransformStorage::getInstance()
+{
+    static TransformStorage instance;
+    return instance;
+};
+
+const char* TransformStorage::kernelName()
+{
+#if defined(TRANSFORM_KERNEL_AVX2)
+    return "avx2";
+#elif defined(TRANSFORM_KERNEL_SSE)
+    return "sse";
+#else
+    return "scalar";
+#endif
+};
+
+template<typename Function>
+void TransformStorage::forEachSlotArray(Function function)
+{
+    function(m_positionX); function(m_positionY); function(m_positionZ);
+    function(m_rotationX); function(m_rotationY); function(m_rotationZ); function(m_rotationW);
+    function(m_scaleX); function(m_scaleY); function(m_scaleZ);
+    function(m_local); function(m_world);
+    function(m_localBounds); function(m_worldBounds);
+    function(m_parentId); function(m_parentSlot); function(m_subtreeSize); function(m_flags);
+    function(m_slotToId);
+};
+
+TransformId TransformStorage::create(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+    TransformId id;
+    if (!m_freeIds.empty())
+    {
+        id = m_freeIds.back();
+        m_freeIds.pop_back();
+        m_idGeneration[id]++;
+    }
+    else
+    {
+        id = (TransformId)m_idToSlot.size();
+        m_idToSlot.push_back(0);
+        m_idGeneration.push_back(0);
+    }
+
+    // a new transform is a root without children, appending it keeps the depth-first order
+    uint32_t slot = (uint32_t)m_slotToId.size();
+    m_idToSlot[id] = slot;
+    m_slotToId.push_back(id);
+
+    m_positionX.push_back(position.x); m_positionY.push_back(position.y); m_positionZ.push_back(position.z);
+    m_rotationX.push_back(rotation.x); m_rotationY.push_back(rotation.y); m_rotationZ.push_back(rotation.z); m_rotationW.push_back(rotation.w);
+    m_scaleX.push_back(scale.x); m_scaleY.push_back(scale.y); m_scaleZ.push_back(scale.z);
+    m_local.push_back(glm::mat4(1.0f));
+    m_world.push_back(glm::mat4(1.0f));
+    m_localBounds.push_back(TransformBounds());
+    m_worldBounds.push_back(TransformBounds());
+    m_parentId.push_back(INVALID_TRANSFORM);
+    m_parentSlot.push_back(-1);
+    m_subtreeSize.push_back(1);
+    m_flags.push_back(0);
+
+    markDirty(slot);
+    return id;
+};
+
+void TransformStorage::destroy(TransformId id)
+{
+    if (id == INVALID_TRANSFORM || id >= m_idToSlot.size())
+        return;
+
+    uint32_t slot = m_idToSlot[id];
+    uint32_t last = (uint32_t)m_slotToId.size() - 1;
+    bool isLeafRoot = m_parentSlot[slot] < 0 && m_subtreeSize[slot] == 1;
+    bool lastIsLeafRoot = m_parentSlot[last] < 0 && m_subtreeSize[last] == 1;
+
+    if (isLeafRoot && lastIsLeafRoot)
+    {
+        // the common case (objects without hierarchy): the last transform moves into the free slot,
+        // a root without children can live anywhere without breaking the depth-first order
+        if (slot != last)
+        {
+            forEachSlotArray([&](auto& array) { array[slot] = array[last]; });
+            m_idToSlot[m_slotToId[slot]] = slot;
+        }
+        forEachSlotArray([](auto& array) { array.pop_back(); });
+    }
+    else
+    {
+        // the direct children now hang below our parent, they stay where they are
+        // because our subtree was already part of our parent's subtree
+        uint32_t end = slot + m_subtreeSize[slot];
+        for (uint32_t child = slot + 1; child < end; child++)
+        {
+            if (m_parentSlot[child] == (int32_t)slot)
+            {
+                m_parentId[child] = m_parentId[slot];
+                // their world matrix changes, rebuilding the local one takes care of that
+                m_flags[child] |= LOCAL_DIRTY;
+            }
+        }
+
+        forEachSlotArray([&](auto& array) { array.erase(array.begin() + slot); });
+        for (uint32_t moved = slot; moved < m_slotToId.size(); moved++)
+        {
+            m_idToSlot[m_slotToId[moved]] = moved;
+        }
+        rebuildLinks(slot);
+
+        for (uint32_t child = slot; child < end - 1; child++)
+        {
+            if (m_flags[child] & LOCAL_DIRTY)
+            {
+                markDirty(child);
+            }
+        }
+    }
+
+    m_idGeneration[id]++;
+    m_freeIds.push_back(id);
+};
+
+bool TransformStorage::setParent(TransformId id, TransformId parent)
+{
+    uint32_t slot = m_idToSlot[id];
+    uint32_t size = m_subtreeSize[slot];
+    if (parent != INVALID_TRANSFORM)
+    {
+        uint32_t parentSlot = m_idToSlot[parent];
+        if (parentSlot >= slot && parentSlot < slot + size)
+            return false;
+    }
+    if (m_parentId[slot] == parent)
+        return true;
+
+    // the subtree becomes the last child of the new parent (or the last root)
+    uint32_t destination = (uint32_t)m_slotToId.size();
+    if (parent != INVALID_TRANSFORM)
+    {
+        uint32_t parentSlot = m_idToSlot[parent];
+        destination = parentSlot + m_subtreeSize[parentSlot];
+    }
+
+    // std::rotate moves [slot, slot + size) in front of "destination" and shifts the slots in between
+    uint32_t newSlot = slot;
+    uint32_t first = slot;
+    if (destination > slot + size)
+    {
+        forEachSlotArray([&](auto& array) { std::rotate(array.begin() + slot, array.begin() + slot + size, array.begin() + destination); });
+        newSlot = destination - size;
+    }
+    else if (destination < slot)
+    {
+        forEachSlotArray([&](auto& array) { std::rotate(array.begin() + destination, array.begin() + slot, array.begin() + slot + size); });
+        newSlot = destination;
+        first = destination;
+    }
+
+    m_parentId[newSlot] = parent;
+    uint32_t last = std::max(slot + size, destination);
+    for (uint32_t moved = first; moved < last && moved < m_slotToId.size(); moved++)
+    {
+        m_idToSlot[m_slotToId[moved]] = moved;
+    }
+    rebuildLinks(first);
+    markDirty(newSlot);
+    return true;
+};
+
+void TransformStorage::rebuildLinks(uint32_t firstSlot)
+{
+    const uint32_t count = (uint32_t)m_slotToId.size();
+    for (uint32_t slot = firstSlot; slot < count; slot++)
+    {
+        m_parentSlot[slot] = m_parentId[slot] == INVALID_TRANSFORM ? -1 : (int32_t)m_idToSlot[m_parentId[slot]];
+    }
+
+    // children come after their parent, so walking backwards adds every subtree to its parent after it is complete
+    std::fill(m_subtreeSize.begin(), m_subtreeSize.end(), 1);
+    for (uint32_t slot = count; slot-- > 0;)
+    {
+        if (m_parentSlot[slot] >= 0)
+        {
+            m_subtreeSize[m_parentSlot[slot]] += m_subtreeSize[slot];
+        }
+    }
+};
+
+TransformId TransformStorage::getParent(TransformId id) const
+{
+    return m_parentId[m_idToSlot[id]];
+};
+
+void TransformStorage::markDirty(uint32_t slot)
+{
+    m_flags[slot] |= LOCAL_DIRTY;
+    // tell every ancestor that it can't skip its subtree, once an ancestor already knows so do all above it
+    int32_t parent = m_parentSlot[slot];
+    while (parent >= 0 && !(m_flags[parent] & SUBTREE_DIRTY))
+    {
+        m_flags[parent] |= SUBTREE_DIRTY;
+        parent = m_parentSlot[parent];
+    }
+    m_anyDirty = true;
+};
+
+void TransformStorage::setPosition(TransformId id, const glm::vec3& position)
+{
+    uint32_t slot = m_idToSlot[id];
+    m_positionX[slot] = position.x;
+    m_positionY[slot] = position.y;
+    m_positionZ[slot] = position.z;
+    markDirty(slot);
+};
+
+void TransformStorage::setRotation(TransformId id, const glm::quat& rotation)
+{
+    uint32_t slot = m_idToSlot[id];
+    m_rotationX[slot] = rotation.x;
+    m_rotationY[slot] = rotation.y;
+    m_rotationZ[slot] = rotation.z;
+    m_rotationW[slot] = rotation.w;
+    markDirty(slot);
+};
+
+void TransformStorage::setScale(TransformId id, const glm::vec3& scale)
+{
+    uint32_t slot = m_idToSlot[id];
+    m_scaleX[slot] = scale.x;
+    m_scaleY[slot] = scale.y;
+    m_scaleZ[slot] = scale.z;
+    markDirty(slot);
+};
+
+void TransformStorage::setLocalBounds(TransformId id, const TransformBounds& bounds)
+{
+    uint32_t slot = m_idToSlot[id];
+    m_localBounds[slot] = bounds;
+    markDirty(slot);
+};
+
+glm::vec3 TransformStorage::getPosition(TransformId id) const
+{
+    uint32_t slot = m_idToSlot[id];
+    return glm::vec3(m_positionX[slot], m_positionY[slot], m_positionZ[slot]);
+};
+
+glm::quat TransformStorage::getRotation(TransformId id) const
+{
+    uint32_t slot = m_idToSlot[id];
+    return glm::quat(m_rotationW[slot], m_rotationX[slot], m_rotationY[slot], m_rotationZ[slot]);
+};
+
+glm::vec3 TransformStorage::getScale(TransformId id) const
+{
+    uint32_t slot = m_idToSlot[id];
+    return glm::vec3(m_scaleX[slot], m_scaleY[slot], m_scaleZ[slot]);
+};
+
+const glm::mat4& TransformStorage::getModel(TransformId id) const
+{
+    return m_world[m_idToSlot[id]];
+};
+
+const glm::mat4& TransformStorage::getLocal(TransformId id) const
+{
+    uint32_t slot = m_idToSlot[id];
+    return m_parentSlot[slot] < 0 ? m_world[slot] : m_local[slot];
+};
+
+const TransformBounds& TransformStorage::getWorldBounds(TransformId id) const
+{
+    return m_worldBounds[m_idToSlot[id]];
+};
+
+// transforming the 8 corners would work too, but the box only needs its center moved and its
+// half size projected onto the world axes (Arvo, "Transforming Axis-Aligned Bounding Boxes", Graphics Gems 1990)
+void TransformStorage::updateWorldBounds(uint32_t slot)
+{
+    const TransformBounds& local = m_localBounds[slot];
+    TransformBounds& world = m_worldBounds[slot];
+    if (!local.valid())
+    {
+        world = TransformBounds();
+        return;
+    }
+
+    const glm::mat4& m = m_world[slot];
+    glm::vec3 center = (local.min + local.max) * 0.5f;
+    glm::vec3 extent = (local.max - local.min) * 0.5f;
+    for (int row = 0; row < 3; row++)
+    {
+        float worldCenter = m[0][row] * center.x + m[1][row] * center.y + m[2][row] * center.z + m[3][row];
+        float worldExtent = std::fabs(m[0][row]) * extent.x + std::fabs(m[1][row]) * extent.y + std::fabs(m[2][row]) * extent.z;
+        world.min[row] = worldCenter - worldExtent;
+        world.max[row] = worldCenter + worldExtent;
+    }
+};
+
+void TransformStorage::rootBoundaries(size_t ranges, std::vector<size_t>& boundaries) const
+{
+    // evenly spaced cuts, each one moved forward to the next root so no subtree is ever split
+    const size_t count = m_slotToId.size();
+    boundaries.clear();
+    boundaries.push_back(0);
+    for (size_t r = 1; r < ranges; r++)
+    {
+        size_t cut = std::max(count * r / ranges, boundaries.back());
+        if (cut >= count)
+            break;
+        // the root of the subtree the cut falls into, the next root is right after that subtree
+        size_t root = cut;
+        while (m_parentSlot[root] >= 0)
+        {
+            root = (size_t)m_parentSlot[root];
+        }
+        if (root != cut)
+            cut = root + m_subtreeSize[root];
+        if (cut > boundaries.back() && cut < count)
+            boundaries.push_back(cut);
+    }
+    boundaries.push_back(count);
+};
+
+size_t TransformStorage::updateWorldRange(size_t begin, size_t end)
+{
+    size_t rebuilt = 0;
+    size_t firstVisited = end;
+    size_t lastVisited = begin;
+    size_t slot = begin;
+    while (slot < end)
+    {
+        uint8_t flags = m_flags[slot];
+        int32_t parent = m_parentSlot[slot];
+        bool parentChanged = parent >= 0 && (m_flags[parent] & WORLD_CHANGED);
+        if (!parentChanged && !(flags & (LOCAL_DIRTY | SUBTREE_DIRTY)))
+        {
+            // nothing in here changed, jump over the whole subtree
+            slot += m_subtreeSize[slot];
+            continue;
+        }
+
+        if (parentChanged || (flags & LOCAL_DIRTY))
+        {
+            if (parent >= 0)
+            {
+                if (flags & LOCAL_DIRTY)
+                    m_local[slot] = m_world[slot];
+                multiplyAffine(m_world[parent], m_local[slot], m_world[slot]);
+            }
+            updateWorldBounds((uint32_t)slot);
+            m_flags[slot] |= WORLD_CHANGED;
+            rebuilt++;
+        }
+        firstVisited = std::min(firstVisited, slot);
+        lastVisited = slot;
+        slot++;
+    }
+
+    // every slot with flags was visited (an ancestor of a dirty slot is never skipped),
+    // so clearing the visited range resets all of them
+    if (firstVisited < end)
+    {
+        std::memset(m_flags.data() + firstVisited, 0, lastVisited - firstVisited + 1);
+    }
+    return rebuilt;
+};
+
+size_t TransformStorage::updateModelMatrices()
+{
+    m_lastUpdateMs = 0.0;
+    if (!m_anyDirty || m_slotToId.empty())
+        return 0;
+
+    auto start = std::chrono::steady_clock::now();
+    const size_t count = m_slotToId.size();
+
+    // 1) local matrices ==========================================
+    // the kernels write straight into m_world: for a root the local matrix already is the world matrix
+    // (most objects have no parent, so this saves copying every matrix), a child moves it to m_local below
+    TransformArrays arrays{
+        m_positionX.data(), m_positionY.data(), m_positionZ.data(),
+        m_rotationX.data(), m_rotationY.data(), m_rotationZ.data(), m_rotationW.data(),
+        m_scaleX.data(), m_scaleY.data(), m_scaleZ.data(),
+        &m_world[0][0][0],
+    };
+
+#if defined(TRANSFORM_KERNEL_AVX2)
+    const size_t width = 8;
+#elif defined(TRANSFORM_KERNEL_SSE)
+    const size_t width = 4;
+#else
+    const size_t width = 1;
+#endif
+
+    // the flags are checked 8 at a time (one 64 bit load), a group of "width" transforms with
+    // at least one dirty transform is rebuilt completely (rebuilding a clean neighbour gives the
+    // same matrix, that's cheaper than branching per transform)
+    // the groups of 8 are spread over the JobSystem threads, every thread only writes its own slots
+    const uint64_t localDirtyBytes = 0x0101010101010101ull * LOCAL_DIRTY;
+    const size_t groups = count / 8;
+    JobSystem& jobs = JobSystem::getInstance();
+    if (m_threadCleanChildren.size() < jobs.threadCount())
+        m_threadCleanChildren.resize(jobs.threadCount());
+    for (auto& found : m_threadCleanChildren)
+    {
+        found.clear();
+    }
+    jobs.parallelFor(groups, 1024, [&](size_t firstGroup, size_t lastGroup) {
+        std::vector<uint32_t>& found = m_threadCleanChildren[jobs.threadIndex()];
+        for (size_t chunk = firstGroup * 8; chunk < lastGroup * 8; chunk += 8)
+        {
+            uint64_t flags;
+            std::memcpy(&flags, m_flags.data() + chunk, sizeof(flags));
+            if ((flags & localDirtyBytes) == 0)
+                continue;
+
+            for (size_t i = chunk; i < chunk + 8; i += width)
+            {
+                bool dirty = false;
+                for (size_t k = i; k < i + width; k++)
+                {
+                    dirty |= (m_flags[k] & LOCAL_DIRTY) != 0;
+                }
+                if (!dirty)
+                    continue;
+                // a clean child in the same group gets its world matrix overwritten by its local one,
+                // so it has to take part in the world pass as well (marked after the parallel part,
+                // markDirty also writes the flags of its ancestors which may belong to another thread)
+                for (size_t k = i; k < i + width; k++)
+                {
+                    if (!(m_flags[k] & LOCAL_DIRTY) && m_parentSlot[k] >= 0)
+                        found.push_back((uint32_t)k);
+                }
+#if defined(TRANSFORM_KERNEL_AVX2)
+                buildMatrices8(arrays, i);
+#elif defined(TRANSFORM_KERNEL_SSE)
+                buildMatrices4(arrays, i);
+#else
+                buildMatricesScalar(arrays, i, i + 1);
+#endif
+            }
+        }
+    });
+    // gathered first, markDirty changes the flags the loop above reads
+    m_cleanChildren.clear();
+    for (const auto& found : m_threadCleanChildren)
+    {
+        m_cleanChildren.insert(m_cleanChildren.end(), found.begin(), found.end());
+    }
+    for (uint32_t slot : m_cleanChildren)
+    {
+        markDirty(slot);
+    }
+    // the last few transforms don't fill a whole register
+    for (size_t i = groups * 8; i < count; i++)
+    {
+        if (m_flags[i] & LOCAL_DIRTY)
+        {
+            buildMatricesScalar(arrays, i, i + 1);
+        }
+    }
+
+    // 2) world matrices and bounds ================================
+    // a single pass from front to back, a parent is always finished before its children are visited
+    // different root subtrees never touch each other, so the slots are cut into ranges at root
+    // boundaries and every range gets its own pass
+    rootBoundaries(count < 16384 ? 1 : jobs.threadCount() * 4, m_boundaries);
+    std::atomic<size_t> rebuilt{ 0 };
+    jobs.parallelFor(m_boundaries.size() - 1, 1, [&](size_t firstRange, size_t lastRange) {
+        for (size_t range = firstRange; range < lastRange; range++)
+        {
+            rebuilt += updateWorldRange(m_boundaries[range], m_boundaries[range + 1]);
+        }
+    });
+    m_anyDirty = false;
+
+    m_lastUpdateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return rebuilt.load();
+};
+
+void TransformStorage::copyTo(TransformSnapshot& snapshot) const
+{
+    // plain vector assignments, the snapshot keeps its capacity so after the first copy this is a memcpy
+    snapshot.world = m_world;
+    snapshot.worldBounds = m_worldBounds;
+    snapshot.idToSlot = m_idToSlot;
+    snapshot.slotToId = m_slotToId;
+    snapshot.idGeneration = m_idGeneration;
+};
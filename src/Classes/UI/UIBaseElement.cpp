@@ -1,2 +1,36 @@
 #include "UIBaseElement.h"
 
+#include <unordered_map>
+
+#include "FramePacer.h"
+
+// every living element by id, only used on the main thread (where the UI is built and the events are handled)
+static std::unordered_map<uint32_t, BaseUIElement*>& elements()
+{
+	static std::unordered_map<uint32_t, BaseUIElement*> instance;
+	return instance;
+};
+static uint32_t s_nextId = 1;
+
+BaseUIElement::BaseUIElement()
+	: m_id(s_nextId++)
+{
+	elements()[m_id] = this;
+};
+
+BaseUIElement::~BaseUIElement()
+{
+	elements().erase(m_id);
+};
+
+BaseUIElement* BaseUIElement::find(uint32_t id)
+{
+	auto it = elements().find(id);
+	return it != elements().end() ? it->second : nullptr;
+};
+
+void BaseUIElement::notifyChanged()
+{
+	if (getHandler())
+		UIEventQueue::getInstance().push(UIEvent::uiChanged(m_id, FramePacer::now()));
+};
@@ -10,9 +10,9 @@ void UIButton::render()
 {
 	bool clicked = ImGui::Button(m_label.c_str());
 
-	if (clicked && getHandler())
+	if (clicked)
 	{
-		runHandler();
+		notifyChanged();
 	}
 }
 
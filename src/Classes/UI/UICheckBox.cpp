@@ -9,8 +9,8 @@ UICheckbox::UICheckbox(std::string& label)
 void UICheckbox::render()
 {
     bool checked = ImGui::Checkbox(m_label.c_str(), &m_checked);
-    if (checked && getHandler())
+    if (checked)
     {
-        getHandler()->execute();
+        notifyChanged();
     }
 };
@@ -1,36 +1,62 @@
 #include "UIEventQueue.h"
 
-// !!! depricated !!!
+UIEventQueue& UIEventQueue::getInstance()
+{
+    static UIEventQueue instance;
+    return instance;
+};
 
-//UIEventQueue& UIEventQueue::GetInstance() {
-//    static UIEventQueue instance;
-//    return instance;
-//}
-//
-//void UIEventQueue::Push(const UIEvent& event) {
-//    std::lock_guard<std::mutex> lock(m_mutex);
-//    m_queue.push(event);
-//}
-//
-//bool UIEventQueue::Pop(UIEvent& event) {
-//    std::lock_guard<std::mutex> lock(m_mutex);
-//    if (m_queue.empty()) {
-//        return false;
-//    }
-//    event = m_queue.front();
-//    m_queue.pop();
-//    return true;
-//}
-//
-//bool UIEventQueue::IsEmpty() {
-//    std::lock_guard<std::mutex> lock(m_mutex);
-//    return m_queue.empty();
-//}
-//
-//void UIEventQueue::Clear() {
-//    std::lock_guard<std::mutex> lock(m_mutex);
-//    while (!m_queue.empty())
-//    {
-//        m_queue.pop();
-//    }
-//}
\ No newline at end of file
+UIEventQueue::UIEventQueue()
+{
+    for (uint32_t i = 0; i < CAPACITY; i++)
+    {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+};
+
+bool UIEventQueue::push(const UIEvent& event)
+{
+    uint32_t position = m_tail.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true)
+    {
+        slot = &m_slots[position & (CAPACITY - 1)];
+        uint32_t sequence = slot->sequence.load(std::memory_order_acquire);
+        int32_t difference = (int32_t)(sequence - position);
+        if (difference == 0)
+        {
+            // the slot is free for this position, try to claim the position
+            if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (difference < 0)
+        {
+            // the consumer hasn't emptied this slot since the last lap, the queue is full
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else
+        {
+            // another producer took the position
+            position = m_tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->event = event;
+    slot->sequence.store(position + 1, std::memory_order_release);
+    return true;
+};
+
+bool UIEventQueue::pop(UIEvent& event)
+{
+    Slot& slot = m_slots[m_head & (CAPACITY - 1)];
+    uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if ((int32_t)(sequence - (m_head + 1)) < 0)
+        return false;
+
+    event = slot.event;
+    // free for the producer that gets this slot on the next lap
+    slot.sequence.store(m_head + CAPACITY, std::memory_order_release);
+    m_head++;
+    return true;
+};
@@ -0,0 +1,37 @@
+#include "UIFrameStats.h"
+#include "FrameArena.h"
+#include "AllocationTracker.h"
+
+#include <algorithm>
+
+UIFrameStats::UIFrameStats(const FramePacer* pacer)
+	: m_pacer(pacer)
+{
+
+};
+
+void UIFrameStats::render()
+{
+	const FramePacingStats& stats = m_pacer->getStats();
+	ImGui::Text("%.2f ms (%.1f fps)", stats.smoothedMs, stats.fps);
+	ImGui::Text("last frame %.2f ms, work %.2f ms", stats.frameMs, stats.workMs);
+	ImGui::Text("waited %.2f ms (spun %.2f ms)", stats.waitMs, stats.spinMs);
+	ImGui::Text("jitter %.3f ms", stats.jitterMs);
+	if (stats.stutters > 0)
+		ImGui::Text("stutters %llu (last %.1f ms, %.0f s ago)", (unsigned long long)stats.stutters, stats.lastStutterMs, FramePacer::now() - stats.lastStutterTime);
+	else
+		ImGui::Text("stutters 0");
+	const FrameArenaStats& arena = FrameArena::getInstance().getStats();
+	ImGui::Text("frame arena %.1f KB of %.1f KB", arena.usedBytes / 1024.0, arena.capacityBytes / 1024.0);
+	if (AllocationTracker::isEnabled())
+	{
+		// of the frame before this one, this one is still running
+		const AllocationFrameStats& heap = AllocationTracker::lastFrame();
+		ImGui::Text("heap %llu allocations (%.1f KB)", (unsigned long long)heap.allocations, heap.bytes / 1024.0);
+	}
+
+	// the graph is scaled to twice the average, an even frame rate is a flat line in the middle
+	const std::vector<float>& history = m_pacer->getHistory();
+	float scale = (float)std::max(stats.smoothedMs * 2.0, 1.0);
+	ImGui::PlotLines("frame ms", history.data(), (int)history.size(), (int)m_pacer->getHistoryOffset(), nullptr, 0.0f, scale, ImVec2(0.0f, 60.0f));
+};
@@ -1,8 +1,14 @@
 #include "UIManager.h"
+#include "RenderThread.h"
+#include "UIEventQueue.h"
+#include "FramePacer.h"
 
+#include <cmath>
 
-std::map<std::string, Scene*> UIManager::Scenes;
-std::map<std::string, UIPanel*> UIManager::Panels;
+
+HandlePool<Scene*> UIManager::Scenes;
+std::unordered_map<StringID, SceneHandle> UIManager::SceneIds;
+std::map<StringID, UIPanel*> UIManager::Panels;
 
 void UIManager::Init(GLFWwindow* window)
 {
@@ -34,7 +40,7 @@ void UIManager::Shutdown()
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
-    Logger::succes(MESSAGE("ImGui cleanup complete"));
+    LOG_SUCCES("ImGui cleanup complete");
 };
 
 UIManager::~UIManager()
@@ -50,19 +56,22 @@ UIManager& UIManager::getInstance() {
 // renders the current active Scene and UI interface
 void UIManager::RenderActiveScenes()
 {
-	for (auto scene : Scenes)
-	{
-		if (scene.second->isActive)
+	Scenes.forEach([](SceneHandle handle, Scene* scene) {
+		if (scene->isActive)
 		{
-			scene.second->renderScene();
+			// culling and the draw lists were done by the workers earlier in the frame (see Game::buildFrameGraph)
+			// with a render thread the scene only copies its draws into the frame that thread replays
+			RenderThread& renderThread = RenderThread::getInstance();
+			if (renderThread.isRunning())
+				scene->record(renderThread.recordingFrame().addScene());
+			else
+				scene->submit();
 		}
 		else
 		{
-			Logger::info(
-				MESSAGE("SCENE: " + scene.first + " not rendered")
-			);
+			LOG_TRACE("SCENE: {} not rendered", handle.index);
 		}
-	}
+	});
 };
 
 void UIManager::RenderEngineUI()
@@ -74,7 +83,7 @@ void UIManager::RenderEngineUI()
     // ImGui::GetMainViewport();
 
     // Render all panels
-    for (auto itr : Panels) 
+    for (const auto& itr : Panels) 
     {
         itr.second->render();
     }
@@ -84,7 +93,9 @@ void UIManager::RenderEngineUI()
 void UIManager::StartFrame()
 {
 	// Per-frame setup for ImGui
-	ImGui_ImplOpenGL3_NewFrame();
+	// the GL backend's part runs on the render thread when there is one (see RenderThread::replay)
+	if (!RenderThread::getInstance().isRunning())
+		ImGui_ImplOpenGL3_NewFrame();
 	ImGui_ImplGlfw_NewFrame();
 	ImGui::NewFrame();
 };
@@ -93,24 +104,38 @@ void UIManager::EndFrame()
 {
 	// Render ImGui frame
 	ImGui::Render();
-	ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+	RenderThread& renderThread = RenderThread::getInstance();
+	if (renderThread.isRunning())
+		renderThread.recordingFrame().copyUI(ImGui::GetDrawData());
+	else
+		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+};
+
+SceneHandle UIManager::addScene(Scene* newScene, std::string name)
+{
+	StringID id = StringID::intern(name);
+	SceneHandle handle = findScene(id);
+	if (Scene** existing = Scenes.get(handle))
+		*existing = newScene;
+	else
+		handle = Scenes.add(newScene);
+	SceneIds[id] = handle;
+	return handle;
 };
 
-void UIManager::addScene(Scene* newScene, std::string name)
+SceneHandle UIManager::findScene(StringID name)
 {
-	Scenes[name] = newScene;
+	auto it = SceneIds.find(name);
+	return it != SceneIds.end() ? it->second : SceneHandle();
 };
 
 void UIManager::addUIPanel(UIPanel* newPanel, std::string name)
 {
-    Panels[name] = newPanel;
-    Logger::info(
-        MESSAGE("Added new panel: " + name),
-        TURQUOISE
-    );
+    Panels[StringID::intern(name)] = newPanel;
+    LOG_DEBUG("Added new panel: {}", name);
 };
 
-UIPanel* UIManager::getUIPanel(std::string& name) {
+UIPanel* UIManager::getUIPanel(StringID name) {
     auto it = Panels.find(name);
     if (it != Panels.end()) 
     {
@@ -134,13 +159,13 @@ void UIManager::generateEngineUI()
 
 void UIManager::populateShaderListPanel()
 {
-    UIPanel* shaderPanel = getUIPanel((std::string)"Shaders");
+    UIPanel* shaderPanel = getUIPanel("Shaders"_sid);
 
     if (!shaderPanel)
         return;
     
     std::vector<std::string> shaders;
-    for (auto itr : ResourceManager::Shaders)
+    for (auto itr : ResourceManager::ShaderNames)
     {
         shaders.push_back(itr.first);
     }
@@ -148,10 +173,9 @@ void UIManager::populateShaderListPanel()
     BaseUIElement* select = shaderPanel->addUIElement("shaders", std::make_unique<UISelect>(std::string("current Shaders"), shaders));
     
     select->setHandler([this,select]() {
-        std::string selectedShader = dynamic_cast<UISelect*>(select)->getSelectedOption();
-        auto it = ResourceManager::Shaders.find(selectedShader);
-        if (it != ResourceManager::Shaders.end()) {
-            Shader* shader = &it->second;
+        const std::string& selectedShader = dynamic_cast<UISelect*>(select)->getSelectedOption();
+        Shader* shader = ResourceManager::GetShader(ResourceManager::FindShader(StringID(selectedShader)));
+        if (shader) {
             this->populateShaderInfoPanel(shader, selectedShader);
         }
     });
@@ -159,21 +183,28 @@ void UIManager::populateShaderListPanel()
 
 void UIManager::populateGameObjectListPanel()
 {
-    UIPanel* gameObjectsPanel = getUIPanel((std::string)"GameObjects");
+    UIPanel* gameObjectsPanel = getUIPanel("GameObjects"_sid);
 
     if (!gameObjectsPanel)
         return;
     
+    SceneHandle mainScene = findScene(StringID(STD_SCENE));
+    if (!getScene(mainScene))
+        return;
+
     std::vector<std::string> gameObjects;
-    for (auto itr : *Scenes[STD_SCENE]->getGameObjects())
+    for (auto itr : *getScene(mainScene)->getGameObjects())
     {
         gameObjects.push_back(itr.first);
     }
     BaseUIElement* select = gameObjectsPanel->addUIElement("gameObjects", std::make_unique<UISelect>(std::string("current gameObjects"), gameObjects));
-    select->setHandler([this,select]() {
-        std::string selectedName = dynamic_cast<UISelect*>(select)->getSelectedOption();
+    select->setHandler([this,select,mainScene]() {
+        const std::string& selectedName = dynamic_cast<UISelect*>(select)->getSelectedOption();
 
-        auto& gameObjects = *Scenes[STD_SCENE]->getGameObjects();
+        Scene* scene = getScene(mainScene);
+        if (!scene)
+            return;
+        auto& gameObjects = *scene->getGameObjects();
 
         auto it = gameObjects.find(selectedName);
         if (it != gameObjects.end()) {
@@ -185,30 +216,68 @@ void UIManager::populateGameObjectListPanel()
 
 void UIManager::populateFeaturesPanel()
 {
-    UIPanel* featuresPanel = getUIPanel((std::string)"Features");
+    UIPanel* featuresPanel = getUIPanel("Features"_sid);
 
     if (!featuresPanel)
         return;
     BaseUIElement* select = featuresPanel->addUIElement("ViewMode", std::make_unique<UISelect>(std::string("View mode"), std::vector<std::string>({ "line","fill" })));
     select->setHandler([this,select]() {
+        GLenum mode;
         switch (dynamic_cast<UISelect*>(select)->getSelectedIndex())
         {
         case 0:
-            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+            mode = GL_LINE;
             break;
         case 1:
-            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+            mode = GL_FILL;
             break;
         default:
-            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+            mode = GL_FILL;
             break;
         }
+        // GL state belongs to whichever thread owns the context
+        RenderThread::getInstance().run([mode]() {
+            glPolygonMode(GL_FRONT_AND_BACK, mode);
+        });
+    });
+};
+
+void UIManager::populateFramePacingPanel(FramePacer* pacer)
+{
+    addUIPanel(new UIPanel((std::string)"Frame Pacing"), "FramePacing");
+    UIPanel* pacingPanel = getUIPanel("FramePacing"_sid);
+
+    const double caps[] = { 0.0, 30.0, 60.0, 120.0, 144.0 };
+    BaseUIElement* select = pacingPanel->addUIElement("Cap", std::make_unique<UISelect>(std::string("Frame cap"), std::vector<std::string>({ "off","30 fps","60 fps","120 fps","144 fps" })));
+    // shows the cap the pacer started with (e.g. from --fps)
+    for (int i = 0; i < 5; i++)
+    {
+        if (caps[i] > 0.0 && std::abs(pacer->getTargetFrameTime() - 1000.0 / caps[i]) < 0.01)
+            dynamic_cast<UISelect*>(select)->setSelectedIndex(i);
+    }
+    select->setHandler([pacer, select, caps]() {
+        pacer->setTargetFps(caps[dynamic_cast<UISelect*>(select)->getSelectedIndex()]);
     });
+    pacingPanel->addUIElement("Stats", std::make_unique<UIFrameStats>(pacer));
+};
+
+void UIManager::populateMemoryPanel()
+{
+    addUIPanel(new UIPanel((std::string)"Memory"), "Memory");
+    UIPanel* memoryPanel = getUIPanel("Memory"_sid);
+    memoryPanel->addUIElement("Stats", std::make_unique<UIMemoryStats>());
+};
+
+void UIManager::populateRenderStatsPanel()
+{
+    addUIPanel(new UIPanel((std::string)"Render Stats"), "RenderStats");
+    UIPanel* renderStatsPanel = getUIPanel("RenderStats"_sid);
+    renderStatsPanel->addUIElement("Stats", std::make_unique<UIRenderStats>());
 };
 
 void UIManager::populateGameObjectInfoPanel(GameObject* gameObject,std::string gameObjectName)
 {
-    UIPanel* panel = getUIPanel((std::string)"GameObjectInfo");
+    UIPanel* panel = getUIPanel("GameObjectInfo"_sid);
     if (!panel) 
         return;
 
@@ -270,57 +339,53 @@ void UIManager::populateGameObjectInfoPanel(GameObject* gameObject,std::string g
 
 void UIManager::populateShaderInfoPanel(Shader* shader,std::string shaderName)
 {
-    UIPanel* shaderInfoPanel = getUIPanel((std::string)"ShaderInfo");
+    UIPanel* shaderInfoPanel = getUIPanel("ShaderInfo"_sid);
     if (!shaderInfoPanel)
         return;
     // clear existing UI elements for the old shader
     // before adding new buttons
     shaderInfoPanel->clearUIElements();
-    if (!shader || shader->ID == 0) {
+    if (!shader || shader->getID() == 0) {
         return;
     }
 
     // default button to recompile shaders
     BaseUIElement * button = shaderInfoPanel->addUIElement(std::string("RecompileShaderButton"), std::make_unique<UIButton>(std::string("Recompile Current Shader")));
+    // by name, the Shader this panel shows is replaced by the reload (see Game::handleEvent)
     button->setHandler([=]() {
-        ResourceManager::LoadShader(
-            shader->getVertexSource(),
-            shader->getFragmentSource(),
-            shader->getGeometrySource(),
-            shaderName
-        );
+        UIEventQueue::getInstance().push(UIEvent::shaderReload(shaderName.c_str(), FramePacer::now()));
     });
 
     GLint numUniforms = 0;
     GLint numAttributes = 0;
-    glGetProgramiv(shader->ID, GL_ACTIVE_UNIFORMS, &numUniforms);
-    glGetProgramiv(shader->ID, GL_ACTIVE_ATTRIBUTES, &numAttributes);
-
-
-    char nameBuffer[256]; // Buffer for uniform name
-    GLsizei length;       // Length of uniform name
-    GLint size;           // Size of uniform (e.g., array size)
-    GLenum type;          // Type of uniform (GL_FLOAT, GL_FLOAT_VEC3, etc.)
+    // the program is queried on the thread that owns the context, the UI is built here afterwards
+    std::vector<std::pair<std::string, GLenum>> uniforms;
+    RenderThread::getInstance().runSync([&]() {
+        glGetProgramiv(shader->getID(), GL_ACTIVE_UNIFORMS, &numUniforms);
+        glGetProgramiv(shader->getID(), GL_ACTIVE_ATTRIBUTES, &numAttributes);
+
+        char nameBuffer[256]; // Buffer for uniform name
+        GLsizei length;       // Length of uniform name
+        GLint size;           // Size of uniform (e.g., array size)
+        GLenum type;          // Type of uniform (GL_FLOAT, GL_FLOAT_VEC3, etc.)
+        for (int i = 0; i < numUniforms; ++i) {
+            glGetActiveUniform(shader->getID(), i, sizeof(nameBuffer), &length, &size, &type, nameBuffer);
+            uniforms.push_back({ std::string(nameBuffer, length), type });
+        }
+    });
 
-    Logger::info(
-        MESSAGE("Number of uniforms active in shader program " + std::to_string(numUniforms))
-    );
-    Logger::info(
-        MESSAGE("Number of attributes active in shader program " + std::to_string(numAttributes))
-    );
+    LOG_INFO("Number of uniforms active in shader program {}", numUniforms);
+    LOG_INFO("Number of attributes active in shader program {}", numAttributes);
 
-    for (int i = 0; i < numUniforms; ++i) {
-        glGetActiveUniform(shader->ID, i, sizeof(nameBuffer), &length, &size, &type, nameBuffer);
-        std::string uniformName(nameBuffer, length);
+    for (auto& uniform : uniforms) {
+        std::string uniformName = uniform.first;
+        GLenum type = uniform.second;
 
         // Filter out built-in uniforms or matrices you handle separately (model, view, projection)
         // can't think of way we want to change it
         if (uniformName.rfind("gl_", 0) == 0 ||uniformName == "model" || uniformName == "view" || uniformName == "projection" || uniformName.find("[") != std::string::npos) 
         {
-            Logger::info(
-                MESSAGE("Skipped uniform:  " + uniformName),
-                TURQUOISE
-            );
+            LOG_DEBUG("Skipped uniform:  {}", uniformName);
             continue;
         }
 
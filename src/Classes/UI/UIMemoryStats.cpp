@@ -0,0 +1,90 @@
+#include "UIMemoryStats.h"
+#include "GLObject.h"
+#include "GpuBufferArena.h"
+#include "TextureResidency.h"
+
+#include <cstdio>
+#include <cstring>
+
+static const double MEGABYTE = 1024.0 * 1024.0;
+static const ImVec4 OVER_BUDGET_COLOR = ImVec4(1.0f, 0.35f, 0.3f, 1.0f);
+
+UIMemoryStats::UIMemoryStats()
+{
+
+};
+
+// "12.3 MB" or "12.3 of 256.0 MB", red when over budget
+static void renderUsage(const char* name, size_t bytes, size_t peakBytes, size_t budgetBytes, size_t count)
+{
+	char line[128];
+	if (budgetBytes > 0)
+		std::snprintf(line, sizeof(line), "%-13s %8.2f of %.1f MB (peak %.2f MB, %zu)", name, bytes / MEGABYTE, budgetBytes / MEGABYTE, peakBytes / MEGABYTE, count);
+	else
+		std::snprintf(line, sizeof(line), "%-13s %8.2f MB (peak %.2f MB, %zu)", name, bytes / MEGABYTE, peakBytes / MEGABYTE, count);
+	if (budgetBytes > 0 && bytes > budgetBytes)
+		ImGui::TextColored(OVER_BUDGET_COLOR, "%s", line);
+	else
+		ImGui::TextUnformatted(line);
+};
+
+void UIMemoryStats::render()
+{
+	MemoryTracker& tracker = MemoryTracker::getInstance();
+
+	size_t gpuBytes = tracker.getGpuBytes(), gpuBudget = tracker.getGpuBudget();
+	size_t cpuBytes = tracker.getCpuBytes(), cpuBudget = tracker.getCpuBudget();
+	ImGui::Text("GPU %.2f MB%s", gpuBytes / MEGABYTE, gpuBudget > 0 && gpuBytes > gpuBudget ? " (over budget)" : "");
+	ImGui::Text("CPU %.2f MB%s", cpuBytes / MEGABYTE, cpuBudget > 0 && cpuBytes > cpuBudget ? " (over budget)" : "");
+	ImGui::Separator();
+	for (size_t c = 0; c < (size_t)MemoryCategory::COUNT; c++)
+	{
+		MemoryCategoryStats stats = tracker.getStats((MemoryCategory)c);
+		renderUsage(stats.name, stats.bytes, stats.peakBytes, stats.budgetBytes, stats.records);
+	}
+
+	// names that were handed out and never given back, a number that keeps growing is a leak
+	GLNamePoolStats names = GLNamePool::getInstance().getStats();
+	ImGui::Text("GL objects alive %llu (%zu waiting to be deleted)", (unsigned long long)(names.acquired - names.released), names.pendingDeletes);
+
+	// a high fragmentation with a small largest block means new meshes end up in a new arena
+	GpuBufferArenaStats arenas = GpuBufferArenas::getInstance().getStats();
+	ImGui::Text("mesh arenas %zu: %.2f of %.2f MB, %zu meshes", arenas.arenas, arenas.usedBytes / MEGABYTE, arenas.capacityBytes / MEGABYTE, arenas.meshes);
+	ImGui::Text("  fragmentation %.0f%% (%zu holes, largest %.2f MB), %llu moves (%.2f MB)", arenas.fragmentation * 100.0f, arenas.freeBlocks,
+		arenas.largestFreeBytes / MEGABYTE, (unsigned long long)arenas.moves, arenas.movedBytes / MEGABYTE);
+
+	// streamed textures: what their resident mip levels take against the textures budget
+	TextureResidencyStats residency = TextureResidency::getInstance().getStats();
+	ImGui::Text("streamed textures %zu: %.2f MB resident, %llu levels in, %llu evicted, %zu loading", residency.textures, residency.residentBytes / MEGABYTE,
+		(unsigned long long)residency.streamedIn, (unsigned long long)residency.evicted, residency.loading);
+
+	if (ImGui::CollapsingHeader("largest resources"))
+		renderLargest();
+};
+
+void UIMemoryStats::renderLargest()
+{
+	// a fixed array instead of a sorted copy of all records, the panel shouldn't allocate every frame
+	struct Entry {
+		size_t bytes;
+		MemoryCategory category;
+		char label[48];
+	};
+	Entry largest[LARGEST];
+	int count = 0;
+	MemoryTracker::getInstance().forEachRecord([&largest, &count](const MemoryRecord& record) {
+		if (count == LARGEST && record.bytes <= largest[count - 1].bytes)
+			return;
+		int position = count < LARGEST ? count++ : LARGEST - 1;
+		while (position > 0 && largest[position - 1].bytes < record.bytes)
+		{
+			largest[position] = largest[position - 1];
+			position--;
+		}
+		largest[position].bytes = record.bytes;
+		largest[position].category = record.category;
+		std::snprintf(largest[position].label, sizeof(largest[position].label), "%s", record.label.c_str());
+	});
+	for (int i = 0; i < count; i++)
+		ImGui::Text("%8.2f MB  %-12s %s", largest[i].bytes / MEGABYTE, MemoryTracker::categoryName(largest[i].category), largest[i].label);
+};
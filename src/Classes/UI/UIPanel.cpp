@@ -20,60 +20,54 @@ void UIPanel::render()
 BaseUIElement*  UIPanel::addUIElement(std::string name, std::unique_ptr<BaseUIElement> element)
 {
     auto* ptr = element.get();
-    m_UIElements[name] = std::move(element);
-    Logger::info(
-        MESSAGE(m_label + ": Added new element \"" + name +"\""),
-        TURQUOISE
-    );
+    StringID id = StringID::intern(name);
+    for (auto& entry : m_UIElements)
+    {
+        if (entry.first == id)
+        {
+            entry.second = std::move(element);
+            return ptr;
+        }
+    }
+    m_UIElements.emplace_back(id, std::move(element));
+    LOG_DEBUG("{}: Added new element \"{}\"", m_label, name);
     return ptr;
 };
 
 void UIPanel::clearUIElements()
 {
-    Logger::info(
-        MESSAGE(m_label + ": Clearing elements"),
-        TURQUOISE
-    );
+    LOG_DEBUG("{}: Clearing elements", m_label);
     m_UIElements.clear(); // unique_ptr automatically call destructors
 };
 
-UIButton* UIPanel::getButton(std::string& name)
+BaseUIElement* UIPanel::getUIElement(StringID name)
 {
-    auto it = m_UIElements.find(name);
-    if (it != m_UIElements.end()) {
-        return dynamic_cast<UIButton*>(it->second.get());
+    // a panel has a handful of elements, a linear search over the ids beats any map here
+    for (auto& entry : m_UIElements)
+    {
+        if (entry.first == name)
+            return entry.second.get();
     }
     return nullptr;
-}
-UISliderFloat* UIPanel::getSliderFloat(std::string& name)
+};
+
+UIButton* UIPanel::getButton(StringID name)
 {
-    auto it = m_UIElements.find(name);
-    if (it != m_UIElements.end()) {
-        return dynamic_cast<UISliderFloat*>(it->second.get());
-    }
-    return nullptr;
+    return dynamic_cast<UIButton*>(getUIElement(name));
 };
-UISliderVec3* UIPanel::getSliderVec3(std::string& name)
+UISliderFloat* UIPanel::getSliderFloat(StringID name)
 {
-    auto it = m_UIElements.find(name);
-    if (it != m_UIElements.end()) {
-        return dynamic_cast<UISliderVec3*>(it->second.get());
-    }
-    return nullptr;
+    return dynamic_cast<UISliderFloat*>(getUIElement(name));
 };
-UISelect* UIPanel::getSelect(std::string& name)
+UISliderVec3* UIPanel::getSliderVec3(StringID name)
 {
-    auto it = m_UIElements.find(name);
-    if (it != m_UIElements.end()) {
-        return dynamic_cast<UISelect*>(it->second.get());
-    }
-    return nullptr;
+    return dynamic_cast<UISliderVec3*>(getUIElement(name));
 };
-UILabel* UIPanel::getLabel(std::string& name)
+UISelect* UIPanel::getSelect(StringID name)
 {
-    auto it = m_UIElements.find(name);
-    if (it != m_UIElements.end()) {
-        return dynamic_cast<UILabel*>(it->second.get());
-    }
-    return nullptr;
+    return dynamic_cast<UISelect*>(getUIElement(name));
+};
+UILabel* UIPanel::getLabel(StringID name)
+{
+    return dynamic_cast<UILabel*>(getUIElement(name));
 };
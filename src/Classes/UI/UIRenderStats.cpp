@@ -0,0 +1,35 @@
+#include "UIRenderStats.h"
+
+UIRenderStats::UIRenderStats()
+{
+
+};
+
+void UIRenderStats::render()
+{
+	// of the frame before this one, this one is still recording
+	const FrameRenderStats& stats = RenderStats::last();
+	for (int i = 0; i < (int)RenderCounter::COUNT; i++)
+	{
+		RenderCounter counter = (RenderCounter)i;
+		if (counter == RenderCounter::VERTICES_SUBMITTED)
+		{
+			ImGui::Separator();
+			if (!stats.pipeline.available)
+			{
+				ImGui::TextDisabled("no pipeline statistics queries");
+				break;
+			}
+			// a few frames old, the queries are read once the GPU is done with them
+			ImGui::TextDisabled("counted by the GPU");
+		}
+		ImGui::Text("%-32s %llu", RenderStats::counterName(counter), (unsigned long long)RenderStats::counterValue(stats, counter));
+	}
+	// what the post transform cache and the clipper saved (or didn't)
+	if (stats.pipeline.available && stats.pipeline.verticesSubmitted > 0)
+	{
+		ImGui::Text("vertex shader runs per vertex %.2f", (double)stats.pipeline.vertexShaderInvocations / stats.pipeline.verticesSubmitted);
+		if (stats.pipeline.clippingInputPrimitives > 0)
+			ImGui::Text("primitives past clipping %.1f %%", 100.0 * stats.pipeline.clippingOutputPrimitives / stats.pipeline.clippingInputPrimitives);
+	}
+};
@@ -21,12 +21,13 @@ int UISelect::getSelectedIndex()
     return m_selectedIndex;
 };
 
-std::string UISelect::getSelectedOption()
+const std::string& UISelect::getSelectedOption()
 {
+    static const std::string none;
     if (m_selectedIndex >= 0 && m_selectedIndex < m_options.size()) {
         return m_options[m_selectedIndex];
     }
-    return "";
+    return none;
 };
 
 void UISelect::render()
@@ -54,9 +55,9 @@ void UISelect::render()
         ImGui::EndCombo();
     }
 
-    if (valueChanged && getHandler())
+    if (valueChanged)
     {
-        runHandler();
+        notifyChanged();
     }
 
 }
\ No newline at end of file
@@ -9,9 +9,9 @@ UISliderFloat::UISliderFloat(std::string& label, float initialValue, float min,
 void UISliderFloat::render()
 {
     bool valueChanged = ImGui::SliderFloat(m_label.c_str(), &m_value, m_min, m_max);
-    if (valueChanged && getHandler())
+    if (valueChanged)
     {
-        runHandler();
+        notifyChanged();
     }
 }
 
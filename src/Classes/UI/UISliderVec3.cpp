@@ -10,9 +10,9 @@ UISliderVec3::UISliderVec3(std::string& label, glm::vec3& initialValue, float mi
 void UISliderVec3::render()
 {
     bool valueChanged = ImGui::SliderFloat3(m_label.c_str(), glm::value_ptr(m_value), m_min, m_max);
-    if (valueChanged && getHandler())
+    if (valueChanged)
     {
-        runHandler();
+        notifyChanged();
     }
 }
 
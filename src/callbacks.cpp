@@ -6,15 +6,8 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 	// Retrieve the Game instance associated with this specific window
 	Game* gameInstance = static_cast<Game*>(glfwGetWindowUserPointer(window));
 	if (gameInstance) {
-		// We have to tell OpenGL the size of the rendering window 
-		// so OpenGL knows how we want to display the data and coordinates 
-		// with respect to the window.
-		glViewport(0, 0, width, height);
-		Scene* mainScene = UIManager::Scenes[STD_SCENE];
-		if (mainScene)
-		{
-			mainScene->getCamera()->updateProjection(width, height);
-		}
+		// the viewport and the camera catch up when the frame handles its events (see Game::handleEvent)
+		UIEventQueue::getInstance().push(UIEvent::motionEvent(UIEventType::WINDOW_RESIZED, (float)width, (float)height, FramePacer::now()));
 	}
 };
 
@@ -22,53 +15,8 @@ void keyboard_callback(GLFWwindow* window, int key, int scancode, int action, in
 {
 	Game* gameInstance = static_cast<Game*>(glfwGetWindowUserPointer(window));
 	if (gameInstance) {
-		// when a user presses the escape key, we set the WindowShouldClose property to true, closing the application
-		if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
-		{
-			glfwSetWindowShouldClose(window, true);
-			Logger::info(
-				MESSAGE("ESC pressed")
-			);
-		}
-
-		if (key == GLFW_KEY_1 && action == GLFW_RELEASE)
-		{
-			gameInstance->m_enabledDepthTest = !gameInstance->m_enabledDepthTest;
-			gameInstance->m_enabledDepthTest ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
-			Logger::info(
-				MESSAGE("Changed depth test")
-			);
-		}
-
-		if (key == GLFW_KEY_2 && action == GLFW_RELEASE)
-		{
-			gameInstance->m_enabledCaptureCursor = !gameInstance->m_enabledCaptureCursor;
-			gameInstance->m_enabledCaptureCursor ? glfwSetInputMode(gameInstance->m_gameWindow, GLFW_CURSOR, GLFW_CURSOR_CAPTURED) : glfwSetInputMode(gameInstance->m_gameWindow, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-			Logger::info(
-				MESSAGE("Changed cursor mode")
-			);
-		}
-
-		if (key == GLFW_KEY_3 && action == GLFW_RELEASE)
-		{
-			gameInstance->m_enabledVSync = !gameInstance->m_enabledVSync;
-			gameInstance->m_enabledVSync ? glfwSwapInterval(1) : glfwSwapInterval(0);
-			Logger::info(
-				MESSAGE("Changed v-sync")
-			);
-		}
-
-		if (key >= 0 && key < 1024)
-		{
-			if (action == GLFW_PRESS)
-			{
-				gameInstance->m_keys[key] = true;
-			}
-			else if (action == GLFW_RELEASE)
-			{
-				gameInstance->m_keys[key] = false;
-			}
-		}
+		// what a key does is up to Game::handleKey
+		UIEventQueue::getInstance().push(UIEvent::keyEvent(key, action, FramePacer::now()));
 	}
 };
 
@@ -91,18 +39,10 @@ void cursor_position_callback(GLFWwindow* window, double xpos, double ypos)
 		gameInstance->m_lastY = ypos;
 
 		// process is different based upon (MMB + shift or MMB)
-		Scene* mainScene = UIManager::Scenes[STD_SCENE];
-		if (mainScene)
-		{
-			if (gameInstance->m_keys[GLFW_KEY_LEFT_SHIFT])
-			{
-				mainScene->getCamera()->processPan(xoffset, yoffset);
-			}
-			else
-			{
-				mainScene->getCamera()->processOrbit(xoffset, yoffset);
-			}
-		}
+		// only queued, the frame applies it to the camera as late as it can (see InputLatency)
+		// the key events are queued as well, so shift is asked straight from GLFW
+		UIEventType type = glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS ? UIEventType::CAMERA_PAN : UIEventType::CAMERA_ORBIT;
+		UIEventQueue::getInstance().push(UIEvent::motionEvent(type, xoffset, yoffset, FramePacer::now()));
 	}
 };
 
@@ -111,11 +51,7 @@ void mouse_scroll_callback(GLFWwindow* window, double xoff, double yoff)
 	// a "normal" mouse wheel, being vertical, provides offsets along the Y-axis
 	Game* gameInstance = static_cast<Game*>(glfwGetWindowUserPointer(window));
 	if (gameInstance) {
-		Scene* mainScene = UIManager::Scenes[STD_SCENE];
-		if (mainScene)
-		{
-			mainScene->getCamera()->processZoom(yoff);
-		}
+		UIEventQueue::getInstance().push(UIEvent::motionEvent(UIEventType::CAMERA_ZOOM, 0.0f, (float)yoff, FramePacer::now()));
 	}
 };
 
@@ -4,7 +4,10 @@
 // https://learnopengl.com/Getting-started/Hello-Window
 
 // standard c++ headers ------------
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
+#include <string>
 
 // 3rd party headers ------------
 // GLAD manages OpenGL function pointers
@@ -20,6 +23,13 @@
 #include "Sphere.h"
 #include "Axis.h"
 #include "Logger.h"
+#include "StressScene.h"
+#include "JobSystem.h"
+#include "RenderThread.h"
+#include "AllocationTracker.h"
+#include "MemoryTracker.h"
+#include "GLDebug.h"
+#include "FlightRecorder.h"
 
 #include "config.h"
 
@@ -28,21 +38,140 @@ using namespace std;
 /* Function declarations */
 void bootUp(Scene&,Camera&);
 
-int main(void) 
+int main(int argc, char** argv) 
 {
+	// --log-file=<path> mirrors all log messages into a rotating log file
+	// --log-level=<trace|debug|info|succes|warning|error> hides everything below that level
+	// --jobs=N runs the frame on N threads (the main thread + N-1 workers), one per core by default
+	// --sim-rate=N moves the game logic to a simulation thread running N fixed ticks per second
+	// --render-thread=1 moves every GL call to a render thread that draws frame N while frame N+1 is built
+	// --fps=N caps the frame rate at N frames per second (on top of v-sync), uncapped by default
+	// --alloc-check=1 counts every heap allocation per frame and per zone (see AllocationTracker),
+	//                 a stress run then fails if a measured frame allocates anything
+	// --memory-budget=<category>:<MB> warns when meshes/textures/programs/object-pools/frame-arena/other or
+	//                                 all gpu/cpu memory goes over the budget (can be given more than once)
+	// --memory-report=<path> writes what the MemoryTracker counted as JSON at exit
+	// --latency=1 logs the time from mouse input until the frame that used it was swapped (see InputLatency)
+	// --gl-debug=1 creates a debug context and logs the driver's errors and performance warnings (see GLDebug)
+	// --flight-recorder=<path> is where the last few seconds of events are written on a crash or F9 (see FlightRecorder)
+	float simulationRate = 0.0f;
+	bool renderThread = false;
+	double fpsCap = 0.0;
+	bool measureLatency = false;
+	std::string memoryReport;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument(argv[i]);
+		if (argument.rfind("--log-file=", 0) == 0)
+		{
+			Logger::addFileSink(argument.substr(std::string("--log-file=").size()));
+		}
+		else if (argument.rfind("--log-level=", 0) == 0)
+		{
+			const char* levels[] = { "trace", "debug", "info", "succes", "warning", "error" };
+			std::string level = argument.substr(std::string("--log-level=").size());
+			for (int l = 0; l < 6; l++)
+			{
+				if (level == levels[l])
+					Logger::setLevel((LogLevel)l);
+			}
+		}
+		else if (argument.rfind("--jobs=", 0) == 0)
+		{
+			int threads = std::atoi(argument.substr(std::string("--jobs=").size()).c_str());
+			JobSystem::getInstance().start((size_t)std::max(1, threads) - 1);
+		}
+		else if (argument.rfind("--sim-rate=", 0) == 0)
+		{
+			simulationRate = (float)std::atof(argument.substr(std::string("--sim-rate=").size()).c_str());
+		}
+		else if (argument.rfind("--fps=", 0) == 0)
+		{
+			fpsCap = std::atof(argument.substr(std::string("--fps=").size()).c_str());
+		}
+		else if (argument.rfind("--latency=", 0) == 0)
+		{
+			measureLatency = argument.substr(std::string("--latency=").size()) != "0";
+		}
+		else if (argument.rfind("--alloc-check=", 0) == 0)
+		{
+			AllocationTracker::setEnabled(argument.substr(std::string("--alloc-check=").size()) != "0");
+		}
+		else if (argument.rfind("--memory-budget=", 0) == 0)
+		{
+			std::string budget = argument.substr(std::string("--memory-budget=").size());
+			if (!MemoryTracker::getInstance().parseBudget(budget))
+				LOG_WARNING("Unknown memory budget {}", budget);
+		}
+		else if (argument.rfind("--memory-report=", 0) == 0)
+		{
+			memoryReport = argument.substr(std::string("--memory-report=").size());
+		}
+		else if (argument.rfind("--render-thread=", 0) == 0)
+		{
+			renderThread = argument.substr(std::string("--render-thread=").size()) != "0";
+		}
+		else if (argument.rfind("--flight-recorder=", 0) == 0)
+		{
+			FlightRecorder::setDumpPath(argument.substr(std::string("--flight-recorder=").size()));
+		}
+		else if (argument.rfind("--gl-debug=", 0) == 0)
+		{
+			GLDebug::getInstance().setRequested(argument.substr(std::string("--gl-debug=").size()) != "0");
+		}
+	}
+
+	// a crash flushes the log and writes the flight recorder's events before the process goes down
+	FlightRecorder::installCrashHandlers();
+
+	// a stress run replaces the hand made scene with a generated one and 
+	// exits with the result of the run (see StressHarness::run)
+	bool stressRun = StressSceneConfig::requested(argc, argv);
+
 	// 1) create a Game instance first before calling any other class because 
 	// Game initializes "glfw" 
-	Game game = Game(WINDOW_STD_WIDTH, WINDOW_STD_HEIGHT, WINDOW_STD_NAME);
+	Game game = Game(WINDOW_STD_WIDTH, WINDOW_STD_HEIGHT, WINDOW_STD_NAME, stressRun);
+	game.m_inputLatency.setEnabled(measureLatency);
+	// from here on GL work goes through the RenderThread (meshes, shaders, ...), started or not
+	if (renderThread)
+	{
+		RenderThread::getInstance().start(game.m_gameWindow);
+	}
 	Camera camera = Camera();
 	Scene mainScene = Scene();
 
+	if (stressRun)
+	{
+		UIManager::getInstance().addScene(&mainScene, STD_SCENE);
+		StressHarness harness(StressSceneConfig::fromArgs(argc, argv));
+		int result = harness.run(game, mainScene, camera);
+		if (!memoryReport.empty())
+			MemoryTracker::getInstance().writeJson(memoryReport);
+		return result;
+	}
+
 	bootUp(mainScene,camera);
+	if (fpsCap > 0.0)
+	{
+		game.getFramePacer().setTargetFps(fpsCap);
+	}
 	
 	UIManager::getInstance().addScene(&mainScene, STD_SCENE);
+
+	if (simulationRate > 0.0f)
+	{
+		game.getSimulation().setTickRate(simulationRate);
+		game.getSimulation().start();
+	}
 	
 	game.Run();
+	// the simulation may still be moving the scene's objects, stop it before they go away
+	game.getSimulation().stop();
+	if (!memoryReport.empty())
+		MemoryTracker::getInstance().writeJson(memoryReport);
 	
-	Logger::info(MESSAGE("Program shutdown..."));
+	LOG_INFO("Program shutdown...");
+	Logger::flush();
 	return 0;
 }
 